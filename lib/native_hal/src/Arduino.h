@@ -0,0 +1,96 @@
+#ifndef NATIVE_HAL_ARDUINO_H
+#define NATIVE_HAL_ARDUINO_H
+
+/**
+ * 主机端 Arduino 核心接口（仅实现分拣核心用到的部分）
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#define LOW     0x0
+#define HIGH    0x1
+
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define PULLUP          0x04
+#define INPUT_PULLUP    0x05
+#define PULLDOWN        0x08
+#define INPUT_PULLDOWN  0x09
+
+#define RISING    0x01
+#define FALLING   0x02
+#define CHANGE    0x03
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef int gpio_num_t;
+
+using std::min;
+using std::max;
+
+template <typename T>
+inline T constrain(T value, T low, T high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+uint32_t getCpuFrequencyMhz();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+int gpio_get_level(gpio_num_t pin);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+/**
+ * 最小化的 Arduino String（仅用于全局名称等少量场合）
+ */
+class String {
+private:
+    std::string value;
+
+public:
+    String() {}
+    String(const char* s) : value(s ? s : "") {}
+    String(const std::string& s) : value(s) {}
+    explicit String(int v) : value(std::to_string(v)) {}
+    explicit String(unsigned int v) : value(std::to_string(v)) {}
+    explicit String(long v) : value(std::to_string(v)) {}
+    explicit String(unsigned long v) : value(std::to_string(v)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return (unsigned int)value.size(); }
+
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String operator+(const String& other) const { return String(value + other.value); }
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator!=(const String& other) const { return value != other.value; }
+};
+
+#include "HardwareSerial.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+#endif // NATIVE_HAL_ARDUINO_H
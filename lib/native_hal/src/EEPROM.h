@@ -0,0 +1,45 @@
+#ifndef NATIVE_HAL_EEPROM_H
+#define NATIVE_HAL_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * 主机端 EEPROM：内存数组，上电 (NativeHal::reset) 时全部为 0xFF
+ * 越界访问与 ESP32 实现一致：读返回 0，写被忽略。
+ */
+class EEPROMClass {
+public:
+    static const int CAPACITY = 4096;
+
+    EEPROMClass();
+
+    bool begin(size_t size);
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    bool commit() { return true; }
+    uint16_t length() const { return (uint16_t)size; }
+
+    // 恢复出厂状态（全部 0xFF）
+    void erase();
+
+    template <typename T>
+    T& get(int address, T& t) {
+        if (address >= 0 && address + sizeof(T) <= size) memcpy(&t, data + address, sizeof(T));
+        return t;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& t) {
+        if (address >= 0 && address + sizeof(T) <= size) memcpy(data + address, &t, sizeof(T));
+        return t;
+    }
+
+private:
+    uint8_t data[CAPACITY];
+    size_t size;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // NATIVE_HAL_EEPROM_H
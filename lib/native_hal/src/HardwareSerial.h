@@ -0,0 +1,45 @@
+#ifndef NATIVE_HAL_HARDWARE_SERIAL_H
+#define NATIVE_HAL_HARDWARE_SERIAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class String;
+
+#define DEC 10
+#define HEX 16
+
+/**
+ * 主机端串口：输出写到 stdout，没有输入
+ */
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+
+    size_t print(const char* s);
+    size_t print(const String& s);
+    size_t print(char c);
+    size_t print(int v, int base = DEC);
+    size_t print(unsigned int v, int base = DEC);
+    size_t print(long v, int base = DEC);
+    size_t print(unsigned long v, int base = DEC);
+    size_t print(double v, int digits = 2);
+
+    size_t println();
+    template <typename T>
+    size_t println(const T& v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(const T& v, int format) { return print(v, format) + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+    void flush();
+
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // NATIVE_HAL_HARDWARE_SERIAL_H
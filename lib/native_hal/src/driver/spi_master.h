@@ -0,0 +1,74 @@
+#ifndef NATIVE_HAL_DRIVER_SPI_MASTER_H
+#define NATIVE_HAL_DRIVER_SPI_MASTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../freertos/FreeRTOS.h"
+#include "../esp_timer.h"
+
+/**
+ * 主机端 SPI 主机驱动：事务排队即视为完成，发送内容记录为一帧 74HC595 锁存输出
+ */
+
+typedef enum {
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+    SPI3_HOST = 2
+} spi_host_device_t;
+
+typedef enum {
+    SPI_DMA_DISABLED = 0,
+    SPI_DMA_CH1 = 1,
+    SPI_DMA_CH2 = 2,
+    SPI_DMA_CH_AUTO = 3
+} spi_common_dma_t;
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+    int intr_flags;
+} spi_bus_config_t;
+
+typedef struct {
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    uint16_t duty_cycle_pos;
+    uint16_t cs_ena_pretrans;
+    uint8_t cs_ena_posttrans;
+    int clock_speed_hz;
+    int input_delay_ns;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    void (*pre_cb)(void*);
+    void (*post_cb)(void*);
+} spi_device_interface_config_t;
+
+typedef struct spi_transaction_t {
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;      // 位数
+    size_t rxlength;
+    void* user;
+    const void* tx_buffer;
+    void* rx_buffer;
+} spi_transaction_t;
+
+typedef struct spi_device_t* spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* config, spi_common_dma_t dma);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* config,
+                             spi_device_handle_t* handle);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* transaction, TickType_t ticksToWait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** transaction,
+                                      TickType_t ticksToWait);
+
+#endif // NATIVE_HAL_DRIVER_SPI_MASTER_H
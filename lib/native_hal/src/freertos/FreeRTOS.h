@@ -0,0 +1,33 @@
+#ifndef NATIVE_HAL_FREERTOS_H
+#define NATIVE_HAL_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE     ((BaseType_t)0)
+#define pdTRUE      ((BaseType_t)1)
+#define pdFAIL      pdFALSE
+#define pdPASS      pdTRUE
+
+#define portMAX_DELAY         ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ    1000
+#define portTICK_PERIOD_MS    ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)     ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+// 单线程主机上临界区无需加锁
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED  {0, 0}
+#define portENTER_CRITICAL(mux)       ((void)(mux))
+#define portEXIT_CRITICAL(mux)        ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux)   ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)    ((void)(mux))
+#define portYIELD_FROM_ISR(...)       ((void)0)
+
+#endif // NATIVE_HAL_FREERTOS_H
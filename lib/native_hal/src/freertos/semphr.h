@@ -0,0 +1,16 @@
+#ifndef NATIVE_HAL_FREERTOS_SEMPHR_H
+#define NATIVE_HAL_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef struct HostSemaphore* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+// 单线程主机：信号量不可用时立即返回 pdFALSE（不会有其他任务释放它），忽略等待时间
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higherPriorityTaskWoken);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+#endif // NATIVE_HAL_FREERTOS_SEMPHR_H
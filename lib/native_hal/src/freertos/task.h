@@ -0,0 +1,21 @@
+#ifndef NATIVE_HAL_FREERTOS_TASK_H
+#define NATIVE_HAL_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment);
+
+// 主机上只有一个 "当前任务"（调用 host 入口的线程）
+TaskHandle_t xTaskGetCurrentTaskHandle();
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+// 不阻塞：返回挂起的通知数（clearOnExit 为 pdTRUE 时清零，否则减一）
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+
+#endif // NATIVE_HAL_FREERTOS_TASK_H
@@ -0,0 +1,546 @@
+#include "native_hal.h"
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "soc/gpio_reg.h"
+#include "driver/spi_master.h"
+#include "xtensa/hal.h"
+#include <stdarg.h>
+#include <vector>
+
+// ==========================================
+// 内部状态
+// ==========================================
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    bool armed;
+    uint64_t dueUs;
+    uint64_t sequence;  // 同一时刻到期时按装定顺序执行
+};
+
+struct HostSemaphore {
+    int count;
+};
+
+struct HostTask {
+    uint32_t notifications;
+};
+
+struct spi_device_t {
+    static const int QUEUE_SIZE = 8;
+    spi_transaction_t* done[QUEUE_SIZE];
+    int head;
+    int count;
+};
+
+namespace {
+
+struct PinState {
+    uint8_t level;
+    uint8_t mode;
+    int interruptMode;          // 0 = 未挂接
+    void (*isr)(void);
+};
+
+uint64_t currentUs = 0;
+uint64_t timerSequence = 0;
+PinState pins[NativeHal::PIN_COUNT];
+std::vector<esp_timer*> timers;
+HostTask mainTask = {0};
+
+// 74HC595：shiftOut 先移入，锁存引脚上升沿时整体输出；SPI 事务直接成帧
+uint8_t shiftBuffer[NativeHal::MAX_FRAME_BYTES];
+int shiftBufferLength = 0;
+uint8_t latchedFrame[NativeHal::MAX_FRAME_BYTES];
+int latchedFrameLength = 0;
+uint32_t latchCount = 0;
+uint32_t pinWriteCount = 0;
+NativeHal::FrameListener frameListener = nullptr;
+void* frameListenerContext = nullptr;
+bool serialEcho = true;
+NativeHal::SerialListener serialListener = nullptr;
+void* serialListenerContext = nullptr;
+
+// 中断服务耗时模型
+uint32_t isrCostUs = 0;
+uint64_t isrBusyUntilUs = 0;
+uint64_t pendingInterruptPins = 0;
+uint32_t coalescedInterrupts = 0;
+
+bool validPin(int pin) { return pin >= 0 && pin < NativeHal::PIN_COUNT; }
+
+size_t serialOut(const char* text, size_t length) {
+    if (serialListener != nullptr) serialListener(serialListenerContext, text, length);
+    if (!serialEcho) return length;
+    return fwrite(text, 1, length, stdout);
+}
+
+void latchFrame(const uint8_t* bytes, int length) {
+    if (length > NativeHal::MAX_FRAME_BYTES) length = NativeHal::MAX_FRAME_BYTES;
+    memcpy(latchedFrame, bytes, length);
+    latchedFrameLength = length;
+    latchCount++;
+    if (frameListener != nullptr) frameListener(frameListenerContext, latchedFrame, length);
+}
+
+void invokeIsr(int pin) {
+    if (pins[pin].isr == nullptr) return;
+    if (isrCostUs > 0) isrBusyUntilUs = currentUs + isrCostUs;
+    pins[pin].isr();
+}
+
+// 挂起的中断在 CPU 空闲时按引脚号依次服务（每次占用 isrCostUs）
+bool hasPendingInterrupts() { return pendingInterruptPins != 0; }
+
+void servicePendingInterrupt() {
+    for (int pin = 0; pin < NativeHal::PIN_COUNT; pin++) {
+        uint64_t bit = 1ULL << pin;
+        if (!(pendingInterruptPins & bit)) continue;
+        pendingInterruptPins &= ~bit;
+        invokeIsr(pin);
+        return;
+    }
+}
+
+// 取最早到期且不晚于 limitUs 的定时器
+esp_timer* nextDueTimer(uint64_t limitUs) {
+    esp_timer* best = nullptr;
+    for (size_t i = 0; i < timers.size(); i++) {
+        esp_timer* t = timers[i];
+        if (!t->armed || t->dueUs > limitUs) continue;
+        if (best == nullptr || t->dueUs < best->dueUs ||
+            (t->dueUs == best->dueUs && t->sequence < best->sequence)) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+// ==========================================
+// 控制接口
+// ==========================================
+
+namespace NativeHal {
+
+void reset() {
+    currentUs = 0;
+    timerSequence = 0;
+    for (int i = 0; i < PIN_COUNT; i++) {
+        pins[i].level = LOW;
+        pins[i].mode = INPUT;
+        pins[i].interruptMode = 0;
+        pins[i].isr = nullptr;
+    }
+    for (size_t i = 0; i < timers.size(); i++) {
+        timers[i]->armed = false;
+    }
+    mainTask.notifications = 0;
+    isrBusyUntilUs = 0;
+    pendingInterruptPins = 0;
+    coalescedInterrupts = 0;
+    shiftBufferLength = 0;
+    latchedFrameLength = 0;
+    latchCount = 0;
+    pinWriteCount = 0;
+    EEPROM.erase();
+}
+
+uint64_t nowUs() { return currentUs; }
+
+void advanceTo(uint64_t targetUs) {
+    if (targetUs < currentUs) return;
+    for (;;) {
+        // 定时器与挂起的中断按时间先后处理，同一时刻中断优先
+        esp_timer* t = nextDueTimer(targetUs);
+        bool irq = hasPendingInterrupts() && isrBusyUntilUs <= targetUs;
+        if (irq && (t == nullptr || isrBusyUntilUs <= t->dueUs)) {
+            if (isrBusyUntilUs > currentUs) currentUs = isrBusyUntilUs;
+            servicePendingInterrupt();
+            continue;
+        }
+        if (t == nullptr) break;
+        if (t->dueUs > currentUs) currentUs = t->dueUs;
+        t->armed = false;
+        t->callback(t->arg);
+    }
+    currentUs = targetUs;
+}
+
+void advanceUs(uint64_t us) { advanceTo(currentUs + us); }
+
+bool nextEventUs(uint64_t& us) {
+    bool found = false;
+    uint64_t best = 0;
+    if (hasPendingInterrupts()) {
+        best = isrBusyUntilUs;
+        found = true;
+    }
+    esp_timer* t = nextDueTimer(UINT64_MAX);
+    if (t != nullptr && (!found || t->dueUs < best)) {
+        best = t->dueUs;
+        found = true;
+    }
+    us = (best > currentUs) ? best : currentUs;
+    return found;
+}
+
+void setPinLevel(int pin, int level) {
+    if (!validPin(pin)) return;
+    uint8_t previous = pins[pin].level;
+    uint8_t next = level ? HIGH : LOW;
+    pins[pin].level = next;
+    if (previous == next || pins[pin].isr == nullptr) return;
+
+    int mode = pins[pin].interruptMode;
+    bool fire = (mode == CHANGE) || (mode == RISING && next == HIGH) || (mode == FALLING && next == LOW);
+    if (!fire) return;
+
+    uint64_t bit = 1ULL << pin;
+    if (isrCostUs == 0 || (currentUs >= isrBusyUntilUs && !hasPendingInterrupts())) {
+        invokeIsr(pin);
+    } else {
+        if (pendingInterruptPins & bit) coalescedInterrupts++;
+        pendingInterruptPins |= bit;
+    }
+}
+
+void setIsrCostUs(uint32_t us) { isrCostUs = us; }
+uint32_t getCoalescedInterruptCount() { return coalescedInterrupts; }
+
+void forcePinLevel(int pin, int level) {
+    if (!validPin(pin)) return;
+    pins[pin].level = level ? HIGH : LOW;
+}
+
+int getPinLevel(int pin) { return validPin(pin) ? pins[pin].level : LOW; }
+
+int getLatchedFrame(uint8_t* bytes, int maxBytes) {
+    int length = (latchedFrameLength < maxBytes) ? latchedFrameLength : maxBytes;
+    memcpy(bytes, latchedFrame, length);
+    return length;
+}
+
+uint32_t getLatchCount() { return latchCount; }
+
+uint32_t getPinWriteCount() { return pinWriteCount; }
+
+void setFrameListener(FrameListener listener, void* context) {
+    frameListener = listener;
+    frameListenerContext = context;
+}
+
+void setSerialEcho(bool enabled) { serialEcho = enabled; }
+
+void setSerialListener(SerialListener listener, void* context) {
+    serialListener = listener;
+    serialListenerContext = context;
+}
+
+uint32_t getPendingNotifications(void* task) {
+    return task ? static_cast<HostTask*>(task)->notifications : 0;
+}
+
+} // namespace NativeHal
+
+// ==========================================
+// Arduino 核心
+// ==========================================
+
+unsigned long millis() { return (unsigned long)(currentUs / 1000); }
+unsigned long micros() { return (unsigned long)(uint32_t)currentUs; }
+void delay(uint32_t ms) { NativeHal::advanceUs((uint64_t)ms * 1000); }
+void delayMicroseconds(uint32_t us) { NativeHal::advanceUs(us); }
+uint32_t getCpuFrequencyMhz() { return 240; }
+uint32_t xthal_get_ccount() { return (uint32_t)(currentUs * getCpuFrequencyMhz()); }
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (!validPin(pin)) return;
+    pins[pin].mode = mode;
+}
+
+int digitalRead(uint8_t pin) { return NativeHal::getPinLevel(pin); }
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    if (!validPin(pin)) return;
+    pinWriteCount++;
+    uint8_t previous = pins[pin].level;
+    pins[pin].level = level ? HIGH : LOW;
+
+    // 任意输出引脚的上升沿都视为锁存脉冲：把 shiftOut 移入的字节作为一帧输出
+    if (previous == LOW && level && shiftBufferLength > 0) {
+        latchFrame(shiftBuffer, shiftBufferLength);
+        shiftBufferLength = 0;
+    }
+}
+
+int gpio_get_level(gpio_num_t pin) { return NativeHal::getPinLevel(pin); }
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value) {
+    (void)dataPin;
+    (void)clockPin;
+    pinWriteCount += 3 * 8;
+    if (bitOrder == LSBFIRST) {
+        uint8_t reversed = 0;
+        for (int i = 0; i < 8; i++) {
+            if (value & (1 << i)) reversed |= (uint8_t)(0x80 >> i);
+        }
+        value = reversed;
+    }
+    if (shiftBufferLength < NativeHal::MAX_FRAME_BYTES) {
+        shiftBuffer[shiftBufferLength++] = value;
+    }
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+    if (!validPin(pin)) return;
+    pins[pin].isr = isr;
+    pins[pin].interruptMode = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (!validPin(pin)) return;
+    pins[pin].isr = nullptr;
+    pins[pin].interruptMode = 0;
+}
+
+uint32_t nativeHalReadGpioReg(int reg) {
+    uint32_t value = 0;
+    int base = (reg == GPIO_IN_REG) ? 0 : 32;
+    for (int bit = 0; bit < 32 && base + bit < NativeHal::PIN_COUNT; bit++) {
+        if (pins[base + bit].level) value |= (1u << bit);
+    }
+    return value;
+}
+
+// ==========================================
+// 串口
+// ==========================================
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::print(const char* s) { return serialOut(s, strlen(s)); }
+size_t HardwareSerial::print(const String& s) { return print(s.c_str()); }
+size_t HardwareSerial::print(char c) { return write((uint8_t)c); }
+size_t HardwareSerial::print(int v, int base) { return print((long)v, base); }
+size_t HardwareSerial::print(unsigned int v, int base) { return print((unsigned long)v, base); }
+size_t HardwareSerial::print(long v, int base) {
+    if (base == HEX) return printf("%lX", v);
+    return printf("%ld", v);
+}
+size_t HardwareSerial::print(unsigned long v, int base) {
+    if (base == HEX) return printf("%lX", v);
+    return printf("%lu", v);
+}
+size_t HardwareSerial::print(double v, int digits) { return printf("%.*f", digits, v); }
+size_t HardwareSerial::println() { return print("\n"); }
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (n <= 0) return 0;
+    if ((size_t)n < sizeof(text)) return serialOut(text, n);
+
+    // 超出栈上缓冲的长输出
+    std::vector<char> longText(n + 1);
+    va_start(args, format);
+    vsnprintf(longText.data(), longText.size(), format, args);
+    va_end(args);
+    return serialOut(longText.data(), n);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    char ch = (char)c;
+    return serialOut(&ch, 1);
+}
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return serialOut((const char*)buffer, size);
+}
+void HardwareSerial::flush() { fflush(stdout); }
+
+// ==========================================
+// EEPROM
+// ==========================================
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass() : size(0) { erase(); }
+
+bool EEPROMClass::begin(size_t requested) {
+    if (requested == 0 || requested > CAPACITY) return false;
+    size = requested;
+    return true;
+}
+
+uint8_t EEPROMClass::read(int address) {
+    return (address >= 0 && (size_t)address < size) ? data[address] : 0;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address >= 0 && (size_t)address < size) data[address] = value;
+}
+
+void EEPROMClass::erase() { memset(data, 0xFF, sizeof(data)); }
+
+// ==========================================
+// FreeRTOS
+// ==========================================
+
+TickType_t xTaskGetTickCount() { return (TickType_t)(currentUs / (1000 * portTICK_PERIOD_MS)); }
+
+void vTaskDelay(TickType_t ticks) { NativeHal::advanceUs((uint64_t)ticks * portTICK_PERIOD_MS * 1000); }
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment) {
+    *previousWakeTime += increment;
+    NativeHal::advanceTo((uint64_t)*previousWakeTime * portTICK_PERIOD_MS * 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return &mainTask; }
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    if (task) static_cast<HostTask*>(task)->notifications++;
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    vTaskNotifyGiveFromISR(task, nullptr);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    (void)ticksToWait;
+    uint32_t value = mainTask.notifications;
+    if (value > 0) mainTask.notifications = clearOnExit ? 0 : value - 1;
+    return value;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    HostSemaphore* s = new HostSemaphore;
+    s->count = 1;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    HostSemaphore* s = new HostSemaphore;
+    s->count = 0;
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+    (void)ticksToWait;
+    if (semaphore == nullptr || semaphore->count == 0) return pdFALSE;
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if (semaphore == nullptr || semaphore->count > 0) return pdFALSE;
+    semaphore->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higherPriorityTaskWoken) {
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+    return xSemaphoreGive(semaphore);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete semaphore; }
+
+// ==========================================
+// esp_timer
+// ==========================================
+
+int64_t esp_timer_get_time() { return (int64_t)currentUs; }
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    if (args == nullptr || args->callback == nullptr || out == nullptr) return ESP_ERR_INVALID_ARG;
+    esp_timer* t = new esp_timer;
+    t->callback = args->callback;
+    t->arg = args->arg;
+    t->armed = false;
+    t->dueUs = 0;
+    t->sequence = 0;
+    timers.push_back(t);
+    *out = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+    if (timer == nullptr) return ESP_ERR_INVALID_ARG;
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->armed = true;
+    timer->dueUs = currentUs + timeoutUs;
+    timer->sequence = timerSequence++;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (timer == nullptr) return ESP_ERR_INVALID_ARG;
+    if (!timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (timer == nullptr) return ESP_ERR_INVALID_ARG;
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    for (size_t i = 0; i < timers.size(); i++) {
+        if (timers[i] == timer) {
+            timers.erase(timers.begin() + i);
+            break;
+        }
+    }
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) { return timer != nullptr && timer->armed; }
+
+// ==========================================
+// SPI 主机
+// ==========================================
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* config, spi_common_dma_t dma) {
+    (void)host;
+    (void)dma;
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* config,
+                             spi_device_handle_t* handle) {
+    (void)host;
+    if (config == nullptr || handle == nullptr) return ESP_ERR_INVALID_ARG;
+    spi_device_t* device = new spi_device_t;
+    device->head = 0;
+    device->count = 0;
+    *handle = device;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* transaction, TickType_t ticksToWait) {
+    (void)ticksToWait;
+    if (handle == nullptr || transaction == nullptr) return ESP_ERR_INVALID_ARG;
+    if (handle->count >= spi_device_t::QUEUE_SIZE) return ESP_ERR_TIMEOUT;
+
+    // CS 在事务结束时拉高，即锁存
+    latchFrame(static_cast<const uint8_t*>(transaction->tx_buffer), (int)(transaction->length / 8));
+    handle->done[(handle->head + handle->count) % spi_device_t::QUEUE_SIZE] = transaction;
+    handle->count++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** transaction,
+                                      TickType_t ticksToWait) {
+    (void)ticksToWait;
+    if (handle == nullptr || transaction == nullptr) return ESP_ERR_INVALID_ARG;
+    if (handle->count == 0) return ESP_ERR_TIMEOUT;
+    *transaction = handle->done[handle->head];
+    handle->head = (handle->head + 1) % spi_device_t::QUEUE_SIZE;
+    handle->count--;
+    return ESP_OK;
+}
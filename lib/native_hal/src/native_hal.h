@@ -0,0 +1,68 @@
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * 主机端硬件抽象层的控制接口（仅 env:native）
+ *
+ * 分拣核心照常调用 Arduino / FreeRTOS / ESP-IDF 接口，这些接口在主机上由本库实现：
+ *   - 时间是虚拟的：从 0 开始，只在 advanceUs()、delay()、vTaskDelay() 中前进，
+ *     因此同一输入序列每次运行得到完全相同的结果
+ *   - 引脚电平由测试代码通过 setPinLevel() 驱动，按 attachInterrupt() 的触发方式同步调用 ISR
+ *   - esp_timer 回调在 advanceUs() 中按到期先后同步执行（回调内看到的时间即其到期时刻）
+ *   - 74HC595 输出：SPI 事务或 shiftOut + 锁存上升沿都会被记录为一帧
+ *   - 单线程：信号量取不到时立即失败（主机上没有其他任务会释放它），ulTaskNotifyTake() 不阻塞
+ *   - 可选的中断服务耗时模型：每次 ISR 占用 CPU 一段时间，其间到来的中断挂起，
+ *     同一引脚的多次挂起合并为一次（与 GPIO 中断状态位相同），服务时读取的是当时的电平
+ */
+namespace NativeHal {
+
+static const int PIN_COUNT = 40;
+static const int MAX_FRAME_BYTES = 16;
+
+// 恢复上电状态：时间归零、引脚清零并解除中断、EEPROM 全部为 0xFF、清除定时器与通知
+void reset();
+
+// 虚拟时间 (us)
+uint64_t nowUs();
+// 时间前进 us，期间到期的 esp_timer 回调按到期顺序执行
+void advanceUs(uint64_t us);
+// 前进到绝对时刻 targetUs（早于当前时间时不动）
+void advanceTo(uint64_t targetUs);
+// 下一个内部事件（挂起中断的服务时刻或定时器到期）的时刻，没有时返回 false
+bool nextEventUs(uint64_t& us);
+
+// 外部驱动引脚电平；电平变化时按触发方式调用已挂接的 ISR
+void setPinLevel(int pin, int level);
+// 直接改写引脚电平，不触发 ISR（回放时还原采样看到的电平）
+void forcePinLevel(int pin, int level);
+int getPinLevel(int pin);
+
+// 每次 ISR 的服务耗时 (us)，0 = 立即执行（默认）
+void setIsrCostUs(uint32_t us);
+// 因 CPU 忙而与前一次挂起合并、未被单独服务的中断次数
+uint32_t getCoalescedInterruptCount();
+
+// 最近一次锁存到 74HC595 的帧（bytes[0] 最先移出），返回帧长度，尚未锁存时返回 0
+int getLatchedFrame(uint8_t* bytes, int maxBytes);
+uint32_t getLatchCount();
+// GPIO 输出写入次数：digitalWrite 计 1 次，shiftOut 按 Arduino 核心的实现每位计 3 次（数据、时钟高、时钟低）
+uint32_t getPinWriteCount();
+// 每次锁存时回调（在锁存发生的虚拟时刻同步调用）
+typedef void (*FrameListener)(void* context, const uint8_t* bytes, int length);
+void setFrameListener(FrameListener listener, void* context);
+
+// 串口输出开关（批量仿真时关闭核心的调试输出）
+void setSerialEcho(bool enabled);
+// 每次串口输出时回调（与输出开关无关，text 不以 '\0' 结尾）
+typedef void (*SerialListener)(void* context, const char* text, size_t length);
+void setSerialListener(SerialListener listener, void* context);
+
+// 任务通知：挂起的通知数（不清除）
+uint32_t getPendingNotifications(void* task);
+
+} // namespace NativeHal
+
+#endif // NATIVE_HAL_H
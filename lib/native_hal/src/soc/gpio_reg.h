@@ -0,0 +1,14 @@
+#ifndef NATIVE_HAL_SOC_GPIO_REG_H
+#define NATIVE_HAL_SOC_GPIO_REG_H
+
+#include <stdint.h>
+
+// GPIO0-31 / GPIO32-39 输入寄存器，由 NativeHal 的引脚电平拼出
+#define GPIO_IN_REG     0
+#define GPIO_IN1_REG    1
+
+uint32_t nativeHalReadGpioReg(int reg);
+
+#define REG_READ(reg)   nativeHalReadGpioReg(reg)
+
+#endif // NATIVE_HAL_SOC_GPIO_REG_H
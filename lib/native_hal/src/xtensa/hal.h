@@ -0,0 +1,9 @@
+#ifndef NATIVE_HAL_XTENSA_HAL_H
+#define NATIVE_HAL_XTENSA_HAL_H
+
+#include <stdint.h>
+
+// CCOUNT 周期计数器：主机上由虚拟时间按 getCpuFrequencyMhz() 换算，代码执行本身不消耗周期
+uint32_t xthal_get_ccount();
+
+#endif // NATIVE_HAL_XTENSA_HAL_H
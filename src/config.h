@@ -18,6 +18,11 @@ constexpr int PIN_HC595_DS   = 33;  // 数据输入
 constexpr int PIN_HC595_SHCP = 4;   // 移位脉冲
 constexpr int PIN_HC595_STCP = 2;   // 锁存脉冲
 
+// 74HC595 级联片数与驱动后端：true 为硬件 SPI (DS/SHCP/STCP = MOSI/SCK/CS，排队非阻塞)，false 为 shiftOut 位操作
+constexpr int SHIFT_REGISTER_CHAIN_LENGTH = 3;
+constexpr bool SHIFT_REGISTER_USE_SPI = true;
+constexpr int SHIFT_REGISTER_SPI_CLOCK_HZ = 10000000;
+
 // HMI Module (Rotary Encoder with Push Button)
 constexpr int PIN_HMI_ENC_A = 13;
 constexpr int PIN_HMI_ENC_B = 12;
@@ -59,13 +64,24 @@ constexpr int PINS_SCANNER[5] = {
 constexpr int ENCODER_MAX_PHASE = 200;
 constexpr int PULSES_PER_TRAY = 200;
 constexpr bool ENCODER_REVERSE_DIRECTION = false; // 软件反转编码器计数方向
+constexpr uint32_t SPEED_STALL_TIMEOUT_US = 500000; // 超过该时长无编码器边沿则判定传送带停转
 
 // Output
 constexpr int NUM_OUTLETS = 8;
 
+// Tray queue: 扫描位 (0) 到最后一个出口之后的逻辑托盘位置数（环形队列容量自动取 2 的幂）
+// 产线要求至少 19 个托盘位置
+constexpr int TRAY_QUEUE_POSITIONS = 19;
+static_assert(TRAY_QUEUE_POSITIONS >= 19, "Production line requires at least 19 tray positions");
+
 // Scanner: 托盘 pitch 为 101.6mm，逻辑周期为 200 phase，故物理权重为 101.6/200 = 0.508
 constexpr float SCANNER_WEIGHTS[4] = {0.508f, 0.508f, 0.508f, 0.508f};
 constexpr int SCANNER_MIN_DIAMETER_UNIT = 5; // 约 2.5mm
+constexpr int SCANNER_OFFSETS_DECI_MM[4] = {0, 0, 0, 0}; // 各通道零点校准 (0.1mm)，补偿光束宽度差异
+constexpr int SCANNER_FUSION_TOLERANCE_DECI_MM = 15;    // 通道与中位数偏差超过 1.5mm 视为离群值
+constexpr int SCANNER_MIN_CONFIDENCE = 40;              // 低于该置信度的托盘不参与直径分级，改走剔除出口
+constexpr bool SCANNER_EDGE_CAPTURE = false;  // true: 默认使用边沿列表采集模式，false: 位图模式
+constexpr int SCANNER_MAX_EDGES = 64;         // 边沿列表容量（每个扫描窗口，4 通道合计）
 
 // ==========================================
 // Timing & Phases
@@ -108,7 +124,7 @@ constexpr int EEPROM_ADDR_DIAMETER       = 0x00; // 1 byte:  magic marker (0xAA
 constexpr int EEPROM_ADDR_DIAMETER_DATA  = 0x01; // 24 bytes: NUM_OUTLETS * 3 (min, max, length)
 constexpr int EEPROM_ADDR_OUTLET0_MODE   = 0x19; // 1 byte:  outlet 0 mode (0=multi-obj, 1=diameter)
 constexpr int EEPROM_ADDR_BOOT_COUNT     = 0x64; // 4 bytes: uint32 boot counter
-constexpr int EEPROM_ADDR_TRAY_DATA      = 0x70; // 145 bytes: magic + 18*(diameter+count) ints => ends at 0x100
+constexpr int EEPROM_ADDR_TRAY_DATA      = 0x70; // 115 bytes: magic + 19 * TRAY_RECORD_BYTES(6) => ends at 0xE3
 constexpr int EEPROM_ADDR_PHASE_OFFSET   = 0x110; // 2 bytes: [0]=magic(0xA5), [1]=offset value
 
 // Power Loss Threshold (ADC value: 0-4095)
@@ -118,4 +134,55 @@ constexpr int POWER_LOSS_ADC_THRESHOLD = 3000;
 constexpr int PULSE_OPEN_MS  = 100;
 constexpr int PULSE_CLOSE_MS = 300;
 
+// 翻板机械行程时间默认值 (ms)，可按出口单独标定；用于按速度提前触发
+constexpr int OUTLET_MECHANICAL_LATENCY_MS = PULSE_OPEN_MS;   // 打开行程
+constexpr int OUTLET_CLOSE_LATENCY_MS = PULSE_CLOSE_MS;       // 关闭行程（下一托盘到达前须完成）
+
+// 翻板打开后至少保持的相位数，保证物体有足够的下落窗口
+constexpr int OUTLET_MIN_DROP_PHASES = 60;
+
+// 翻板保持前瞻托盘数：窗口内下一个非空托盘仍属本出口时，翻板穿过中间的空托盘保持打开
+// 1 表示仅看下一个托盘（原行为）
+constexpr int OUTLET_HOLD_LOOKAHEAD = 4;
+
+// 线圈起动错峰：相邻两次脉冲起动的最小间隔 (us) 与同时通电的线圈数上限，限制电源浪涌
+constexpr uint32_t OUTLET_PULSE_STAGGER_US = 1500;
+constexpr int OUTLET_MAX_CONCURRENT_COILS = 4;
+// 每个动作至少允许推迟的时间 (ms)；计入按速度提前触发的提前量，推迟后翻板仍能按时到位
+// 实际的最迟起动时刻由触发相位到分流相位的行程时间按实测速度推算（见 actuationDeadlineUs）
+constexpr int OUTLET_ACTUATION_BUDGET_MS = 10;
+// 传送带静止（手动/诊断操作）时没有托盘到达时刻，请求最迟在此时间内起动；
+// 长于一个关闭脉冲，满额时排队的请求等线圈断电后按限流起动，而不是被强制起动
+constexpr int OUTLET_IDLE_ACTUATION_SLACK_MS = 2 * PULSE_CLOSE_MS;
+
+// 控制任务调度方式：true 为相位事件 ISR 通知唤醒，false 为原 1ms 轮询
+constexpr bool CONTROL_TASK_EVENT_DRIVEN = true;
+// 事件驱动时无事件的最长阻塞时间 (ms)：仍需定期更新速度估计（停转检测）
+constexpr int CONTROL_TASK_IDLE_TIMEOUT_MS = 10;
+// 相位事件 -> 控制任务处理 延迟分布的串口报告周期 (ms)，0 关闭
+constexpr int CONTROL_LATENCY_REPORT_MS = 10000;
+
+// 事件追踪：RAM 环形缓冲记录编码器相位、扫描采样、锁存结果、线圈脉冲与 74HC595 帧，
+// 可从菜单导出到串口，在主机上回放复现分拣判定（false 时记录调用全部编译消除）
+constexpr bool TRACE_RECORDER_ENABLED = true;
+// 追踪记录条数（2 的幂，每条 8 字节）；每个托架周期约 215 条，4096 条约覆盖最近 19 个托盘
+constexpr int TRACE_RING_CAPACITY = 4096;
+
+// 热路径周期剖析：按探针统计 ISR 与控制任务各阶段的 CCOUNT 周期数（最小/平均/最大 + 对数直方图），
+// 在 Hardware Diag > CPU Profiler 页面与串口查看；false 时探针全部编译消除
+constexpr bool CYCLE_PROFILER_ENABLED = true;
+
+// 延迟日志：LOG_* 宏只把格式串指针与整型参数写入无锁环形缓冲，由 Core 0 的低优先级日志任务格式化输出，
+// 控制任务不再被串口阻塞；缓冲满时丢弃并计数。级别高于 DEFERRED_LOG_LEVEL 的调用编译消除
+enum LogLevel {
+    LOG_LEVEL_NONE = 0,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG
+};
+constexpr int DEFERRED_LOG_LEVEL = LOG_LEVEL_INFO;    // 调试扫描/HMI 时改为 LOG_LEVEL_DEBUG（每托盘多条记录）
+constexpr int DEFERRED_LOG_CAPACITY = 64;     // 缓冲记录数（2 的幂）
+constexpr int DEFERRED_LOG_DRAIN_MS = 10;     // 日志任务的输出周期
+
 #endif // CONFIG_H
@@ -143,7 +143,7 @@ void DiameterConfigHandler::handleValueChange(int delta) {
           int next = (int)current + (delta > 0 ? 1 : -1);
           if (next > 7) next = 1;
           else if (next < 1) next = 7;
-          sorter->getOutlet(targetOutlet)->setTargetLength((uint8_t)next);
+          sorter->setOutletTargetLength(targetOutlet, (uint8_t)next);
       }
   }
   refreshDisplay();
@@ -58,7 +58,8 @@ void EncoderDiagnosticHandler::update(uint32_t currentMs, bool btnPressed) {
                     String line1 = "Correct: " + String(correctZ);
                     String line2 = "Errors : " + String(errorZ);
                     String line3 = "LastZRaw:" + String(lastZRaw);
-                    userInterface->displayMultiLineText("Encoder Report", line1, line2, line3, "Z-Signal OK");
+                    String line5 = "Illegal: " + String(encoder->getIllegalTransitionCount());
+                    userInterface->displayMultiLineText("Encoder Report", line1, line2, line3, "Z-Signal OK", line5);
                 }
                 break;
             case 2:
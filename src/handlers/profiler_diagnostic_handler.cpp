@@ -0,0 +1,79 @@
+#include "profiler_diagnostic_handler.h"
+
+ProfilerDiagnosticHandler::ProfilerDiagnosticHandler() {
+    userInterface = nullptr;
+    currentSubMode = 0;
+    lastUIDisplayTime = 0;
+}
+
+void ProfilerDiagnosticHandler::initialize(UserInterface* ui) {
+    userInterface = ui;
+}
+
+void ProfilerDiagnosticHandler::begin() {
+    Serial.println("[DIAGNOSTIC] CPU Profiler Started");
+    CycleProfiler::printReport();
+    CycleProfiler::reset();
+    currentSubMode = 0;
+    lastUIDisplayTime = 0;
+}
+
+void ProfilerDiagnosticHandler::end() {
+    Serial.println("[DIAGNOSTIC] CPU Profiler Ended");
+}
+
+// "名称 平均/最大"（周期），一行不超过 21 个字符
+String ProfilerDiagnosticHandler::formatProbe(ProfileProbe probe) {
+    const ProbeStats& s = CycleProfiler::get(probe);
+    char line[24];
+    snprintf(line, sizeof(line), "%-7s%5u/%u", CycleProfiler::getName(probe), s.getAverageCycles(), s.maxCycles);
+    return String(line);
+}
+
+void ProfilerDiagnosticHandler::update(uint32_t currentMs, bool btnPressed) {
+    if (btnPressed) {
+        if (currentSubMode == 2) {
+            handleReturnToMenu();
+            return;
+        }
+        switchToNextSubMode();
+        return;
+    }
+
+    if (currentMs - lastUIDisplayTime < UI_REFRESH_INTERVAL) return;
+    lastUIDisplayTime = currentMs;
+
+    if (!CYCLE_PROFILER_ENABLED) {
+        userInterface->displayDiagnosticInfo("CPU Profiler", "Disabled in config.h\n\nClick to return...");
+        currentSubMode = 2;
+        return;
+    }
+
+    switch (currentSubMode) {
+        case 0:
+            // ISR 路径：编码器边沿 -> 相位回调 -> 采样；传感器跳变
+            userInterface->displayMultiLineText("ISR avg/max cyc",
+                formatProbe(PROBE_ENCODER_ISR), formatProbe(PROBE_PHASE_CALLBACK),
+                formatProbe(PROBE_SCANNER_SAMPLE), formatProbe(PROBE_SENSOR_ISR),
+                "n=" + String(CycleProfiler::get(PROBE_ENCODER_ISR).count));
+            break;
+        case 1:
+            // 控制任务各阶段
+            userInterface->displayMultiLineText("Task avg/max cyc",
+                formatProbe(PROBE_CONTROL_RUN), formatProbe(PROBE_LATCH_DECODE),
+                formatProbe(PROBE_PREPARE_OUTLETS), formatProbe(PROBE_UPDATE_SHIFT),
+                formatProbe(PROBE_FLUSH_SHIFT));
+            break;
+        case 2:
+            userInterface->displayMultiLineText("Timer avg/max cyc",
+                formatProbe(PROBE_PULSE_TIMER), "", "Click to return...");
+            break;
+    }
+}
+
+void ProfilerDiagnosticHandler::switchToNextSubMode() {
+    currentSubMode = (currentSubMode + 1) % 3;
+    lastUIDisplayTime = 0;
+    Serial.println("[DIAGNOSTIC] Profiler Submode: " + String(currentSubMode));
+    CycleProfiler::printReport();
+}
@@ -0,0 +1,31 @@
+#ifndef PROFILER_DIAGNOSTIC_HANDLER_H
+#define PROFILER_DIAGNOSTIC_HANDLER_H
+#include "../user_interface/user_interface.h"
+#include "../modular/cycle_profiler.h"
+#include "base_diagnostic_handler.h"
+
+/**
+ * CPU 周期剖析页面
+ * 分拣照常运行，页面显示各探针的 平均/最大 周期数；进入时先把开机以来的统计输出到串口再清零，
+ * 每次翻页输出一次完整报告（含直方图）。
+ */
+class ProfilerDiagnosticHandler : public BaseDiagnosticHandler {
+private:
+    UserInterface* userInterface;
+    int currentSubMode;
+    unsigned long lastUIDisplayTime;
+    const unsigned long UI_REFRESH_INTERVAL = 500; // 刷新间隔（毫秒）
+
+    static String formatProbe(ProfileProbe probe);
+
+public:
+    ProfilerDiagnosticHandler();
+    void initialize(UserInterface* ui);
+
+    // 实现基类接口
+    void begin() override;
+    void update(uint32_t currentTime, bool btnPressed) override;
+    void end() override;
+    void switchToNextSubMode();
+};
+#endif // PROFILER_DIAGNOSTIC_HANDLER_H
@@ -0,0 +1,459 @@
+#include "conveyor_sim.h"
+#include <EEPROM.h>
+#include <algorithm>
+#include "native_hal.h"
+#include "../modular/outlet_wiring.h"
+#include "../modular/deferred_log.h"
+
+// ==========================================
+// 产品流
+// ==========================================
+
+namespace {
+
+uint32_t xorshift32(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+uint8_t parseLength(char c) {
+    switch (c) {
+        case 'S': case 's': return LEN_S;
+        case 'M': case 'm': return LEN_M;
+        default: return LEN_L;
+    }
+}
+
+// 正向格雷码序列（见 quadrature_decoder.h）：00 -> 01 -> 11 -> 10
+const uint8_t QUADRATURE_SEQUENCE[4] = {0x0, 0x1, 0x3, 0x2};
+const int COUNTS_PER_Z = 400;
+const float DOUBLE_GAP_PHASES = 4.0f;
+
+} // namespace
+
+bool ProductStream::loadScript(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+
+    products.clear();
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+
+        SimProduct product = {};
+        if (*p == '-') {
+            products.push_back(product);
+            continue;
+        }
+        float d1 = 0.0f, d2 = 0.0f;
+        char length = 'L';
+        if (sscanf(p, "%f+%f %c", &d1, &d2, &length) == 3) {
+            product.count = 2;
+        } else if (sscanf(p, "%f %c", &d1, &length) >= 1) {
+            product.count = 1;
+        } else {
+            continue;
+        }
+        product.diameterDeciMm[0] = (uint16_t)(d1 * 10.0f + 0.5f);
+        product.diameterDeciMm[1] = (uint16_t)(d2 * 10.0f + 0.5f);
+        product.lengthMask = parseLength(length);
+        products.push_back(product);
+    }
+    fclose(file);
+    return !products.empty();
+}
+
+void ProductStream::generate(uint32_t seed, int count, int gapPercent, int doublePercent) {
+    uint32_t state = seed ? seed : 1;
+    products.clear();
+    for (int i = 0; i < count; i++) {
+        SimProduct product = {};
+        int roll = (int)(xorshift32(state) % 100);
+        if (roll >= gapPercent) {
+            bool isDouble = roll < gapPercent + doublePercent;
+            product.count = isDouble ? 2 : 1;
+            // 单根 6.0 - 28.0mm；双根每根不超过 20.0mm，保证两根都在扫描窗口内
+            int maxDeciMm = isDouble ? 200 : 280;
+            for (int k = 0; k < product.count; k++) {
+                product.diameterDeciMm[k] = (uint16_t)(60 + xorshift32(state) % (maxDeciMm - 60 + 1));
+            }
+            int lengthRoll = (int)(xorshift32(state) % 100);
+            product.lengthMask = (lengthRoll < 20) ? LEN_S : (lengthRoll < 50) ? LEN_M : LEN_L;
+            product.centerOffsetPhases = (int8_t)((int)(xorshift32(state) % 31) - 15);
+        }
+        products.push_back(product);
+    }
+}
+
+// ==========================================
+// 仿真器
+// ==========================================
+
+ConveyorSimulator::ConveyorSimulator(Sorter* sorter, const ProductStream* stream, const SimConfig& config)
+    : sorter(sorter), stream(stream), config(config), activeStep(-1),
+      quadratureIndex(0), encoderCount(0), nextRunUs(0), taskFreeUs(0), baseSequence(0),
+      cyclePeriodUs(0), baseCoalesced(0), baseIllegal(0), baseSkipped(0), baseDropped(0) {
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        flaps[i] = FlapState();
+    }
+}
+
+// 按 setup() 的顺序启动分拣核心
+void ConveyorSimulator::startCore() {
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+    NativeHal::setIsrCostUs(config.isrCostUs);
+    NativeHal::setFrameListener(onFrameLatched, this);
+    NativeHal::setPinLevel(PIN_ENCODER_Z, HIGH);
+
+    EEPROM.begin(512);
+    Encoder::getInstance()->initialize();
+    sorter->initialize();
+    DiameterScanner::getInstance()->initialize();
+    sorter->setControlTask(xTaskGetCurrentTaskHandle());
+    // 出口 0 也按直径分级，使 8 个出口都参与分流
+    sorter->setOutlet0Mode(1);
+
+    TraySnapshot snapshot;
+    TraySystem::getInstance()->getSnapshot(snapshot);
+    baseSequence = snapshot.headSequence;
+    takeMissedEvents();
+}
+
+float ConveyorSimulator::speedForTray(long tray) const {
+    if (tray < config.warmupTrays) return config.startTps;
+    long stepIndex = (tray - config.warmupTrays) / config.traysPerStep;
+    return config.startTps + stepIndex * config.stepTps;
+}
+
+const std::vector<SimStepResult>& ConveyorSimulator::runSweep() {
+    startCore();
+    results.clear();
+    trayFaults.clear();
+    activeStep = -1;
+
+    uint64_t cycleStartUs = 0;
+    for (long tray = 0;; tray++) {
+        float tps = speedForTray(tray);
+        if (tps > config.maxTps + 1e-4f) break;
+
+        if (tray >= config.warmupTrays && (tray - config.warmupTrays) % config.traysPerStep == 0) {
+            if (activeStep >= 0 && results[activeStep].failed() && config.stopAtFirstFailure) break;
+            SimStepResult next = {};
+            next.tps = tps;
+            results.push_back(next);
+            activeStep = (int)results.size() - 1;
+            sorter->resetEventLatency();
+        }
+
+        // 级间过渡：本级前 rampTrays 个托盘从上一级速度线性升到本级速度
+        long inStep = (tray - config.warmupTrays) % config.traysPerStep;
+        if (tray >= config.warmupTrays + config.traysPerStep && inStep < config.rampTrays) {
+            tps -= config.stepTps * (float)(config.rampTrays - inStep) / (float)(config.rampTrays + 1);
+        }
+        cyclePeriodUs = (uint64_t)(1e6f / tps + 0.5f);
+        runCycle(tray, cycleStartUs);
+        cycleStartUs += cyclePeriodUs;
+
+        if (step()) {
+            step()->trays++;
+            step()->missedEvents += takeMissedEvents();
+            uint32_t latency = sorter->getEventLatency().getMaxUs();
+            if (latency > step()->maxEventLatencyUs) step()->maxEventLatencyUs = latency;
+        } else {
+            takeMissedEvents();
+        }
+    }
+    return results;
+}
+
+// 一个托盘周期：200 个编码器边沿，其间穿插本托盘产品经过扫描传感器的边沿
+void ConveyorSimulator::runCycle(long cycle, uint64_t cycleStartUs) {
+    std::vector<SensorEvent> events;
+    buildSensorEvents(stream->at(cycle), cycleStartUs, events);
+
+    size_t next = 0;
+    for (int p = 1; p <= PHASES; p++) {
+        uint64_t edgeUs = cycleStartUs + (uint64_t)((double)cyclePeriodUs * p / PHASES + 0.5);
+        while (next < events.size() && events[next].timeUs < edgeUs) {
+            advanceUntil(events[next].timeUs);
+            NativeHal::setPinLevel(PINS_SCANNER[events[next].channel], events[next].level);
+            scheduleRunIfNotified();
+            next++;
+        }
+        advanceUntil(edgeUs);
+        stepEncoder();
+        scheduleRunIfNotified();
+
+        if (p % PHASES == PHASE_OUTLET_EXECUTE) checkDivergence(cycle);
+    }
+}
+
+// 产品居中于扫描窗口：光束被遮挡的相位宽度 = 直径 / 每相位位移；长度决定覆盖的通道数
+void ConveyorSimulator::buildSensorEvents(const SimProduct& product, uint64_t cycleStartUs,
+                                          std::vector<SensorEvent>& events) const {
+    if (product.count == 0) return;
+
+    int channels = (product.lengthMask == LEN_L) ? 4 : (product.lengthMask == LEN_M) ? 3 : 2;
+    float center = (PHASE_SCAN_START + PHASE_DATA_LATCH) / 2.0f + product.centerOffsetPhases;
+
+    for (int ch = 0; ch < channels; ch++) {
+        float widths[2];
+        float total = 0.0f;
+        for (int k = 0; k < product.count; k++) {
+            widths[k] = product.diameterDeciMm[k] / 10.0f / SCANNER_WEIGHTS[ch];
+            total += widths[k];
+        }
+        if (product.count > 1) total += DOUBLE_GAP_PHASES;
+
+        float start = center - total / 2.0f;
+        for (int k = 0; k < product.count; k++) {
+            float end = start + widths[k];
+            SensorEvent rise = {cycleStartUs + (uint64_t)((double)cyclePeriodUs * start / PHASES + 0.5), (uint8_t)ch, HIGH};
+            SensorEvent fall = {cycleStartUs + (uint64_t)((double)cyclePeriodUs * end / PHASES + 0.5), (uint8_t)ch, LOW};
+            events.push_back(rise);
+            events.push_back(fall);
+            start = end + DOUBLE_GAP_PHASES;
+        }
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const SensorEvent& a, const SensorEvent& b) { return a.timeUs < b.timeUs; });
+}
+
+void ConveyorSimulator::stepEncoder() {
+    quadratureIndex = (quadratureIndex + 1) & 3;
+    uint8_t state = QUADRATURE_SEQUENCE[quadratureIndex];
+    NativeHal::setPinLevel(PIN_ENCODER_A, (state >> 1) & 1);
+    NativeHal::setPinLevel(PIN_ENCODER_B, state & 1);
+    encoderCount++;
+
+    // Z 相：每 COUNTS_PER_Z 个计数一个下降沿脉冲
+    if (encoderCount % COUNTS_PER_Z == 0) {
+        NativeHal::setPinLevel(PIN_ENCODER_Z, LOW);
+        NativeHal::setPinLevel(PIN_ENCODER_Z, HIGH);
+    }
+}
+
+// ==========================================
+// 控制任务模型
+// ==========================================
+
+// 前进到 targetUs，期间按时间先后处理挂起中断、定时器与控制任务的运行
+void ConveyorSimulator::advanceUntil(uint64_t targetUs) {
+    for (;;) {
+        uint64_t next = (targetUs < nextRunUs) ? targetUs : nextRunUs;
+        uint64_t internalUs = 0;
+        if (NativeHal::nextEventUs(internalUs) && internalUs < next) {
+            NativeHal::advanceTo(internalUs);
+            scheduleRunIfNotified();
+            continue;
+        }
+        NativeHal::advanceTo(next);
+        scheduleRunIfNotified();
+        if (nextRunUs <= next) {
+            runControlTask();
+            continue;
+        }
+        if (next >= targetUs) break;
+    }
+}
+
+// 有挂起的通知时，控制任务在唤醒延迟之后（且上一次 run() 已结束）运行
+void ConveyorSimulator::scheduleRunIfNotified() {
+    if (NativeHal::getPendingNotifications(xTaskGetCurrentTaskHandle()) == 0) return;
+    uint64_t wakeUs = NativeHal::nowUs() + config.wakeLatencyUs;
+    if (wakeUs < taskFreeUs) wakeUs = taskFreeUs;
+    if (wakeUs < nextRunUs) nextRunUs = wakeUs;
+}
+
+// run() 在虚拟时间中瞬间完成，其耗时以控制任务忙碌的时段体现
+void ConveyorSimulator::runControlTask() {
+    ulTaskNotifyTake(pdTRUE, 0);
+    sorter->run();
+    DeferredLog::drain();   // 代替真机上的日志任务（串口回显关闭时输出被丢弃）
+    collectRecords();
+
+    uint64_t nowUs = NativeHal::nowUs();
+    taskFreeUs = nowUs + config.runCostUs;
+    nextRunUs = nowUs + (uint64_t)sorter->getWakeTimeoutTicks() * portTICK_PERIOD_MS * 1000;
+    if (nextRunUs < taskFreeUs) nextRunUs = taskFreeUs;
+}
+
+// 读取新推入的托盘记录（推入序号 = 扫描窗口序号 = 托盘序号）
+void ConveyorSimulator::collectRecords() {
+    TraySnapshot snapshot;
+    TraySystem::getInstance()->getSnapshot(snapshot);
+    uint32_t pushed = snapshot.headSequence - baseSequence;
+    while (records.size() < pushed) {
+        long tray = (long)records.size();
+        uint32_t position = pushed - 1 - (uint32_t)tray;
+        records.push_back(snapshot.at((int)position));
+        checkRecord(tray);
+    }
+}
+
+// ==========================================
+// 翻板状态（由 74HC595 帧推算）
+// ==========================================
+
+void ConveyorSimulator::onFrameLatched(void* context, const uint8_t* bytes, int length) {
+    if (length < BoardOutletWiring::CHAIN_LENGTH) return;
+    static_cast<ConveyorSimulator*>(context)->handleFrame(bytes);
+}
+
+void ConveyorSimulator::handleFrame(const uint8_t* bytes) {
+    uint64_t nowUs = NativeHal::nowUs();
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        const OutletWiring& wiring = BOARD_OUTLET_WIRING_TABLE[i];
+        bool open = (bytes[wiring.coilByte] >> wiring.openBit) & 1;
+        bool close = (bytes[wiring.coilByte] >> wiring.closeBit) & 1;
+        FlapState& flap = flaps[i];
+        if (open && !flap.openBit) {
+            flap.openStartUs = nowUs;
+            flap.everOpened = true;
+        }
+        if (close && !flap.closeBit) {
+            flap.closeStartUs = nowUs;
+            flap.everClosed = true;
+        }
+        flap.openBit = open;
+        flap.closeBit = close;
+    }
+}
+
+bool ConveyorSimulator::isFlapOpen(int outlet, uint64_t nowUs, uint64_t toleranceUs) const {
+    const FlapState& flap = flaps[outlet];
+    if (!flap.everOpened) return false;
+    if (flap.everClosed && flap.closeStartUs >= flap.openStartUs) return false;
+    return nowUs + toleranceUs >= flap.openStartUs + OUTLET_MECHANICAL_LATENCY_MS * 1000ULL;
+}
+
+bool ConveyorSimulator::isFlapClosed(int outlet, uint64_t nowUs, uint64_t toleranceUs) const {
+    const FlapState& flap = flaps[outlet];
+    if (!flap.everOpened) return true;
+    if (!flap.everClosed || flap.closeStartUs < flap.openStartUs) return false;
+    return nowUs + toleranceUs >= flap.closeStartUs + OUTLET_CLOSE_LATENCY_MS * 1000ULL;
+}
+
+// ==========================================
+// 检查
+// ==========================================
+
+// 锁存结果与产品实际情况比对
+void ConveyorSimulator::checkRecord(long tray) {
+    if (tray < config.warmupTrays || step() == nullptr) return;
+    const SimProduct& truth = stream->at(tray);
+    const TrayRecord& record = records[tray];
+
+    if (record.flags & TRAY_FLAG_FRAME_DROPPED) {
+        // 窗口未被采集：记录须为空托盘补位，丢帧本身已计入事件丢失
+        step()->droppedFrames++;
+        if (record.occupied) step()->misLatched++;
+        return;
+    }
+
+    bool ok;
+    if (truth.count == 0) {
+        ok = !record.occupied;
+    } else if (truth.count == 1) {
+        int error = (int)record.diameterDeciMm - (int)truth.diameterDeciMm[0];
+        ok = record.occupied && record.lengthLevel == truth.lengthMask &&
+             error <= config.diameterToleranceDeciMm && -error <= config.diameterToleranceDeciMm;
+    } else {
+        ok = record.occupied && record.lengthLevel == truth.lengthMask;
+    }
+    if (!ok) step()->misLatched++;
+}
+
+// 周期 cycle 的 PHASE_OUTLET_EXECUTE：位于出口 j 分流点的是周期 cycle - 1 - pos_j 扫描的托盘
+void ConveyorSimulator::checkDivergence(long cycle) {
+    if (step() == nullptr) return;
+    uint64_t nowUs = NativeHal::nowUs();
+    uint64_t toleranceUs = (uint64_t)(config.lateTolerancePhases * cyclePeriodUs / PHASES);
+
+    int firstPoint = TRAY_QUEUE_POSITIONS;
+    for (int j = 0; j < NUM_OUTLETS; j++) {
+        int pos = sorter->getOutletDivergencePoint(j);
+        if (pos < firstPoint) firstPoint = pos;
+    }
+
+    for (int j = 0; j < NUM_OUTLETS; j++) {
+        int pos = sorter->getOutletDivergencePoint(j);
+        long tray = cycle - 1 - pos;
+        if (tray < config.warmupTrays) continue;
+        if (stream->at(tray).count == 0) continue;
+
+        if (tray >= (long)records.size()) {
+            // 托盘到达第一个分流点时仍未完成判定：所有出口都来不及动作
+            if (pos == firstPoint) step()->lateOutlets++;
+            markTrayFault(tray);
+            continue;
+        }
+        uint8_t target = records[tray].outlet;
+        if (target == j) {
+            // 分流点按位置先后到达，此前途经的出口都已检查过
+            bool open = isFlapOpen(j, nowUs, toleranceUs);
+            if (!open) step()->lateOutlets++;
+            step()->sortedTrays++;
+            if (open && (tray >= (long)trayFaults.size() || !trayFaults[tray])) step()->correctDrops++;
+        } else if (target == TRAY_NO_OUTLET || pos < sorter->getOutletDivergencePoint(target)) {
+            if (!isFlapClosed(j, nowUs, toleranceUs)) {
+                step()->wrongDrops++;
+                markTrayFault(tray);
+            }
+        }
+    }
+}
+
+void ConveyorSimulator::markTrayFault(long tray) {
+    if (tray >= (long)trayFaults.size()) trayFaults.resize(tray + 1, 0);
+    trayFaults[tray] = 1;
+}
+
+// 自上次调用以来的事件丢失计数
+int ConveyorSimulator::takeMissedEvents() {
+    uint32_t coalesced = NativeHal::getCoalescedInterruptCount();
+    uint32_t illegal = Encoder::getInstance()->getIllegalTransitionCount();
+    uint32_t skipped = sorter->getSkippedPhaseCount();
+    uint32_t dropped = DiameterScanner::getInstance()->getDroppedFrameCount();
+    int missed = (int)((coalesced - baseCoalesced) + (illegal - baseIllegal) +
+                       (skipped - baseSkipped) + (dropped - baseDropped));
+    baseCoalesced = coalesced;
+    baseIllegal = illegal;
+    baseSkipped = skipped;
+    baseDropped = dropped;
+    return missed;
+}
+
+void ConveyorSimulator::printReport() const {
+    printf("[Sim] isr=%uus wake=%uus run=%uus, %d trays per step\n",
+           (unsigned)config.isrCostUs, (unsigned)config.wakeLatencyUs, (unsigned)config.runCostUs, config.traysPerStep);
+    printf("[Sim]  trays/s  trays  mislatched  dropped  missed  late  wrong  drop_ok%%  max_latency_us\n");
+    const SimStepResult* firstFailure = nullptr;
+    const SimStepResult* lastClean = nullptr;
+    for (size_t i = 0; i < results.size(); i++) {
+        const SimStepResult& r = results[i];
+        printf("[Sim] %8.2f  %5d  %10d  %7d  %6d  %4d  %5d  %7.1f  %14u%s\n", r.tps, r.trays, r.misLatched,
+               r.droppedFrames, r.missedEvents,
+               r.lateOutlets, r.wrongDrops, r.correctDropRate() * 100.0f, (unsigned)r.maxEventLatencyUs,
+               r.failed() ? "  FAIL" : "");
+        if (r.failed()) {
+            if (firstFailure == nullptr) firstFailure = &r;
+        } else if (firstFailure == nullptr) {
+            lastClean = &r;
+        }
+    }
+
+    if (firstFailure == nullptr) {
+        printf("[Sim] No failure up to %.2f trays/s\n", results.empty() ? 0.0f : results.back().tps);
+        return;
+    }
+    printf("[Sim] Throughput ceiling: %.2f trays/s (first failure at %.2f trays/s:%s%s%s%s)\n",
+           lastClean ? lastClean->tps : 0.0f, firstFailure->tps,
+           firstFailure->misLatched ? " mis-latched" : "", firstFailure->missedEvents ? " missed-events" : "",
+           firstFailure->lateOutlets ? " late-outlets" : "", firstFailure->wrongDrops ? " wrong-drops" : "");
+}
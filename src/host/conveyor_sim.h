@@ -0,0 +1,159 @@
+#ifndef CONVEYOR_SIM_H
+#define CONVEYOR_SIM_H
+
+#include <stdint.h>
+#include <vector>
+#include "../modular/sorter.h"
+
+/**
+ * 传送带仿真（仅 env:native）
+ *
+ * 按脚本化的产品流在虚拟时间中生成编码器 A/B/Z 边沿与 4 路扫描传感器波形，
+ * 通过 NativeHal 的引脚驱动真实的 Encoder / DiameterScanner ISR，并按事件驱动控制任务的方式调用 Sorter::run()。
+ * 传送带速度逐级升高（级间在若干托盘内线性过渡），每一级检查：
+ *   - 错误锁存：托盘记录与产品实际直径/长度/有无不符（带丢帧标记的记录单独计数，不算错误锁存）
+ *   - 事件丢失：中断合并、正交非法跳变、相位跳跃、扫描丢帧
+ *   - 出口迟到：托盘到达分流点 (PHASE_OUTLET_EXECUTE) 时目标翻板未完全打开
+ *   - 误分流：托盘经过非目标出口时该翻板未完全关闭
+ *   - 正确分流率：有目标出口的托盘中，途经的翻板都已关闭且目标翻板按时打开的比例
+ * 翻板状态由 74HC595 锁存帧中的线圈脉冲起始时刻加机械行程时间推算。
+ * 同样的脚本与参数每次得到完全相同的结果。
+ */
+
+// 单个托盘上的产品（count = 0 为空托盘，2 为双根）
+struct SimProduct {
+    uint8_t count;
+    uint16_t diameterDeciMm[2];
+    uint8_t lengthMask;             // LEN_S / LEN_M / LEN_L
+    int8_t centerOffsetPhases;      // 相对扫描窗口中心的偏移
+};
+
+/**
+ * 产品流：由脚本文件或伪随机种子生成，按托盘序号循环取用
+ * 脚本每行一个托盘："-" 空托盘；"12.5 M" 单根（直径 mm 与长度 S/M/L）；"10.0+14.0 L" 双根；# 开头为注释
+ */
+class ProductStream {
+public:
+    bool loadScript(const char* path);
+    void generate(uint32_t seed, int count, int gapPercent, int doublePercent);
+
+    const SimProduct& at(long tray) const { return products[tray % (long)products.size()]; }
+    int size() const { return (int)products.size(); }
+
+private:
+    std::vector<SimProduct> products;
+};
+
+struct SimConfig {
+    float startTps;                 // 起始速度（托盘/秒）
+    float stepTps;                  // 每级增量
+    float maxTps;
+    int traysPerStep;               // 每级运行的托盘数
+    int rampTrays;                  // 每级开始时从上一级速度线性升速的托盘数（实际传送带不会阶跃变速）
+    int warmupTrays;                // 起步阶段不做检查的托盘数
+    uint32_t isrCostUs;             // 每次 ISR 的服务耗时
+    uint32_t wakeLatencyUs;         // 通知到控制任务开始运行的延迟
+    uint32_t runCostUs;             // 每次 run() 占用控制任务的时间
+    int diameterToleranceDeciMm;    // 直径允许误差（亚相位插值后仅有取整误差，见 test_subphase_diameter）
+    float lateTolerancePhases;      // 翻板到位允许的迟到量（相位）
+    bool stopAtFirstFailure;
+
+    SimConfig()
+        : startTps(0.5f), stepTps(0.1f), maxTps(10.0f), traysPerStep(30), rampTrays(10), warmupTrays(4),
+          isrCostUs(4), wakeLatencyUs(20), runCostUs(300), diameterToleranceDeciMm(1),
+          lateTolerancePhases(2.0f), stopAtFirstFailure(true) {}
+};
+
+struct SimStepResult {
+    float tps;
+    int trays;
+    int misLatched;
+    int droppedFrames;              // 带 TRAY_FLAG_FRAME_DROPPED 标记的托盘记录数
+    int missedEvents;
+    int lateOutlets;
+    int wrongDrops;
+    int sortedTrays;                // 到达目标分流点的托盘数
+    int correctDrops;               // 其中正确落入目标出口的托盘数
+    uint32_t maxEventLatencyUs;
+
+    bool failed() const { return misLatched || missedEvents || lateOutlets || wrongDrops; }
+    float correctDropRate() const { return sortedTrays ? (float)correctDrops / sortedTrays : 1.0f; }
+};
+
+class ConveyorSimulator {
+public:
+    ConveyorSimulator(Sorter* sorter, const ProductStream* stream, const SimConfig& config);
+
+    // 启动核心并逐级升速，返回各级结果
+    const std::vector<SimStepResult>& runSweep();
+    void printReport() const;
+
+private:
+    static const int PHASES = ENCODER_MAX_PHASE;
+    static const uint64_t NEVER = ~0ULL;
+
+    // 翻板：最近一次打开/关闭线圈脉冲的起始时刻
+    struct FlapState {
+        uint64_t openStartUs;
+        uint64_t closeStartUs;
+        bool everOpened;
+        bool everClosed;
+        bool openBit;
+        bool closeBit;
+    };
+
+    struct SensorEvent {
+        uint64_t timeUs;
+        uint8_t channel;
+        uint8_t level;
+    };
+
+    Sorter* sorter;
+    const ProductStream* stream;
+    SimConfig config;
+    std::vector<SimStepResult> results;
+    int activeStep;                 // 当前级在 results 中的下标，起步阶段为 -1（不计入结果）
+
+    // 编码器
+    int quadratureIndex;
+    long encoderCount;
+
+    // 控制任务
+    uint64_t nextRunUs;
+    uint64_t taskFreeUs;
+
+    // 托盘记录（按扫描序号）
+    std::vector<TrayRecord> records;
+    uint32_t baseSequence;
+    std::vector<uint8_t> trayFaults; // 托盘已被误分流或判定迟到（按扫描序号）
+
+    FlapState flaps[NUM_OUTLETS];
+    uint64_t cyclePeriodUs;
+
+    // 事件丢失计数基准
+    uint32_t baseCoalesced, baseIllegal, baseSkipped, baseDropped;
+
+    void startCore();
+    float speedForTray(long tray) const;
+    void runCycle(long cycle, uint64_t cycleStartUs);
+    void buildSensorEvents(const SimProduct& product, uint64_t cycleStartUs, std::vector<SensorEvent>& events) const;
+    void stepEncoder();
+
+    void advanceUntil(uint64_t targetUs);
+    void scheduleRunIfNotified();
+    void runControlTask();
+    void collectRecords();
+
+    static void onFrameLatched(void* context, const uint8_t* bytes, int length);
+    void handleFrame(const uint8_t* bytes);
+    bool isFlapOpen(int outlet, uint64_t nowUs, uint64_t toleranceUs) const;
+    bool isFlapClosed(int outlet, uint64_t nowUs, uint64_t toleranceUs) const;
+
+    void checkRecord(long tray);
+    void checkDivergence(long cycle);
+    void markTrayFault(long tray);
+    int takeMissedEvents();
+    SimStepResult* step() { return (activeStep >= 0) ? &results[activeStep] : nullptr; }
+};
+
+#endif // CONVEYOR_SIM_H
@@ -0,0 +1,120 @@
+// 主机端入口（仅 env:native）
+// 运行传送带仿真：按产品流逐级提高带速，报告第一个出现错误锁存 / 事件丢失 / 出口迟到的速度；
+// 或回放现场导出的事件追踪，检查分拣判定能否复现。
+//
+// 用法：program [选项]
+//   --script FILE     产品脚本（默认按 --seed 生成）
+//   --seed N          伪随机产品流种子（默认 1）
+//   --start TPS       起始速度，托盘/秒（默认 0.5）
+//   --step TPS        每级增量（默认 0.1）
+//   --max TPS         最高速度（默认 10）
+//   --trays N         每级托盘数（默认 30）
+//   --isr-us N        每次 ISR 耗时（默认 4）
+//   --wake-us N       控制任务唤醒延迟（默认 20）
+//   --run-us N        每次 run() 耗时（默认 300）
+//   --all             出现失败后继续扫完所有速度
+//   --dump-trace      仿真结束后按现场格式导出事件追踪到标准输出
+//   --replay FILE     回放串口日志中的事件追踪（Hardware Diag > Dump Trace），判定不一致时返回 2
+
+#include <Arduino.h>
+#include <string.h>
+#include "conveyor_sim.h"
+#include "trace_replay.h"
+#include <native_hal.h>
+
+// 单元测试（pio test）与本入口一起编译，测试程序有自己的 main()
+#ifndef PIO_UNIT_TESTING
+
+Sorter sorter;
+
+namespace {
+
+const int GENERATED_PRODUCTS = 1000;
+const int GAP_PERCENT = 15;
+const int DOUBLE_PERCENT = 5;
+
+void printUsage(const char* program) {
+    printf("usage: %s [--script FILE] [--seed N] [--start TPS] [--step TPS] [--max TPS] [--trays N]\n"
+           "          [--isr-us N] [--wake-us N] [--run-us N] [--all] [--dump-trace]\n"
+           "       %s --replay FILE\n", program, program);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    const char* script = nullptr;
+    const char* replay = nullptr;
+    bool dumpTrace = false;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--all") == 0) {
+            config.stopAtFirstFailure = false;
+            continue;
+        }
+        if (strcmp(arg, "--dump-trace") == 0) {
+            dumpTrace = true;
+            continue;
+        }
+        if (value == nullptr) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--script") == 0) script = value;
+        else if (strcmp(arg, "--replay") == 0) replay = value;
+        else if (strcmp(arg, "--seed") == 0) seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "--start") == 0) config.startTps = (float)atof(value);
+        else if (strcmp(arg, "--step") == 0) config.stepTps = (float)atof(value);
+        else if (strcmp(arg, "--max") == 0) config.maxTps = (float)atof(value);
+        else if (strcmp(arg, "--trays") == 0) config.traysPerStep = atoi(value);
+        else if (strcmp(arg, "--isr-us") == 0) config.isrCostUs = (uint32_t)atoi(value);
+        else if (strcmp(arg, "--wake-us") == 0) config.wakeLatencyUs = (uint32_t)atoi(value);
+        else if (strcmp(arg, "--run-us") == 0) config.runCostUs = (uint32_t)atoi(value);
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (config.startTps <= 0.0f || config.stepTps <= 0.0f || config.traysPerStep <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (replay != nullptr) {
+        TraceDump dump;
+        if (!dump.load(replay)) {
+            printf("[Replay] Cannot load trace dump: %s\n", replay);
+            return 1;
+        }
+        TraceReplay traceReplay(&sorter, &dump);
+        bool passed = traceReplay.run().passed();
+        traceReplay.printReport();
+        return passed ? 0 : 2;
+    }
+
+    ProductStream stream;
+    if (script != nullptr) {
+        if (!stream.loadScript(script)) {
+            printf("[Sim] Cannot load product script: %s\n", script);
+            return 1;
+        }
+    } else {
+        stream.generate(seed, GENERATED_PRODUCTS, GAP_PERCENT, DOUBLE_PERCENT);
+    }
+
+    ConveyorSimulator simulator(&sorter, &stream, config);
+    simulator.runSweep();
+    if (dumpTrace) {
+        NativeHal::setSerialEcho(true);
+        sorter.dumpTrace();
+    } else {
+        simulator.printReport();
+    }
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,407 @@
+#include "trace_replay.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <native_hal.h>
+#include "../modular/deferred_log.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+// 正向格雷码序列（见 quadrature_decoder.h）：00 -> 01 -> 11 -> 10
+const uint8_t QUADRATURE_SEQUENCE[4] = {0x0, 0x1, 0x3, 0x2};
+const uint32_t DEFAULT_PERIOD_US = 1000;
+const uint32_t MAX_PERIOD_US = 100000;
+const int PREROLL_CYCLES = 2;
+const int MAX_REPORTED_MISMATCHES = 5;
+
+bool parseHex(const char* s, int digits, uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < digits; i++) {
+        char c = s[i];
+        uint32_t nibble;
+        if (c >= '0' && c <= '9') nibble = c - '0';
+        else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+        else return false;
+        value = (value << 4) | nibble;
+    }
+    return true;
+}
+
+// 从 from 前进到 to（只看正向、不足半圈的移动）是否越过 target（到达即越过）
+bool crossesPhase(int from, int to, int target) {
+    int distance = (to - from + ENCODER_MAX_PHASE) % ENCODER_MAX_PHASE;
+    if (distance == 0 || distance >= ENCODER_MAX_PHASE / 2) return false;
+    int offset = (target - from + ENCODER_MAX_PHASE) % ENCODER_MAX_PHASE;
+    return offset >= 1 && offset <= distance;
+}
+
+TrayRecord makeTrayRecord(const TraceRecord& latch, const TraceRecord& info) {
+    TrayRecord record;
+    record.outlet = latch.arg8;
+    record.diameterDeciMm = latch.arg16;
+    record.flags = info.arg8;
+    record.confidence = info.arg16 & 0xFF;
+    record.scanCount = (info.arg16 >> 8) & 0x0F;
+    record.lengthLevel = (info.arg16 >> 12) & 0x07;
+    record.occupied = (info.arg16 >> 15) & 0x01;
+    return record;
+}
+
+bool sameTrayRecord(const TrayRecord& a, const TrayRecord& b) {
+    return a.diameterDeciMm == b.diameterDeciMm && a.scanCount == b.scanCount &&
+           a.lengthLevel == b.lengthLevel && a.occupied == b.occupied &&
+           a.confidence == b.confidence && a.flags == b.flags && a.outlet == b.outlet;
+}
+
+void printTrayRecord(const char* label, const TrayRecord& r) {
+    printf("    %-6s d=%u n=%u len=%u occ=%u conf=%u flags=0x%02x outlet=%u\n", label,
+           r.diameterDeciMm, r.scanCount, r.lengthLevel, r.occupied, r.confidence, r.flags, r.outlet);
+}
+
+} // namespace
+
+// ==========================================
+// 导出解析
+// ==========================================
+
+TraceDump::TraceDump() : phaseOffset(0), outlet0Mode(0) {
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        outletMin[i] = 0;
+        outletMax[i] = 0;
+        outletLength[i] = LEN_ALL;
+    }
+}
+
+bool TraceDump::load(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+
+    bool begun = false;
+    bool ended = false;
+    char line[512];
+    while (!ended && fgets(line, sizeof(line), file) != nullptr) {
+        const char* tag = strstr(line, "[TRACE] ");
+        if (tag == nullptr) continue;
+        const char* body = tag + 8;
+
+        if (strncmp(body, "BEGIN", 5) == 0) {
+            *this = TraceDump();
+            begun = true;
+        } else if (!begun) {
+            continue;
+        } else if (strncmp(body, "END", 3) == 0) {
+            ended = true;
+        } else if (strncmp(body, "CONFIG", 6) == 0) {
+            sscanf(body, "CONFIG offset=%d outlet0Mode=%d", &phaseOffset, &outlet0Mode);
+        } else if (strncmp(body, "OUTLET", 6) == 0) {
+            int i, minD, maxD, length;
+            if (sscanf(body, "OUTLET %d min=%d max=%d len=%d", &i, &minD, &maxD, &length) == 4 &&
+                i >= 0 && i < NUM_OUTLETS) {
+                outletMin[i] = minD;
+                outletMax[i] = maxD;
+                outletLength[i] = length;
+            }
+        } else if (strncmp(body, "TRAY", 4) == 0) {
+            unsigned p, d, n, len, occ, conf, flags, outlet;
+            if (sscanf(body, "TRAY %u d=%u n=%u len=%u occ=%u conf=%u flags=%u outlet=%u",
+                       &p, &d, &n, &len, &occ, &conf, &flags, &outlet) == 8 && p < TRAY_QUEUE_POSITIONS) {
+                TrayRecord& r = trays[p];
+                r.diameterDeciMm = d;
+                r.scanCount = n;
+                r.lengthLevel = len;
+                r.occupied = occ;
+                r.confidence = conf;
+                r.flags = flags;
+                r.outlet = outlet;
+            }
+        } else if (strncmp(body, "D ", 2) == 0) {
+            const char* hex = body + 2;
+            uint32_t ts, type, arg8, arg16;
+            while (parseHex(hex, 8, ts) && parseHex(hex + 8, 2, type) &&
+                   parseHex(hex + 10, 2, arg8) && parseHex(hex + 12, 4, arg16)) {
+                TraceRecord r;
+                r.timestampUs = ts;
+                r.type = (uint8_t)type;
+                r.arg8 = (uint8_t)arg8;
+                r.arg16 = (uint16_t)arg16;
+                records.push_back(r);
+                hex += 16;
+            }
+        }
+    }
+    fclose(file);
+    return ended && !records.empty();
+}
+
+// ==========================================
+// 回放
+// ==========================================
+
+TraceReplay::TraceReplay(Sorter* sorter, const TraceDump* dump)
+    : sorter(sorter), dump(dump), result(), quadratureIndex(0), currentPhase(0), nextIdleRunUs(0),
+      preloadedTrays(0) {}
+
+// 回放起点：第一个越过扫描起始相位的相位记录；同时取起点附近的边沿周期作为预转速度
+int TraceReplay::findStart(uint32_t& periodUs) const {
+    const std::vector<TraceRecord>& records = dump->records;
+    int previous = -1;
+    int start = -1;
+    for (int i = 0; i < (int)records.size(); i++) {
+        if (records[i].type != TRACE_PHASE) continue;
+        int phase = records[i].arg16;
+        if (start < 0) {
+            if (previous >= 0 && crossesPhase(previous, phase, PHASE_SCAN_START)) start = i;
+        } else {
+            uint32_t period = records[i].timestampUs - records[start].timestampUs;
+            periodUs = (period > 0 && period <= MAX_PERIOD_US) ? period : DEFAULT_PERIOD_US;
+            return start;
+        }
+        previous = phase;
+    }
+    periodUs = DEFAULT_PERIOD_US;
+    return start;
+}
+
+void TraceReplay::startCore() {
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+    NativeHal::setPinLevel(PIN_ENCODER_Z, HIGH);
+
+    EEPROM.begin(512);
+    Encoder* encoder = Encoder::getInstance();
+    encoder->initialize();
+    sorter->initialize();
+    DiameterScanner::getInstance()->initialize();
+    sorter->setControlTask(xTaskGetCurrentTaskHandle());
+
+    // 与现场一致的零位偏移与出口配置
+    encoder->setPhaseOffset(dump->phaseOffset);
+    currentPhase = encoder->getCurrentPosition();
+    sorter->setOutlet0Mode(dump->outlet0Mode);
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        sorter->setOutletMinDiameter(i, dump->outletMin[i]);
+        sorter->setOutletMaxDiameter(i, dump->outletMax[i]);
+        sorter->setOutletTargetLength(i, dump->outletLength[i]);
+    }
+    nextIdleRunUs = 0;
+}
+
+// 还原起点时的托盘队列：导出快照中早于追踪内所有锁存的托盘，加上起点之前的锁存记录（均按先后顺序推入）
+void TraceReplay::preloadTrays(int start) {
+    const std::vector<TraceRecord>& records = dump->records;
+    int traceLatches = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].type == TRACE_LATCH) traceLatches++;
+    }
+
+    TraySystem* trays = TraySystem::getInstance();
+    preloadedTrays = 0;
+    for (int p = TRAY_QUEUE_POSITIONS - 1; p >= traceLatches; p--) {
+        trays->pushTray(dump->trays[p]);
+        preloadedTrays++;
+    }
+    const TraceRecord* latch = nullptr;
+    for (int i = 0; i < start; i++) {
+        if (records[i].type == TRACE_LATCH) {
+            latch = &records[i];
+        } else if (records[i].type == TRACE_LATCH_INFO && latch != nullptr) {
+            trays->pushTray(makeTrayRecord(*latch, records[i]));
+            preloadedTrays++;
+            latch = nullptr;
+        }
+    }
+}
+
+void TraceReplay::advanceUntil(uint64_t targetUs) {
+    for (;;) {
+        if (NativeHal::getPendingNotifications(xTaskGetCurrentTaskHandle()) > 0) {
+            runControlTask();
+            continue;
+        }
+        uint64_t next = (targetUs < nextIdleRunUs) ? targetUs : nextIdleRunUs;
+        uint64_t internalUs = 0;
+        if (NativeHal::nextEventUs(internalUs) && internalUs < next) {
+            NativeHal::advanceTo(internalUs);
+            continue;
+        }
+        NativeHal::advanceTo(next);
+        if (nextIdleRunUs <= next) {
+            runControlTask();
+            continue;
+        }
+        if (next >= targetUs) break;
+    }
+}
+
+// 控制任务在通知后立即运行：回放比较的是判定，不是调度延迟
+void TraceReplay::runControlTask() {
+    ulTaskNotifyTake(pdTRUE, 0);
+    sorter->run();
+    DeferredLog::drain();
+    nextIdleRunUs = NativeHal::nowUs() + (uint64_t)sorter->getWakeTimeoutTicks() * portTICK_PERIOD_MS * 1000;
+}
+
+void TraceReplay::stepEncoder(int direction) {
+    quadratureIndex = (quadratureIndex + direction) & 3;
+    uint8_t state = QUADRATURE_SEQUENCE[quadratureIndex];
+    NativeHal::setPinLevel(PIN_ENCODER_A, (state >> 1) & 1);
+    NativeHal::setPinLevel(PIN_ENCODER_B, state & 1);
+    currentPhase = (currentPhase + direction + ENCODER_MAX_PHASE) % ENCODER_MAX_PHASE;
+}
+
+// 按记录的逻辑相位驱动编码器；跳相按同一时刻的连续边沿重现
+void TraceReplay::moveEncoderTo(int phase) {
+    int delta = (phase - currentPhase + ENCODER_MAX_PHASE) % ENCODER_MAX_PHASE;
+    if (delta >= ENCODER_MAX_PHASE / 2) delta -= ENCODER_MAX_PHASE;
+    int direction = (delta > 0) ? 1 : -1;
+    for (int i = 0; i != delta; i += direction) {
+        stepEncoder(direction);
+    }
+}
+
+const ReplayResult& TraceReplay::run() {
+    result = ReplayResult();
+    const std::vector<TraceRecord>& records = dump->records;
+    uint32_t periodUs = DEFAULT_PERIOD_US;
+    int start = findStart(periodUs);
+    if (start < 0) return result;
+
+    // 1. 预转：以起点附近的速度转到起点前一个相位，让速度估计与扫描状态就绪
+    startCore();
+    int previousPhase = -1;
+    for (int i = start - 1; i >= 0 && previousPhase < 0; i--) {
+        if (records[i].type == TRACE_PHASE) previousPhase = records[i].arg16;
+    }
+    int prerollSteps = PREROLL_CYCLES * ENCODER_MAX_PHASE +
+                       (previousPhase - currentPhase + ENCODER_MAX_PHASE) % ENCODER_MAX_PHASE;
+    for (int i = 0; i < prerollSteps; i++) {
+        advanceUntil(NativeHal::nowUs() + periodUs);
+        stepEncoder(1);
+    }
+    advanceUntil(NativeHal::nowUs());
+
+    // 2. 还原托盘队列，清空预转期间的追踪
+    preloadTrays(start);
+    TraceRecorder* trace = TraceRecorder::getInstance();
+    trace->clear();
+
+    // 3. 按时间戳重放输入（输出类记录只用于比较）
+    uint64_t nowUs = NativeHal::nowUs() + periodUs;
+    for (size_t i = start; i < records.size(); i++) {
+        const TraceRecord& r = records[i];
+        if (i > (size_t)start) {
+            int32_t delta = (int32_t)(r.timestampUs - records[i - 1].timestampUs);
+            if (delta > 0) nowUs += (uint32_t)delta;  // 两核的记录可能略有交错，不回退时间
+        }
+        advanceUntil(nowUs);
+
+        if (r.type == TRACE_PHASE) {
+            for (int ch = 0; ch < 4; ch++) {
+                NativeHal::forcePinLevel(PINS_SCANNER[ch], (r.arg8 >> ch) & 1);
+            }
+            moveEncoderTo(r.arg16);
+        } else if (r.type == TRACE_SENSOR && r.arg8 < 4) {
+            NativeHal::setPinLevel(PINS_SCANNER[r.arg8], r.arg16 ? HIGH : LOW);
+        }
+        advanceUntil(nowUs);
+    }
+    advanceUntil(NativeHal::nowUs() + periodUs);
+
+    // 4. 比较
+    std::vector<TraceRecord> recorded(records.begin() + start, records.end());
+    std::vector<TraceRecord> replayed;
+    for (uint32_t i = 0; i < trace->getRetainedCount(); i++) {
+        replayed.push_back(trace->getRecord(i));
+    }
+    if (trace->getTotalCount() > trace->getRetainedCount()) {
+        printf("[Replay] Warning: replay overflowed the trace ring, early records lost\n");
+    }
+    compare(recorded, replayed);
+    return result;
+}
+
+// 提取锁存结果，并按锁存间隔（第 k 组为第 k 次锁存之前、第 k-1 次之后）分组线圈脉冲
+void TraceReplay::collect(const std::vector<TraceRecord>& records, std::vector<TrayRecord>& latches,
+                          std::vector<std::vector<uint8_t> >& pulses) {
+    latches.clear();
+    pulses.assign(1, std::vector<uint8_t>());
+    const TraceRecord* latch = nullptr;
+    for (size_t i = 0; i < records.size(); i++) {
+        const TraceRecord& r = records[i];
+        if (r.type == TRACE_LATCH) {
+            latch = &r;
+        } else if (r.type == TRACE_LATCH_INFO && latch != nullptr) {
+            latches.push_back(makeTrayRecord(*latch, r));
+            pulses.push_back(std::vector<uint8_t>());
+            latch = nullptr;
+        } else if (r.type == TRACE_PULSE) {
+            pulses.back().push_back(r.arg8);
+        }
+    }
+    for (size_t k = 0; k < pulses.size(); k++) {
+        std::sort(pulses[k].begin(), pulses[k].end());
+    }
+}
+
+void TraceReplay::compare(const std::vector<TraceRecord>& recorded, const std::vector<TraceRecord>& replayed) {
+    std::vector<TrayRecord> recordedLatches, replayedLatches;
+    std::vector<std::vector<uint8_t> > recordedPulses, replayedPulses;
+    collect(recorded, recordedLatches, recordedPulses);
+    collect(replayed, replayedLatches, replayedPulses);
+
+    result.recordedLatches = (int)recordedLatches.size();
+    result.replayedLatches = (int)replayedLatches.size();
+
+    // 导出时最后一个窗口可能尚未解码，只比较两边都有的部分
+    int common = std::min(result.recordedLatches, result.replayedLatches);
+    for (int k = 0; k < common; k++) {
+        result.comparedLatches++;
+        if (sameTrayRecord(recordedLatches[k], replayedLatches[k])) continue;
+        if (result.latchMismatches++ < MAX_REPORTED_MISMATCHES) {
+            printf("[Replay] Latch #%d differs:\n", k);
+            printTrayRecord("trace", recordedLatches[k]);
+            printTrayRecord("replay", replayedLatches[k]);
+        }
+    }
+
+    // 第 k 组在两边都已有第 k 次锁存时才完整；出口 i 的动作取决于分流点上的托盘，
+    // 只有该托盘已知（起点之后锁存或已还原）且保持状态收敛之后才参与比较。
+    // 回放从全部翻板关闭开始，而现场起点时翻板可能打开：无论还原了多少托盘，起点之后的前几组都不比较
+    for (int k = PULSE_SYNC_INTERVALS; k < common; k++) {
+        uint32_t eligible = 0;
+        for (int i = 0; i < NUM_OUTLETS; i++) {
+            int known = k - 1 - sorter->getOutletDivergencePoint(i) + preloadedTrays;
+            if (known >= PULSE_SYNC_INTERVALS) eligible |= 1u << i;
+        }
+        if (eligible == 0) continue;
+        std::vector<uint8_t> expected, actual;
+        for (size_t j = 0; j < recordedPulses[k].size(); j++) {
+            if (eligible & (1u << (recordedPulses[k][j] & 0x7F))) expected.push_back(recordedPulses[k][j]);
+        }
+        for (size_t j = 0; j < replayedPulses[k].size(); j++) {
+            if (eligible & (1u << (replayedPulses[k][j] & 0x7F))) actual.push_back(replayedPulses[k][j]);
+        }
+        result.comparedPulseIntervals++;
+        if (expected == actual) continue;
+        if (result.pulseMismatches++ < MAX_REPORTED_MISMATCHES) {
+            printf("[Replay] Pulses before latch #%d differ: trace=%d replay=%d\n", k,
+                   (int)expected.size(), (int)actual.size());
+        }
+    }
+}
+
+void TraceReplay::printReport() const {
+    printf("[Replay] records=%d latches: trace=%d replay=%d compared=%d mismatched=%d\n",
+           (int)dump->records.size(), result.recordedLatches, result.replayedLatches,
+           result.comparedLatches, result.latchMismatches);
+    printf("[Replay] pulse intervals: compared=%d mismatched=%d\n",
+           result.comparedPulseIntervals, result.pulseMismatches);
+    if (result.comparedLatches == 0) {
+        printf("[Replay] Nothing to compare: no complete scan window in the trace\n");
+    } else {
+        printf("[Replay] %s\n", result.passed() ? "Decisions reproduced" : "Decisions differ");
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <stdint.h>
+#include <vector>
+#include "../modular/sorter.h"
+
+/**
+ * 事件追踪回放（仅 env:native）
+ *
+ * 读取 Sorter::dumpTrace() 输出的串口日志（可混有其它输出，只解析 "[TRACE]" 行），
+ * 按记录的时间戳把编码器相位与扫描窗口内的传感器跳变重新施加到 NativeHal 引脚上，
+ * 由真实的 Encoder / DiameterScanner ISR 与 Sorter::run() 重新做出判定，再与追踪中的结果逐条比较：
+ *   - 锁存结果：直径、数量、长度、置信度、标志位与目标出口必须完全一致
+ *   - 线圈脉冲：按锁存间隔分组比较（出口与方向）；出口只在其分流点上的托盘已知、
+ *     且翻板保持状态收敛之后参与比较（环形缓冲只覆盖最近约 19 个托盘，远端出口可比较的周期较少）
+ *
+ * 回放从追踪中第一个完整扫描窗口的起点开始：之前的相位只用于确定起点，
+ * 起点时的托盘队列由导出的队列快照与起点之前的锁存记录还原。
+ */
+
+// 解析后的导出内容
+struct TraceDump {
+    int phaseOffset;
+    int outlet0Mode;
+    int outletMin[NUM_OUTLETS];
+    int outletMax[NUM_OUTLETS];
+    int outletLength[NUM_OUTLETS];
+    TrayRecord trays[TRAY_QUEUE_POSITIONS];     // 导出时的托盘队列（位置 0 为最新）
+    std::vector<TraceRecord> records;
+
+    TraceDump();
+    bool load(const char* path);
+};
+
+struct ReplayResult {
+    int comparedLatches;
+    int latchMismatches;
+    int comparedPulseIntervals;
+    int pulseMismatches;
+    int recordedLatches;                        // 起点之后追踪中的锁存数
+    int replayedLatches;                        // 回放产生的锁存数
+
+    bool passed() const { return latchMismatches == 0 && pulseMismatches == 0; }
+};
+
+class TraceReplay {
+public:
+    TraceReplay(Sorter* sorter, const TraceDump* dump);
+
+    // 执行回放并比较，返回结果
+    const ReplayResult& run();
+    void printReport() const;
+
+private:
+    // 分流点托盘已知之后翻板保持状态需要的收敛周期数（未知的保持标志最多沿空托盘延续前瞻窗口）
+    static const int PULSE_SYNC_INTERVALS = OUTLET_HOLD_LOOKAHEAD + 2;
+
+    Sorter* sorter;
+    const TraceDump* dump;
+    ReplayResult result;
+
+    int quadratureIndex;
+    int currentPhase;
+    uint64_t nextIdleRunUs;
+    int preloadedTrays;                 // 起点前还原到队列中的托盘数
+
+    int findStart(uint32_t& periodUs) const;
+    void startCore();
+    void preloadTrays(int start);
+    void advanceUntil(uint64_t targetUs);
+    void runControlTask();
+    void stepEncoder(int direction);
+    void moveEncoderTo(int phase);
+
+    static void collect(const std::vector<TraceRecord>& records, std::vector<TrayRecord>& latches,
+                        std::vector<std::vector<uint8_t> >& pulses);
+    void compare(const std::vector<TraceRecord>& recorded, const std::vector<TraceRecord>& replayed);
+};
+
+#endif // TRACE_REPLAY_H
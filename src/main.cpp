@@ -10,11 +10,13 @@
 #include "user_interface/menu_system.h"
 #include "modular/encoder.h"
 #include "modular/sorter.h"
+#include "modular/deferred_log.h"
 #include "handlers/scanner_diagnostic_handler.h"
 #include "handlers/outlet_diagnostic_handler.h"
 #include "handlers/encoder_diagnostic_handler.h"
 #include "handlers/config_handler.h"
 #include "handlers/hmi_diagnostic_handler.h"
+#include "handlers/profiler_diagnostic_handler.h"
 
 #include "system/menu_config.h"
 #include "system/system_manager.h"
@@ -33,6 +35,7 @@ Sorter sorter;
 ScannerDiagnosticHandler scannerDiagnosticHandler;
 OutletDiagnosticHandler outletDiagnosticHandler;
 EncoderDiagnosticHandler encoderDiagnosticHandler;
+ProfilerDiagnosticHandler profilerDiagnosticHandler;
 HMIDiagnosticHandler hmiDiagnosticHandler(UserInterface::getInstance());
 DiameterConfigHandler diameterConfigHandler(userInterface, &sorter);
 PhaseOffsetConfigHandler phaseOffsetConfigHandler(userInterface, &sorter);
@@ -44,10 +47,12 @@ String systemName = "Feng's AS-L9";
 // FreeRTOS 任务句柄
 TaskHandle_t hControlTask = nullptr;
 TaskHandle_t hUITask = nullptr;
+TaskHandle_t hLogTask = nullptr;
 
 // 任务函数声明
 void vControlTask(void* pvParameters);
 void vUITask(void* pvParameters);
+void vLogTask(void* pvParameters);
 
 void setup() {
     Serial.begin(115200);
@@ -95,6 +100,7 @@ void setup() {
     
     outletDiagnosticHandler.initialize(userInterface);
     encoderDiagnosticHandler.initialize(userInterface);
+    profilerDiagnosticHandler.initialize(userInterface);
     
     setupMenuTree();
     Serial.println("System ready");
@@ -124,23 +130,42 @@ void setup() {
         &hUITask,       // 句柄
         0               // 绑定到 Core 0
     );
+
+    // 3. 创建日志任务 (Core 0, 低优先级)：把 ISR / 控制路径写入的延迟日志送到串口
+    xTaskCreatePinnedToCore(
+        vLogTask,       // 任务函数
+        "LogTask",      // 任务名称
+        4096,           // 栈大小
+        nullptr,        // 参数
+        1,              // 优先级
+        &hLogTask,      // 句柄
+        0               // 绑定到 Core 0
+    );
 }
 
 void vControlTask(void* pvParameters) {
     TickType_t xLastWakeTime = xTaskGetTickCount();
-    const TickType_t xFrequency = pdMS_TO_TICKS(1); // 1ms 循环频率
+    const TickType_t xFrequency = pdMS_TO_TICKS(1); // 轮询模式：1ms 循环频率
 
-    Serial.println("[FreeRTOS] ControlTask (Core 1) started.");
+    Serial.printf("[FreeRTOS] ControlTask (Core 1) started (%s).\n",
+                  CONTROL_TASK_EVENT_DRIVEN ? "event-driven" : "1ms polling");
+    sorter.setControlTask(xTaskGetCurrentTaskHandle());
 
     for (;;) {
         // 分拣逻辑消费执行
-        // 只有在 Normal 模式或特定的分拣诊断模式下才运行逻辑处理槽
-        if (currentMode == MODE_NORMAL || currentMode == MODE_DIAGNOSE_OUTLET || currentMode == MODE_DIAGNOSE_SCANNER) {
+        // 只有在 Normal 模式或特定的分拣诊断模式下才运行逻辑处理槽（剖析页面需要分拣照常运行）
+        if (currentMode == MODE_NORMAL || currentMode == MODE_DIAGNOSE_OUTLET || currentMode == MODE_DIAGNOSE_SCANNER ||
+            currentMode == MODE_DIAGNOSE_PROFILER) {
             sorter.run();
         }
         
-        // 保持 1ms 的确定性节拍
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        if (CONTROL_TASK_EVENT_DRIVEN) {
+            // 阻塞直到相位事件 ISR 通知，或到达脉冲结束/空闲超时
+            ulTaskNotifyTake(pdTRUE, sorter.getWakeTimeoutTicks());
+        } else {
+            // 保持 1ms 的确定性节拍
+            vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        }
     }
 }
 
@@ -197,11 +222,26 @@ void vUITask(void* pvParameters) {
             }
         }
         
+        // 控制任务事件延迟分布（串口），用于比较事件驱动与轮询两种调度方式
+        static uint32_t lastLatencyReportMs = 0;
+        if (CONTROL_LATENCY_REPORT_MS > 0 && currentMode == MODE_NORMAL &&
+            currentMs - lastLatencyReportMs >= (uint32_t)CONTROL_LATENCY_REPORT_MS) {
+            lastLatencyReportMs = currentMs;
+            sorter.printEventLatencyReport();
+        }
+
         // 给系统任务（如 Watchdog/WiFi）留出时间，并维持约 30Hz 刷新
         vTaskDelay(pdMS_TO_TICKS(30));
     }
 }
 
+void vLogTask(void* pvParameters) {
+    for (;;) {
+        DeferredLog::drain();
+        vTaskDelay(pdMS_TO_TICKS(DEFERRED_LOG_DRAIN_MS));
+    }
+}
+
 // ==========================================
 // Arduino 框架要求
 // ==========================================
@@ -0,0 +1,185 @@
+#ifndef ACTUATION_SCHEDULER_H
+#define ACTUATION_SCHEDULER_H
+
+#include <stdint.h>
+
+/**
+ * 线圈脉冲起始调度（纯逻辑，无硬件依赖，时间由调用方传入）
+ *
+ * 多个出口在同一相位事件中换向时，若同时起动 H 桥脉冲，电源会出现很大的浪涌电流。
+ * 此调度器把 "请求" 与 "起动" 分开：
+ *   - 相邻两次起动至少间隔 staggerUs
+ *   - 同时通电的线圈数不超过 maxConcurrent
+ *   - 按截止时刻最早优先 (EDF) 起动；请求到达截止时刻时无视上述限制立即起动（计为强制起动），
+ *     保证翻板按时到位优先于限流
+ *   - 截止时刻按错峰间隔向前推算（第 k 个待起动请求最迟在 d_k - k * staggerUs 起动），
+ *     使被限流压后的请求在截止前仍逐个错开，而不是在同一时刻集中强制起动
+ * 线圈通电时段按起动时刻 + 脉宽推算，与 PulseScheduler 的脉冲截止一致。
+ * 时间比较按 32 位回绕处理。
+ *
+ * @tparam CHANNELS 通道数 (<= 32)
+ */
+template <int CHANNELS>
+class ActuationScheduler {
+public:
+    ActuationScheduler(int maxConcurrent, uint32_t staggerUs)
+        : maxConcurrent(maxConcurrent), staggerUs(staggerUs),
+          pendingMask(0), activeMask(0), lastStartUs(0), hasStarted(false) {
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            deadlineUs[ch] = 0;
+            widthUs[ch] = 0;
+            activeUntilUs[ch] = 0;
+        }
+        resetStats();
+    }
+
+    // 请求通道 ch 起动一个宽度为 width 的脉冲，最迟在 deadline 起动（覆盖该通道尚未起动的请求）
+    void request(int ch, uint32_t width, uint32_t deadline) {
+        widthUs[ch] = width;
+        deadlineUs[ch] = deadline;
+        pendingMask |= (1u << ch);
+    }
+
+    void cancel(int ch) { pendingMask &= ~(1u << ch); }
+    bool isPending(int ch) const { return (pendingMask >> ch) & 1; }
+
+    /**
+     * 在 nowUs 时刻起动所有允许起动的请求
+     * @return 本次应起动的通道位图（调用方据此真正发出脉冲）
+     */
+    uint32_t dispatch(uint32_t nowUs) {
+        retire(nowUs);
+        uint32_t started = 0;
+        while (pendingMask) {
+            int ch = earliestPending();
+            bool due = latestStartOffset(nowUs) <= 0;
+            bool slotFree = activeCount() < maxConcurrent &&
+                            (!hasStarted || nowUs - lastStartUs >= staggerUs);
+            if (!slotFree && !due) break;
+            if (!slotFree) forcedCount++;
+
+            pendingMask &= ~(1u << ch);
+            activeMask |= (1u << ch);
+            activeUntilUs[ch] = nowUs + widthUs[ch];
+            lastStartUs = nowUs;
+            hasStarted = true;
+            started |= (1u << ch);
+
+            int32_t slack = (int32_t)(deadlineUs[ch] - nowUs);
+            if (slack < minSlackUs) minSlackUs = slack;
+            if (slack < 0) missCount++;
+            int active = activeCount();
+            if (active > peakConcurrent) peakConcurrent = active;
+            dispatchedCount++;
+        }
+        return started;
+    }
+
+    /**
+     * 距下一次需要调用 dispatch() 的延迟
+     * @return 无待起动请求时返回 false
+     */
+    bool nextDelay(uint32_t nowUs, uint32_t& delayUs) {
+        if (!pendingMask) return false;
+        retire(nowUs);
+
+        // 最早可起动时刻：错峰间隔结束，且（已满额时）最早的线圈断电
+        int32_t ready = hasStarted ? (int32_t)(lastStartUs + staggerUs - nowUs) : 0;
+        if (activeCount() >= maxConcurrent) {
+            int32_t freeAt = earliestActiveEnd(nowUs);
+            if (freeAt > ready) ready = freeAt;
+        }
+        int32_t due = latestStartOffset(nowUs);
+        int32_t next = (due < ready) ? due : ready;
+        delayUs = (next > 0) ? (uint32_t)next : 0;
+        return true;
+    }
+
+    // 统计：同时通电线圈数峰值 / 起动时刻距截止时刻的最小余量 / 超过截止时刻的次数 / 无视限流的强制起动次数
+    int getPeakConcurrent() const { return peakConcurrent; }
+    int32_t getMinSlackUs() const { return dispatchedCount ? minSlackUs : 0; }
+    uint32_t getMissCount() const { return missCount; }
+    uint32_t getForcedCount() const { return forcedCount; }
+    uint32_t getDispatchedCount() const { return dispatchedCount; }
+
+    void resetStats() {
+        peakConcurrent = 0;
+        minSlackUs = INT32_MAX;
+        missCount = 0;
+        forcedCount = 0;
+        dispatchedCount = 0;
+    }
+
+private:
+    int maxConcurrent;
+    uint32_t staggerUs;
+    uint32_t pendingMask;
+    uint32_t activeMask;
+    uint32_t deadlineUs[CHANNELS];
+    uint32_t widthUs[CHANNELS];
+    uint32_t activeUntilUs[CHANNELS];
+    uint32_t lastStartUs;
+    bool hasStarted;
+
+    int peakConcurrent;
+    int32_t minSlackUs;
+    uint32_t missCount;
+    uint32_t forcedCount;
+    uint32_t dispatchedCount;
+
+    // 移除已断电的线圈
+    void retire(uint32_t nowUs) {
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if ((activeMask >> ch) & 1) {
+                if ((int32_t)(nowUs - activeUntilUs[ch]) >= 0) activeMask &= ~(1u << ch);
+            }
+        }
+    }
+
+    int activeCount() const { return __builtin_popcount(activeMask); }
+
+    int earliestPending() const {
+        int best = -1;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if (!isPending(ch)) continue;
+            if (best < 0 || (int32_t)(deadlineUs[ch] - deadlineUs[best]) < 0) best = ch;
+        }
+        return best;
+    }
+
+    // 队首请求的最迟起动时刻（相对 nowUs）：min_k (d_k - k * staggerUs)，d_k 为第 k 早的截止时刻
+    int32_t latestStartOffset(uint32_t nowUs) const {
+        int32_t offsets[CHANNELS];
+        int n = 0;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if (!isPending(ch)) continue;
+            int32_t v = (int32_t)(deadlineUs[ch] - nowUs);
+            int j = n++;
+            while (j > 0 && offsets[j - 1] > v) {
+                offsets[j] = offsets[j - 1];
+                j--;
+            }
+            offsets[j] = v;
+        }
+        int32_t latest = offsets[0];
+        for (int k = 1; k < n; k++) {
+            int32_t v = offsets[k] - (int32_t)(k * staggerUs);
+            if (v < latest) latest = v;
+        }
+        return latest;
+    }
+
+    int32_t earliestActiveEnd(uint32_t nowUs) const {
+        int32_t best = 0;
+        bool found = false;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if (!((activeMask >> ch) & 1)) continue;
+            int32_t remaining = (int32_t)(activeUntilUs[ch] - nowUs);
+            if (!found || remaining < best) best = remaining;
+            found = true;
+        }
+        return best;
+    }
+};
+
+#endif // ACTUATION_SCHEDULER_H
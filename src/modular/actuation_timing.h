@@ -0,0 +1,95 @@
+#ifndef ACTUATION_TIMING_H
+#define ACTUATION_TIMING_H
+
+#include <stdint.h>
+
+/**
+ * 出口动作时序补偿（纯函数，无硬件依赖）
+ *
+ * 翻板从脉冲开始到完全到位需要一段机械行程时间。传送带越快，这段时间对应的相位越多，
+ * 若仍在固定相位触发，翻板到位时托盘已越过分流点。此处按实测速度把机械延迟换算为
+ * 相位提前量，使翻板在托盘到达分流点 (PHASE_OUTLET_EXECUTE) 时恰好完全打开。
+ */
+
+struct ActuationPhases {
+    int executePhase;   // 打开脉冲的触发相位
+    int resetPhase;     // 关闭脉冲的触发相位
+};
+
+/**
+ * 将机械延迟换算为相位提前量
+ * @param traysPerSecond 传送带速度（托架/秒），非正值视为静止
+ * @param latencyMs 机械行程时间
+ * @param phasesPerTray 每个托架的相位数
+ */
+inline int latencyToLeadPhases(float traysPerSecond, uint32_t latencyMs, int phasesPerTray) {
+    if (traysPerSecond <= 0.0f) return 0;
+    return (int)(traysPerSecond * (float)phasesPerTray * (float)latencyMs / 1000.0f + 0.5f);
+}
+
+/**
+ * 计算补偿后的打开/关闭触发相位
+ *
+ * - 打开：executeTarget - lead，但不早于锁存相位之后 1 个相位（决策尚未产生时不能动作）
+ * - 关闭：在名义复位相位与 "下一托盘到达前完成闭合" 之间取较早者（按关闭行程的提前量），
+ *         且不早于 executeTarget + minDropPhases（保证当前物体有足够的下落窗口）
+ *
+ * @param executeTarget 翻板需完全打开的相位 (PHASE_OUTLET_EXECUTE)
+ * @param resetNominal  名义关闭相位 (PHASE_OUTLET_RESET)
+ * @param latchPhase    数据锁存相位 (PHASE_DATA_LATCH)
+ * @param range         每周期相位数
+ * @param minDropPhases 打开后保持的最小相位数
+ * @param openLeadPhases  打开行程对应的相位提前量
+ * @param closeLeadPhases 关闭行程对应的相位提前量
+ */
+inline ActuationPhases computeActuationPhases(int executeTarget, int resetNominal, int latchPhase,
+                                              int range, int minDropPhases, int openLeadPhases,
+                                              int closeLeadPhases) {
+    ActuationPhases result;
+
+    // 打开：提前量受 "锁存 -> 执行" 窗口限制
+    int window = executeTarget - latchPhase;
+    if (window <= 0) window += range;
+    int openLead = (openLeadPhases < window - 1) ? openLeadPhases : window - 1;
+    if (openLead < 0) openLead = 0;
+    int exec = executeTarget - openLead;
+    result.executePhase = (exec < 0) ? exec + range : exec;
+
+    // 关闭：以 executeTarget 为原点展开到同一周期内计算
+    int nominal = resetNominal - executeTarget;
+    if (nominal <= 0) nominal += range;
+    int latest = range - closeLeadPhases;     // 下一托盘到达分流点前闭合完成
+    int reset = (nominal < latest) ? nominal : latest;
+    if (reset < minDropPhases) reset = minDropPhases;
+    reset += executeTarget;
+    result.resetPhase = reset % range;
+
+    return result;
+}
+
+/**
+ * 由触发事件推算线圈脉冲的最迟起动时刻
+ *
+ * 翻板须在托盘下一次到达分流点 (targetPhase) 之前到位：从触发相位向前到 targetPhase 的行程时间
+ * 减去机械行程时间，即为起动调度器可以推迟的余量。余量不足（高速时提前量被锁存窗口截断）时返回 eventUs，
+ * 请求到达即强制起动；速度未知（静止）时托盘不会到达，返回 eventUs + idleSlackUs。
+ *
+ * @param eventUs        触发事件时刻
+ * @param eventPhase     触发相位
+ * @param targetPhase    翻板须到位的相位 (PHASE_OUTLET_EXECUTE)
+ * @param range          每周期相位数
+ * @param traysPerSecond 传送带速度（托架/秒）
+ * @param latencyMs      本次行程（打开或关闭）的机械行程时间
+ * @param idleSlackUs    静止时允许的推迟
+ */
+inline uint32_t actuationDeadlineUs(uint32_t eventUs, int eventPhase, int targetPhase, int range,
+                                    float traysPerSecond, uint32_t latencyMs, uint32_t idleSlackUs) {
+    if (traysPerSecond <= 0.0f) return eventUs + idleSlackUs;
+    int phases = targetPhase - eventPhase;
+    if (phases < 0) phases += range;
+    float travelUs = (float)phases * 1000000.0f / (traysPerSecond * (float)range);
+    float slackUs = travelUs - (float)latencyMs * 1000.0f;
+    return (slackUs > 0.0f) ? eventUs + (uint32_t)slackUs : eventUs;
+}
+
+#endif // ACTUATION_TIMING_H
@@ -0,0 +1,60 @@
+#include "cycle_profiler.h"
+#include <Arduino.h>
+
+ProbeStats CycleProfiler::stats[PROBE_COUNT];
+
+namespace {
+
+const char* const PROBE_NAMES[PROBE_COUNT] = {
+    "EncISR", "PhaseCb", "Sample", "SensISR",
+    "Run", "Decode", "Prepare", "ShiftUpd", "ShiftTx", "PulseTmr"
+};
+
+// 静态初始化时清零统计（min 需要初值）
+struct ProfilerInit {
+    ProfilerInit() { CycleProfiler::reset(); }
+} profilerInit;
+
+} // namespace
+
+const char* CycleProfiler::getName(ProfileProbe probe) {
+    return (probe >= 0 && probe < PROBE_COUNT) ? PROBE_NAMES[probe] : "?";
+}
+
+void CycleProfiler::reset() {
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        stats[i].reset();
+    }
+}
+
+uint32_t CycleProfiler::cyclesToDeciUs(uint32_t cycles) {
+    uint32_t mhz = getCpuFrequencyMhz();
+    return mhz ? (uint32_t)((uint64_t)cycles * 10 / mhz) : 0;
+}
+
+void CycleProfiler::printReport() {
+    if (!CYCLE_PROFILER_ENABLED) {
+        Serial.println("[Profiler] Disabled (CYCLE_PROFILER_ENABLED = false)");
+        return;
+    }
+    Serial.printf("[Profiler] CPU %u MHz, cycles per probe (min/avg/max):\n", getCpuFrequencyMhz());
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        ProfileProbe probe = (ProfileProbe)i;
+        const ProbeStats& s = stats[i];
+        uint32_t maxDeciUs = cyclesToDeciUs(s.maxCycles);
+        Serial.printf("  %-8s n=%-8u min=%-6u avg=%-6u max=%-7u (%u.%uus)\n", getName(probe), s.count,
+                      s.getMinCycles(), s.getAverageCycles(), s.maxCycles, maxDeciUs / 10, maxDeciUs % 10);
+        if (s.count == 0) continue;
+        Serial.print("   ");
+        for (int b = 0; b < ProbeStats::BUCKET_COUNT; b++) {
+            if (s.buckets[b] == 0) continue;
+            uint32_t upper = ProbeStats::bucketUpperBound(b);
+            if (upper) {
+                Serial.printf(" <%u:%u", upper, s.buckets[b]);
+            } else {
+                Serial.printf(" >=%u:%u", ProbeStats::bucketUpperBound(b - 1), s.buckets[b]);
+            }
+        }
+        Serial.println();
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef CYCLE_PROFILER_H
+#define CYCLE_PROFILER_H
+
+#include <stdint.h>
+#include <xtensa/hal.h>
+#include "../config.h"
+
+// 剖析探针（名称见 CycleProfiler::getName）
+enum ProfileProbe {
+    // ISR 路径（外层包含内层）
+    PROBE_ENCODER_ISR = 0,      // Encoder::handleABPhaseInterrupt
+    PROBE_PHASE_CALLBACK,       // Sorter::onPhaseChange（采样 + 相位事件）
+    PROBE_SCANNER_SAMPLE,       // DiameterScanner::sample
+    PROBE_SENSOR_ISR,           // DiameterScanner::onSensorChange
+    // 控制任务 / 定时器
+    PROBE_CONTROL_RUN,          // Sorter::run 整体
+    PROBE_LATCH_DECODE,         // 单帧解码 + 出口判定 + 入队（含 prepareOutlets）
+    PROBE_PREPARE_OUTLETS,      // Sorter::prepareOutlets
+    PROBE_UPDATE_SHIFT,         // Sorter::updateShiftRegisters（组帧）
+    PROBE_FLUSH_SHIFT,          // Sorter::flushShiftRegisters（发送）
+    PROBE_PULSE_TIMER,          // Sorter::handlePulseTimer
+    PROBE_COUNT
+};
+
+/**
+ * 单个探针的周期统计（纯逻辑，无动态内存）
+ *
+ * 以 2 的幂分桶：桶 0 为 0 周期，桶 b (b >= 1) 为 [2^(b-1), 2^b)，最后一个桶收纳所有更大的值
+ * （约 1ms @240MHz）。每个探针只由一个执行上下文写入；其它任务读取时可能看到略有不一致的计数，只用于诊断显示。
+ */
+struct ProbeStats {
+    static const int BUCKET_COUNT = 20;
+
+    uint32_t count;
+    uint64_t sumCycles;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint32_t buckets[BUCKET_COUNT];
+
+    void reset() {
+        count = 0;
+        sumCycles = 0;
+        minCycles = 0xFFFFFFFFu;
+        maxCycles = 0;
+        for (int b = 0; b < BUCKET_COUNT; b++) buckets[b] = 0;
+    }
+
+    inline void record(uint32_t cycles) {
+        int b = (cycles == 0) ? 0 : 32 - __builtin_clz(cycles);
+        if (b >= BUCKET_COUNT) b = BUCKET_COUNT - 1;
+        buckets[b]++;
+        count++;
+        sumCycles += cycles;
+        if (cycles < minCycles) minCycles = cycles;
+        if (cycles > maxCycles) maxCycles = cycles;
+    }
+
+    uint32_t getAverageCycles() const { return count ? (uint32_t)(sumCycles / count) : 0; }
+    uint32_t getMinCycles() const { return count ? minCycles : 0; }
+
+    // 桶 b 的上界（周期，不含），最后一个桶返回 0 表示无上界
+    static uint32_t bucketUpperBound(int b) {
+        return (b >= BUCKET_COUNT - 1) ? 0 : (1u << b);
+    }
+};
+
+/**
+ * 热路径周期剖析
+ *
+ * 在函数或代码块开头放置 PROFILE_SCOPE(探针)，作用域结束时把 CCOUNT 差值计入该探针。
+ * 每次测量两次读 CCOUNT 加一次分桶统计，约几十个周期；CYCLE_PROFILER_ENABLED 为 false 时整段被编译消除。
+ * CCOUNT 是每个核独立的计数器，探针的开始与结束必须在同一核上（ISR 与控制任务均满足）。
+ */
+class CycleProfiler {
+public:
+    static inline void record(ProfileProbe probe, uint32_t cycles) { stats[probe].record(cycles); }
+    static const ProbeStats& get(ProfileProbe probe) { return stats[probe]; }
+    static const char* getName(ProfileProbe probe);
+    static void reset();
+
+    // 周期数换算为 0.1us（按当前 CPU 频率）
+    static uint32_t cyclesToDeciUs(uint32_t cycles);
+
+    // 串口输出所有探针的统计与非空直方图桶
+    static void printReport();
+
+private:
+    static ProbeStats stats[PROBE_COUNT];
+};
+
+// 作用域计时器：构造时读 CCOUNT，析构时记录
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileProbe probe) : probe(probe), start(CYCLE_PROFILER_ENABLED ? xthal_get_ccount() : 0) {}
+    ~ProfileScope() {
+        if (CYCLE_PROFILER_ENABLED) CycleProfiler::record(probe, xthal_get_ccount() - start);
+    }
+
+private:
+    ProfileProbe probe;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(probe) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(probe)
+
+#endif // CYCLE_PROFILER_H
@@ -0,0 +1,77 @@
+#include "deferred_log.h"
+#include <Arduino.h>
+
+DeferredLog::Slot DeferredLog::slots[CAPACITY];
+std::atomic<uint32_t> DeferredLog::head(0);
+uint32_t DeferredLog::tail = 0;
+std::atomic<uint32_t> DeferredLog::dropped(0);
+uint32_t DeferredLog::reportedDropped = 0;
+
+namespace {
+
+// 静态初始化时设置槽位序号（早于任何任务与中断）
+struct DeferredLogInit {
+    DeferredLogInit() { DeferredLog::reset(); }
+} deferredLogInit;
+
+} // namespace
+
+void DeferredLog::reset() {
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    head.store(0, std::memory_order_relaxed);
+    tail = 0;
+    dropped.store(0, std::memory_order_relaxed);
+    reportedDropped = 0;
+}
+
+bool DeferredLog::push(const char* format, const uint32_t* values, int count) {
+    uint32_t pos = head.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots[pos & (CAPACITY - 1)];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            // 槽位空闲：抢占写位置（失败时 pos 被更新为最新值后重试）
+            if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // 日志任务尚未取走一整圈之前的记录：缓冲已满
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->format = format;
+    for (int i = 0; i < MAX_ARGS; i++) {
+        slot->args[i] = (i < count) ? values[i] : 0;
+    }
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+int DeferredLog::drain() {
+    int printed = 0;
+    while (true) {
+        Slot& slot = slots[tail & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1) break;
+
+        const uint32_t* a = slot.args;
+        Serial.printf(slot.format, a[0], a[1], a[2], a[3], a[4], a[5]);
+
+        // 归还槽位给下一圈的写位置
+        slot.sequence.store(tail + CAPACITY, std::memory_order_release);
+        tail++;
+        printed++;
+    }
+
+    uint32_t total = dropped.load(std::memory_order_relaxed);
+    if (total != reportedDropped) {
+        Serial.printf("[LOG] %u messages dropped (total %u)\n", total - reportedDropped, total);
+        reportedDropped = total;
+    }
+    return printed;
+}
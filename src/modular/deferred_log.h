@@ -0,0 +1,71 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <stdint.h>
+#include <atomic>
+#include <type_traits>
+#include "../config.h"
+
+static_assert(DEFERRED_LOG_CAPACITY > 0 && (DEFERRED_LOG_CAPACITY & (DEFERRED_LOG_CAPACITY - 1)) == 0,
+              "DEFERRED_LOG_CAPACITY must be a power of two");
+
+/**
+ * 延迟日志（无锁多生产者 / 单消费者环形缓冲）
+ *
+ * - 写入：只保存格式串指针与最多 MAX_ARGS 个 32 位整型参数，不做任何格式化；
+ *   每个槽位带序号，生产者以 CAS 取得槽位（多核、多任务同时写入安全），缓冲满时立即丢弃并计数，从不阻塞
+ * - 输出：drain() 由日志任务（Core 0，低优先级）周期调用，按写入顺序格式化后送到串口，并报告新增的丢弃数
+ * - 格式串必须是字符串常量（只保存指针）；参数只支持整数/枚举，对应 %d %u %x %c（不支持 %s、%f、%ld）
+ */
+class DeferredLog {
+public:
+    static const int MAX_ARGS = 6;
+    static const uint32_t CAPACITY = DEFERRED_LOG_CAPACITY;
+
+    template <typename... Args>
+    static inline void write(const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "DeferredLog supports at most MAX_ARGS arguments");
+        uint32_t values[MAX_ARGS] = { toArg(args)... };
+        push(format, values, sizeof...(Args));
+    }
+
+    // 格式化并输出所有待处理记录（单一消费者），返回输出条数
+    static int drain();
+
+    static uint32_t getDroppedCount() { return dropped.load(std::memory_order_relaxed); }
+
+    // 槽位序号初始化（静态初始化时调用一次，不能与写入并发）
+    static void reset();
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;     // == 写位置：空闲；== 写位置 + 1：已写入待输出
+        const char* format;
+        uint32_t args[MAX_ARGS];
+    };
+
+    static Slot slots[CAPACITY];
+    static std::atomic<uint32_t> head;      // 下一个写位置（生产者竞争）
+    static uint32_t tail;                   // 下一个读位置（仅日志任务）
+    static std::atomic<uint32_t> dropped;
+    static uint32_t reportedDropped;
+
+    template <typename T>
+    static inline uint32_t toArg(T value) {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                      "DeferredLog arguments must be integers");
+        return (uint32_t)value;
+    }
+
+    static bool push(const char* format, const uint32_t* values, int count);
+};
+
+// 日志宏：级别在编译期过滤，被过滤的调用（含参数求值）整体消除
+#define LOG_AT(level, ...) \
+    do { if ((level) <= DEFERRED_LOG_LEVEL) DeferredLog::write(__VA_ARGS__); } while (0)
+#define LOG_ERROR(...)  LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)   LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(...)   LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...)  LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#endif // DEFERRED_LOG_H
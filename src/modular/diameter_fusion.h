@@ -0,0 +1,96 @@
+#ifndef DIAMETER_FUSION_H
+#define DIAMETER_FUSION_H
+
+#include <stdint.h>
+
+/**
+ * 多通道直径融合（纯函数，无硬件依赖）
+ *
+ * 4 个扫描通道在物体经过时都会测得一段脉宽，只要被遮挡，每个通道都是一次独立的直径测量。
+ * 融合步骤：
+ *   1. 低于最小直径的通道视为未覆盖，不参与投票
+ *   2. 取中位数作为参考值，与中位数偏差超过容差的通道判为离群值并剔除
+ *   3. 剩余通道取平均值（截尾平均）作为输出直径
+ *   4. 置信度 = 一致通道占比 × 100，再按一致通道之间的离散程度扣分；
+ *      仅有单通道时无法交叉验证，给固定的中等置信度
+ */
+
+static const int FUSION_MAX_CHANNELS = 4;
+static const uint8_t FUSION_SINGLE_CHANNEL_CONFIDENCE = 60;
+
+struct FusionResult {
+    int diameterDeciMm;     // 融合直径 (0.1mm)，无有效通道为 0
+    uint8_t confidence;     // 0-100，无有效通道为 0
+    uint8_t channelMask;    // 参与融合（未被剔除）的通道 (bit i = 通道 i)
+};
+
+/**
+ * @param channelDeciMm 各通道已校准的直径 (0.1mm)
+ * @param channelCount  通道数 (<= FUSION_MAX_CHANNELS)
+ * @param minDeciMm     最小有效直径，低于此值视为该通道未被遮挡
+ * @param toleranceDeciMm 与中位数的最大允许偏差
+ */
+inline FusionResult fuseChannelDiameters(const int* channelDeciMm, int channelCount,
+                                         int minDeciMm, int toleranceDeciMm) {
+    FusionResult result = {0, 0, 0};
+    if (channelCount > FUSION_MAX_CHANNELS) channelCount = FUSION_MAX_CHANNELS;
+
+    // 1. 收集有效通道并按直径排序（插入排序，最多 4 个元素）
+    int values[FUSION_MAX_CHANNELS];
+    int channels[FUSION_MAX_CHANNELS];
+    int n = 0;
+    for (int i = 0; i < channelCount; i++) {
+        int v = channelDeciMm[i];
+        if (v < minDeciMm) continue;
+        int j = n++;
+        while (j > 0 && values[j - 1] > v) {
+            values[j] = values[j - 1];
+            channels[j] = channels[j - 1];
+            j--;
+        }
+        values[j] = v;
+        channels[j] = i;
+    }
+    if (n == 0) return result;
+
+    // 2. 中位数（偶数个取中间两个的平均）
+    int median = (n & 1) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2] + 1) / 2;
+
+    // 3. 剔除离群值后取平均
+    int sum = 0;
+    int inliers = 0;
+    int lo = 0;
+    int hi = 0;
+    for (int k = 0; k < n; k++) {
+        int dev = values[k] - median;
+        if (dev < 0) dev = -dev;
+        if (dev > toleranceDeciMm) continue;
+        if (inliers == 0) lo = values[k];
+        hi = values[k];
+        sum += values[k];
+        inliers++;
+        result.channelMask |= (uint8_t)(1 << channels[k]);
+    }
+
+    if (inliers == 0) {
+        // 各通道互不一致：给出中位数，但置信度为 0
+        result.diameterDeciMm = median;
+        return result;
+    }
+    result.diameterDeciMm = (sum + inliers / 2) / inliers;
+
+    // 4. 置信度
+    if (n == 1) {
+        result.confidence = FUSION_SINGLE_CHANNEL_CONFIDENCE;
+        return result;
+    }
+    int confidence = inliers * 100 / n;
+    if (toleranceDeciMm > 0) {
+        confidence -= (hi - lo) * 50 / toleranceDeciMm; // 离散度等于容差时扣 50
+    }
+    if (confidence < 0) confidence = 0;
+    result.confidence = (uint8_t)confidence;
+    return result;
+}
+
+#endif // DIAMETER_FUSION_H
@@ -1,20 +1,43 @@
 #include "diameter_scanner.h"
+#include "diameter_fusion.h"
+#include "cycle_profiler.h"
+#include "deferred_log.h"
+#include <soc/gpio_reg.h>
+#include <esp_timer.h>
 // #include "user_interface/oled.h"
 
 // 初始化静态实例变量为NULL
 // DiameterScanner* DiameterScanner::instance = NULL; // Managed by Singleton template
 
+// 4 个扫描通道均位于 GPIO32-39，可由一次 GPIO_IN1_REG 读取同时获得
+static_assert(PIN_SCANNER_1 >= 32 && PIN_SCANNER_2 >= 32 && PIN_SCANNER_3 >= 32 && PIN_SCANNER_4 >= 32,
+              "Scanner channels must be on GPIO32-39");
+static const int SCANNER_IN1_SHIFT[4] = {
+    PIN_SCANNER_1 - 32, PIN_SCANNER_2 - 32, PIN_SCANNER_3 - 32, PIN_SCANNER_4 - 32
+};
+
 DiameterScanner::DiameterScanner() : 
     isScanning(false),
+    captureFrame(nullptr),
+    displayFrame(0),
+    latchCount(0),
+    droppedFrames(0),
+    edgeOverflowCount(0),
+    requestedCaptureMode(SCANNER_EDGE_CAPTURE ? SCAN_CAPTURE_EDGES : SCAN_CAPTURE_BITSET),
+    edgeClock(nullptr),
+    lastSampleTicks(0),
+    trace(TraceRecorder::getInstance()),
+    diameterDeciMm(0),
+    confidence(0),
+    fusedChannelMask(0),
     nominalDiameter(0) {
     for (int i = 0; i < 4; i++) {
         scannerPins[i] = PINS_SCANNER[i];
         highLevelPulseCounts[i] = 0;
         objectCount[i] = 0;
         lastSensorStates[i] = false;
-        isObjectPassing[i] = false;
+        finePulseWidths[i] = 0;
     }
-    lastPhase = -1;
 }
 
 // 实现单例模式的getInstance方法 - Managed by Singleton template
@@ -24,6 +47,12 @@ void DiameterScanner::initialize() {
     for (int i = 0; i < 4; i++) {
         pinMode(scannerPins[i], INPUT);
     }
+
+    // 传感器跳变中断：记录跳变时刻，用于亚相位插值（非扫描窗口内直接返回）
+    attachInterrupt(digitalPinToInterrupt(scannerPins[0]), handleSensor0Change, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(scannerPins[1]), handleSensor1Change, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(scannerPins[2]), handleSensor2Change, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(scannerPins[3]), handleSensor3Change, CHANGE);
     
     // 移除 initialize() 中的 start() 调用，确保开机时处于受控的静默状态。
     // 真正的扫描开启将由 Sorter 在探测到 Phase 50 时触发。
@@ -32,27 +61,51 @@ void DiameterScanner::initialize() {
 }
 
 void DiameterScanner::start() {
-    isScanning = true;
-    nominalDiameter = 0;
-    sampleCount = 0;
-    for (int i = 0; i < 4; i++) {
-        highLevelPulseCounts[i] = 0;
-        objectCount[i] = 0;
-        lastSensorStates[i] = false;
-        isObjectPassing[i] = false;
+    isScanning = false;
+    ScanFrame* frame = captureFrame;
+
+    // 上一窗口未锁存（例如启动时处于窗口中途）：直接复用当前采集帧
+    if (frame == nullptr) {
+        for (int i = 0; i < FRAME_COUNT; i++) {
+            uint8_t expected = SCAN_FRAME_FREE;
+            if (frames[i].state.compare_exchange_strong(expected, SCAN_FRAME_CAPTURING)) {
+                frame = &frames[i];
+                break;
+            }
+        }
+    }
+    if (frame == nullptr) {
+        // 两个缓冲均未被解码：放弃本窗口，锁存时由任务侧按空托盘补位
+        droppedFrames++;
+        return;
     }
-    lastPhase = -1;
+
+    frame->clear();
+    frame->sequence = latchCount.load();
+    frame->captureMode = requestedCaptureMode;
+    captureFrame = frame;
+    isScanning = true; // 缓冲区清零后再开启，避免 ISR 写入旧窗口残留
 }
 
-void DiameterScanner::stop() {
+void DiameterScanner::latch() {
     isScanning = false;
+    ScanFrame* frame = captureFrame;
+    captureFrame = nullptr;
+    if (frame != nullptr) {
+        frame->state.store(SCAN_FRAME_READY); // 所有权移交控制任务
+    }
+    latchCount.fetch_add(1);
 }
 
 void DiameterScanner::sample(int phase) {
+    PROFILE_SCOPE(PROBE_SCANNER_SAMPLE);
     if (!isScanning) return;
+    ScanFrame* frame = captureFrame;
+    if (frame == nullptr) return;
     
     // 终极同步过滤器：只有当相位确实"向前进"时，才进行采样。
     // 修复：回绕检测不依赖固定的 199->0，而是检测任意大幅负跳变（超过半圈视为合法回绕）
+    int lastPhase = frame->lastPhase;
     bool isForward = false;
     if (lastPhase == -1) {
         isForward = true; // 第一次采样，无条件允许
@@ -63,88 +116,184 @@ void DiameterScanner::sample(int phase) {
     }
     
     if (!isForward) return; // 过滤震动回弹或重复触发
-    lastPhase = phase;
+    frame->lastPhase = phase;
     
-    // 仅通过数组记录采样点的原始高低电平状态，极大地降低中断开销
-    if (sampleCount < MAX_SAMPLES) {
+    // 一次寄存器读取获得全部通道电平
+    int idx = frame->sampleCount;
+    uint8_t levels = readPackedLevels();
+
+    // 亚相位跟踪：本次采样对应的边沿时刻作为插值原点；
+    // 若采样看到的电平与跳变中断跟踪的不一致（窗口起始已为高电平或中断尚未处理），以整相位补记
+    lastSampleTicks = (edgeClock != nullptr) ? edgeClock->getLastEdgeTicks() : 0;
+    uint8_t missed = levels ^ frame->fineLevels;
+    if (missed) {
         for (int i = 0; i < 4; i++) {
-            sensorBuffers[i][sampleCount] = (digitalRead(scannerPins[i]) == HIGH) ? 1 : 0;
+            if (missed & (1 << i)) recordFineEdge(frame, i, (levels >> i) & 1, (int32_t)idx << SCAN_SUBPHASE_SHIFT);
         }
-        sampleCount++;
+    }
+
+    if (frame->captureMode == SCAN_CAPTURE_EDGES) {
+        sampleEdges(frame, idx, levels);
+    } else {
+        sampleBitset(frame, idx, levels);
     }
 }
 
-int DiameterScanner::getDiameterAndStop() {
-    // 必须首先调用 stop()，确保在后续计算过程中不再有中断累加。
-    // 在 Sorter::onPhaseChange 中理应已调用过一次 stop()，此处为双重保险。
-    stop(); 
-    
-    // 初始化计算状态变量，清零旧数据
+// 位图模式：仅在高电平时置位对应位（start() 已清零）
+void DiameterScanner::sampleBitset(ScanFrame* frame, int idx, uint8_t levels) {
+    if (idx >= ScanFrame::MAX_SAMPLES) return;
+    uint32_t bit = 1u << (idx & 31);
+    int word = idx >> 5;
     for (int i = 0; i < 4; i++) {
-        highLevelPulseCounts[i] = 0;
-        objectCount[i] = 0;
-        lastSensorStates[i] = false;
-        isObjectPassing[i] = false;
+        if (levels & (1 << i)) frame->sensorBits[i][word] |= bit;
     }
+    frame->sampleCount = idx + 1;
+}
 
-    // 后期处理：遍历缓存区，回放采样历史，计算有效高电平脉冲计数
-    for (int idx = 0; idx < sampleCount; idx++) {
+// 边沿模式：电平无变化时只累加采样序号，有变化时每个变化通道追加一条记录
+void DiameterScanner::sampleEdges(ScanFrame* frame, int idx, uint8_t levels) {
+    if (idx >= ScanFrame::MAX_EDGE_SAMPLES) return;
+    uint8_t changed = levels ^ frame->lastLevels;
+    if (changed) {
+        int n = frame->edgeCount;
         for (int i = 0; i < 4; i++) {
-            bool currentState = (sensorBuffers[i][idx] == 1);
-            
-            if (currentState) {
-                if (!isObjectPassing[i]) {
-                    isObjectPassing[i] = true;
-                    highLevelPulseCounts[i] = 0; // 一旦新物体遮挡，重新计数
-                }
-                highLevelPulseCounts[i]++;
-            } else {
-                if (isObjectPassing[i]) {
-                    isObjectPassing[i] = false;
-                    // 当传感器从高电平变为低电平时，计数加一（物体通过）
-                    objectCount[i]++;
-                }
+            if (!(changed & (1 << i))) continue;
+            if (n >= SCANNER_MAX_EDGES) {
+                // 缓冲区满：丢弃后续边沿（不覆盖已有记录，保证已记录部分的解码仍然正确）
+                edgeOverflowCount++;
+                continue;
             }
+            frame->edges[n].sampleIndex = (uint16_t)idx;
+            frame->edges[n].channel = (uint8_t)i;
+            frame->edges[n].level = (levels >> i) & 1;
+            n++;
         }
+        frame->edgeCount = n;
+        frame->lastLevels = levels;
     }
-    
-    // [DIAGNOSTIC LOG] 输出原始计数值和缓冲区大小
-    Serial.printf("[SCANNER_DEBUG] Raw Counts: CH0:%d, CH1:%d, CH2:%d, CH3:%d | LastPhase:%d, Samples:%d\n", 
-                  highLevelPulseCounts[0], highLevelPulseCounts[1], highLevelPulseCounts[2], highLevelPulseCounts[3], lastPhase, sampleCount.load());
-    
-    //在此处执行计算逻辑
-    float correctedCounts[2];
-    int validCount = 0;
-            
-    for (int i = 0; i < 2; i++) {
-        correctedCounts[i] = highLevelPulseCounts[i] * SCANNER_WEIGHTS[i];
-        
-        if (correctedCounts[i] >= SCANNER_MIN_DIAMETER_UNIT) {
-            validCount++;
-        }
+    frame->sampleCount = idx + 1;
+}
+
+void IRAM_ATTR DiameterScanner::recordFineEdge(ScanFrame* frame, int channel, uint8_t level, int32_t position) {
+    if (level) {
+        frame->fineRise[channel] = position;
+        frame->fineLevels |= (1 << channel);
+    } else {
+        frame->fineFall[channel] = position;
+        frame->fineLevels &= ~(1 << channel);
     }
-            
-    if (validCount > 0) {
-        float validValues[2];
-        int validIndex = 0;
-        
-        for (int i = 0; i < 2; i++) {
-            if (correctedCounts[i] >= SCANNER_MIN_DIAMETER_UNIT) {
-                validValues[validIndex++] = correctedCounts[i];
-            }
+}
+
+// 传感器跳变中断：按距最近一次采样的时间与编码器边沿周期，定位到相位小数部分
+void IRAM_ATTR DiameterScanner::onSensorChange(int channel) {
+    PROFILE_SCOPE(PROBE_SENSOR_ISR);
+    if (!isScanning) return;
+    ScanFrame* frame = captureFrame;
+    if (frame == nullptr) return;
+    uint8_t level = (readPackedLevels() >> channel) & 1;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    trace->record(TRACE_SENSOR, now, channel, level);
+
+    int idx = frame->sampleCount;
+    if (idx == 0) return; // 窗口内尚未采样，由第 0 次采样确定初始电平
+    if (level == ((frame->fineLevels >> channel) & 1)) return; // 抖动或已由采样补记
+
+    int32_t frac = 0;
+    if (edgeClock != nullptr) {
+        frac = interpolateSubPhase(now - lastSampleTicks, edgeClock->getLastPeriodTicks());
+    }
+    recordFineEdge(frame, channel, level, ((int32_t)(idx - 1) << SCAN_SUBPHASE_SHIFT) + frac);
+}
+
+void IRAM_ATTR DiameterScanner::handleSensor0Change() { getInstance()->onSensorChange(0); }
+void IRAM_ATTR DiameterScanner::handleSensor1Change() { getInstance()->onSensorChange(1); }
+void IRAM_ATTR DiameterScanner::handleSensor2Change() { getInstance()->onSensorChange(2); }
+void IRAM_ATTR DiameterScanner::handleSensor3Change() { getInstance()->onSensorChange(3); }
+
+uint8_t IRAM_ATTR DiameterScanner::readPackedLevels() {
+    uint32_t in = REG_READ(GPIO_IN1_REG);
+    return ((in >> SCANNER_IN1_SHIFT[0]) & 1)
+         | (((in >> SCANNER_IN1_SHIFT[1]) & 1) << 1)
+         | (((in >> SCANNER_IN1_SHIFT[2]) & 1) << 2)
+         | (((in >> SCANNER_IN1_SHIFT[3]) & 1) << 3);
+}
+
+bool DiameterScanner::decodeFrame(uint32_t sequence) {
+    // 1. 取得指定序号的已锁存帧的所有权
+    ScanFrame* frame = nullptr;
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        if (frames[i].sequence != sequence) continue;
+        uint8_t expected = SCAN_FRAME_READY;
+        if (frames[i].state.compare_exchange_strong(expected, SCAN_FRAME_DECODING)) {
+            frame = &frames[i];
+            displayFrame = i;
+            break;
         }
-        
-        if (validCount == 1) {
-            nominalDiameter = (int)(validValues[0] + 0.5f);
-        } else if (validCount == 2) {
-            // 取平均值
-            nominalDiameter = (int)((validValues[0] + validValues[1]) / 2.0f + 0.5f);
+    }
+
+    if (frame == nullptr) {
+        // 该窗口未被采集（丢帧）：结果清零，按空托盘处理
+        for (int i = 0; i < 4; i++) {
+            highLevelPulseCounts[i] = 0;
+            objectCount[i] = 0;
+            finePulseWidths[i] = 0;
         }
-    } else {
+        diameterDeciMm = 0;
         nominalDiameter = 0;
+        confidence = 0;
+        fusedChannelMask = 0;
+        return false;
     }
+    
+    // 2. 后期处理：得到每个通道最后一个物体的高电平脉宽与完整通过的物体数
+    //   位图模式：按 32 位字并行解码（移位边沿检测 + popcount）
+    //   边沿模式：直接遍历边沿列表，O(edges)
+    int samples = frame->sampleCount;
+    ScanChannelResult results[4];
+    if (frame->captureMode == SCAN_CAPTURE_EDGES) {
+        decodeEdgeList(frame->edges, frame->edgeCount, samples, results, 4);
+    } else {
+        for (int i = 0; i < 4; i++) {
+            results[i] = decodeChannelBits(frame->sensorBits[i], samples);
+        }
+    }
+    int32_t endPos = (int32_t)samples << SCAN_SUBPHASE_SHIFT;
+    for (int i = 0; i < 4; i++) {
+        highLevelPulseCounts[i] = results[i].pulseWidth;
+        objectCount[i] = results[i].objectCount;
+        finePulseWidths[i] = finePulseWidth(frame->fineRise[i], frame->fineFall[i], endPos);
+    }
+    
+    // [DIAGNOSTIC LOG] 输出原始计数值、亚相位脉宽 (x1/256) 和缓冲区大小（延迟日志每条最多 6 个参数，分两行）
+    LOG_DEBUG("[SCANNER_DEBUG] Raw Counts: CH0:%d, CH1:%d, CH2:%d, CH3:%d\n",
+              highLevelPulseCounts[0], highLevelPulseCounts[1], highLevelPulseCounts[2], highLevelPulseCounts[3]);
+    LOG_DEBUG("[SCANNER_DEBUG] Fine: %d, %d | LastPhase:%d, Samples:%d\n",
+              (int)finePulseWidths[0], (int)finePulseWidths[1], frame->lastPhase, samples);
+    
+    // 3. 多通道融合：所有被遮挡的通道按各自校准换算为 0.1mm 后投票，剔除离群值并给出置信度
+    int channelDeciMm[4];
+    for (int i = 0; i < 4; i++) {
+        if (finePulseWidths[i] <= 0) {
+            channelDeciMm[i] = 0; // 未被遮挡，不施加零点校准
+            continue;
+        }
+        float mm = finePulseWidths[i] * SCANNER_WEIGHTS[i] / (float)SCAN_SUBPHASE_ONE;
+        channelDeciMm[i] = (int)(mm * 10.0f + 0.5f) + SCANNER_OFFSETS_DECI_MM[i];
+    }
+    FusionResult fusion = fuseChannelDiameters(channelDeciMm, 4, SCANNER_MIN_DIAMETER_UNIT * 10,
+                                               SCANNER_FUSION_TOLERANCE_DECI_MM);
+    confidence = fusion.confidence;
+    fusedChannelMask = fusion.channelMask;
+
+    diameterDeciMm = fusion.diameterDeciMm;
+    nominalDiameter = (diameterDeciMm + 5) / 10;
 
-    return nominalDiameter;
+    LOG_DEBUG("[SCANNER_DEBUG] Fused: %d.%d mm, Confidence:%d, Channels:0x%X\n",
+              diameterDeciMm / 10, diameterDeciMm % 10, confidence, fusedChannelMask);
+
+    // 4. 释放缓冲（波形诊断仍可读取，直到该缓冲被下一窗口复用）
+    frame->state.store(SCAN_FRAME_FREE);
+    return true;
 }
 
 // 获取物体的长度级别 (返回 LengthMask 位掩码)
@@ -162,6 +311,17 @@ int DiameterScanner::getLengthLevel() {
     return LEN_S;
 }
 
+uint8_t DiameterScanner::getSample(int sensorIndex, int sampleIndex) const {
+    const ScanFrame& frame = frames[displayFrame];
+    if (sensorIndex < 0 || sensorIndex >= 4 || sampleIndex < 0 || sampleIndex >= frame.sampleCount) {
+        return 0;
+    }
+    if (frame.captureMode == SCAN_CAPTURE_EDGES) {
+        return edgeListLevelAt(frame.edges, frame.edgeCount, sensorIndex, sampleIndex);
+    }
+    return (frame.sensorBits[sensorIndex][sampleIndex >> 5] >> (sampleIndex & 31)) & 1;
+}
+
 int DiameterScanner::getObjectCount(int index) const {
     if (index >= 0 && index < 4) {
         return objectCount[index];
@@ -201,6 +361,13 @@ bool* DiameterScanner::getIOStatusArray() {
     return currentStates;
 }
 
+int32_t DiameterScanner::getFinePulseWidth(int index) const {
+    if (index >= 0 && index < 4) {
+        return finePulseWidths[index];
+    }
+    return 0;
+}
+
 int DiameterScanner::getHighLevelPulseCount(int index) const {
     if (index >= 0 && index < 4) {
         return highLevelPulseCounts[index];
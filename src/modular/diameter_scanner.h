@@ -6,6 +6,71 @@
 #include <atomic>
 
 #include "../utils/singleton.h"
+#include "scan_decoder.h"
+#include "speed_estimator.h"
+#include "trace_recorder.h"
+
+// 扫描采集模式
+enum ScanCaptureMode {
+    SCAN_CAPTURE_BITSET = 0,    // 每个相位记录 1 bit / 通道，窗口长度受 MAX_SAMPLES 限制
+    SCAN_CAPTURE_EDGES = 1      // 仅记录电平变化 (采样序号, 通道, 电平)，窗口长度不受缓冲区限制
+};
+
+// 扫描帧状态（乒乓缓冲所有权）
+enum ScanFrameState {
+    SCAN_FRAME_FREE = 0,        // 空闲，可被 ISR 用于下一次采集
+    SCAN_FRAME_CAPTURING,       // ISR 正在采集（扫描起始 -> 锁存）
+    SCAN_FRAME_READY,           // 已锁存，等待任务解码
+    SCAN_FRAME_DECODING         // 任务正在解码
+};
+
+/**
+ * 单个扫描窗口的采集数据
+ * 采集期间仅由 ISR 写入，锁存后所有权通过 state 原子地移交给控制任务
+ */
+struct ScanFrame {
+    static const int MAX_SAMPLES = 200;
+    static const int SAMPLE_WORDS = (MAX_SAMPLES + 31) / 32;
+    static const int MAX_EDGE_SAMPLES = 65535; // 采样序号以 uint16_t 存储
+
+    std::atomic<uint8_t> state;
+    uint32_t sequence;                         // 对应的锁存序号
+    uint8_t captureMode;                       // 本帧使用的采集模式
+    volatile int sampleCount;
+    volatile int lastPhase;                    // 记录上一次处理的相位 (ISR 内部使用)
+
+    // 采样缓冲区：每通道一个位图，1 bit / 采样点（位图模式）
+    volatile uint32_t sensorBits[4][SAMPLE_WORDS];
+
+    // 边沿列表缓冲区（边沿模式）
+    volatile ScanEdge edges[SCANNER_MAX_EDGES];
+    volatile int edgeCount;
+    volatile uint8_t lastLevels;               // 上一采样点的 4 通道电平
+
+    // 亚相位测量：最后上升/下降沿位置（定点数，1 采样 = 256，-1 = 无）
+    volatile uint8_t fineLevels;               // 亚相位跟踪的当前电平 (bit i = 通道 i)
+    volatile int32_t fineRise[4];
+    volatile int32_t fineFall[4];
+
+    ScanFrame() : state(SCAN_FRAME_FREE), sequence(0), captureMode(SCAN_CAPTURE_BITSET),
+                  sampleCount(0), lastPhase(-1), edgeCount(0), lastLevels(0), fineLevels(0) {}
+
+    // 清空采集数据（ISR 在开始采集前调用）
+    void clear() {
+        sampleCount = 0;
+        lastPhase = -1;
+        edgeCount = 0;
+        lastLevels = 0;
+        fineLevels = 0;
+        for (int i = 0; i < 4; i++) {
+            fineRise[i] = -1;
+            fineFall[i] = -1;
+            for (int w = 0; w < SAMPLE_WORDS; w++) {
+                sensorBits[i][w] = 0;
+            }
+        }
+    }
+};
 
 class DiameterScanner : public Singleton<DiameterScanner> {
     friend class Singleton<DiameterScanner>;
@@ -24,12 +89,40 @@ private:
     
     // 上一次的传感器状态（每个扫描点）
     bool lastSensorStates[4];
-    volatile int lastPhase; // 记录上一次处理的相位 (ISR 内部使用)
-    volatile bool isObjectPassing[4];
 
-    static const int MAX_SAMPLES = 200;
-    volatile uint8_t sensorBuffers[4][MAX_SAMPLES];
-    std::atomic<int> sampleCount;
+    // 乒乓缓冲：ISR 采集一帧的同时，控制任务解码另一帧
+    static const int FRAME_COUNT = 2;
+    ScanFrame frames[FRAME_COUNT];
+    ScanFrame* volatile captureFrame;          // 当前采集帧，未采集时为 nullptr
+    int displayFrame;                          // 最近一次解码的帧（供波形诊断显示）
+    std::atomic<uint32_t> latchCount;          // 累计锁存次数（即帧序号）
+    volatile uint32_t droppedFrames;           // 因无空闲缓冲而未能采集的窗口数
+    volatile uint32_t edgeOverflowCount;       // 因缓冲区满而丢弃的边沿数（累计）
+
+    // 新窗口使用的采集模式（下一次 start() 时生效）
+    std::atomic<uint8_t> requestedCaptureMode;
+
+    void sampleBitset(ScanFrame* frame, int idx, uint8_t levels);
+    void sampleEdges(ScanFrame* frame, int idx, uint8_t levels);
+
+    // 亚相位插值
+    const SpeedEstimator* edgeClock;           // 编码器边沿时间戳来源
+    volatile uint32_t lastSampleTicks;         // 最近一次采样对应的编码器边沿时间戳
+
+    TraceRecorder* trace;                      // 扫描窗口内的传感器跳变写入事件追踪
+
+    // 解码结果（控制任务写入）
+    int32_t finePulseWidths[4];                // 定点脉宽
+    int diameterDeciMm;                        // 计算得到的直径 (0.1mm)
+    uint8_t confidence;                        // 多通道融合置信度 (0-100)
+    uint8_t fusedChannelMask;                  // 参与融合的通道 (bit i = 通道 i)
+
+    void recordFineEdge(ScanFrame* frame, int channel, uint8_t level, int32_t position);
+    void onSensorChange(int channel);
+    static void handleSensor0Change();
+    static void handleSensor1Change();
+    static void handleSensor2Change();
+    static void handleSensor3Change();
 
     // 计算得到的直径值（整数）
     int nominalDiameter;
@@ -45,11 +138,11 @@ public:
     // 初始化引脚和缓冲区
     void initialize();
     
-    // 重置状态和缓冲区
+    // 扫描起始（ISR 上下文）：取一个空闲缓冲开始采集，无空闲缓冲则记为丢帧
     void start();
     
-    // 停止扫描计数
-    void stop();
+    // 数据锁存（ISR 上下文）：停止采集，将当前帧移交给控制任务，锁存序号加一
+    void latch();
 
     // 检查是否正在扫描
     bool isScanningActive() const { return isScanning; }
@@ -57,8 +150,33 @@ public:
     // 采样传感器状态（根据相位进行采样）- 用于直径测量
     void sample(int phase);
     
-    // 获取计算的直径值（整数）并停止扫描 (Calculation moved here)
-    int getDiameterAndStop();
+    // 累计锁存次数；序号小于该值的帧均已锁存
+    uint32_t getLatchCount() const { return latchCount.load(); }
+
+    /**
+     * 解码指定锁存序号的帧（控制任务调用）并释放其缓冲
+     * @return 解码成功返回 true；该窗口因丢帧未被采集时返回 false，结果清零
+     */
+    bool decodeFrame(uint32_t sequence);
+
+    // 因无空闲缓冲（解码落后超过一帧）而丢弃的窗口数
+    uint32_t getDroppedFrameCount() const { return droppedFrames; }
+
+    // 获取最近一次解码的直径（整数 mm）
+    int getDiameter() const { return nominalDiameter; }
+
+    // 获取最近一次解码的直径 (0.1mm)
+    int getDiameterDeciMm() const { return diameterDeciMm; }
+
+    // 获取最近一次直径的融合置信度 (0-100) 及参与融合的通道掩码
+    uint8_t getConfidence() const { return confidence; }
+    uint8_t getFusedChannelMask() const { return fusedChannelMask; }
+
+    // 设置编码器边沿时间戳来源（用于传感器跳变的亚相位插值），为空时退化为整相位精度
+    void setEdgeClock(const SpeedEstimator* clock) { edgeClock = clock; }
+
+    // 获取单个传感器的亚相位脉宽（单位：1/256 相位）
+    int32_t getFinePulseWidth(int index) const;
     
     // 获取统计的物体数量
     int getObjectCount(int index) const;
@@ -69,16 +187,22 @@ public:
     // 获取所有扫描点的物体数量总和
     int getTotalObjectCount() const;
 
-    // 获取缓冲区的总采样数
-    int getSampleCount() const { return sampleCount; }
+    // 获取最近一次解码帧的总采样数
+    int getSampleCount() const { return frames[displayFrame].sampleCount; }
     
-    // 获取特定扫描点在特定采样阶段的状态
-    uint8_t getSample(int sensorIndex, int sampleIndex) const {
-        if (sensorIndex >= 0 && sensorIndex < 4 && sampleIndex >= 0 && sampleIndex < sampleCount) {
-            return sensorBuffers[sensorIndex][sampleIndex];
-        }
-        return 0;
-    }
+    // 获取最近一次解码帧中特定扫描点在特定采样阶段的状态（边沿模式下由边沿列表还原）
+    uint8_t getSample(int sensorIndex, int sampleIndex) const;
+
+    // 设置采集模式（下一次 start() 生效）
+    void setCaptureMode(ScanCaptureMode mode) { requestedCaptureMode = (uint8_t)mode; }
+    ScanCaptureMode getCaptureMode() const { return (ScanCaptureMode)requestedCaptureMode.load(); }
+
+    // 最近一次解码帧记录的边沿数 / 累计溢出丢弃的边沿数
+    int getEdgeCount() const { return frames[displayFrame].edgeCount; }
+    uint32_t getEdgeOverflowCount() const { return edgeOverflowCount; }
+
+    // 一次读取 GPIO_IN1_REG，返回 4 个通道的电平打包字 (bit i = 通道 i)
+    static uint8_t readPackedLevels();
 
     // 获取IO状态数组（用于诊断模式子模式1）
     bool* getIOStatusArray();
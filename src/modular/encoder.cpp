@@ -1,5 +1,9 @@
 #include "encoder.h"
+#include "quadrature_decoder.h"
+#include "cycle_profiler.h"
 #include "../config.h"
+#include <soc/gpio_reg.h>
+#include <esp_timer.h>
 
 // 静态成员初始化
 // Encoder* Encoder::instance = nullptr; // Managed by Singleton template
@@ -7,10 +11,17 @@
 // 编码器逻辑位置范围常量
 const int ENCODER_LOGICAL_POSITION_RANGE = ENCODER_MAX_PHASE;
 
+// A/B 相直接从 GPIO_IN_REG 读取，要求引脚编号 < 32
+static_assert(PIN_ENCODER_A < 32 && PIN_ENCODER_B < 32, "Encoder A/B must be on GPIO0-31");
+
+// 软件反转方向在编译期折叠为步进符号
+static const int ENCODER_STEP_SIGN = ENCODER_REVERSE_DIRECTION ? -1 : 1;
+
 /**
  * 私有构造函数 - 单例模式
  */
-Encoder::Encoder() {
+Encoder::Encoder() :
+    speedEstimator(1000000, PULSES_PER_TRAY, SPEED_STALL_TIMEOUT_US) {
     rawEncoderCount = 0;
     lastEncoderCount = 0;
     zeroCrossCount = 0;
@@ -23,9 +34,10 @@ Encoder::Encoder() {
     encoderPhaseCallback = nullptr;
     encoderPhaseCallbackContext = nullptr;
 
-    // 初始化状态缓存
-    pinA_state = LOW;
-    pinB_state = LOW;
+    // 初始化解码状态
+    quadratureState = 0;
+    rawPhase = 0;
+    illegalTransitions = 0;
 }
 
 /**
@@ -42,33 +54,28 @@ void Encoder::initialize() {
     pinMode(PIN_ENCODER_B, INPUT_PULLUP);
     pinMode(PIN_ENCODER_Z, INPUT_PULLUP);
     
-    // 配置外部中断处理函数（双中断模式）
-    attachInterrupt(digitalPinToInterrupt(PIN_ENCODER_A), handleAPhaseInterrupt, CHANGE);
-    attachInterrupt(digitalPinToInterrupt(PIN_ENCODER_B), handleBPhaseInterrupt, CHANGE);
-    attachInterrupt(digitalPinToInterrupt(PIN_ENCODER_Z), handleZPhaseInterrupt, FALLING);
-    
-    // 初始化内部状态变量并同步初始引脚电平
+    // 初始化内部状态变量并同步初始引脚电平（须在挂接中断之前完成）
     rawEncoderCount = 0;
     lastEncoderCount = 0;
     zeroCrossCount = 0;
     zeroCrossRawCount = 0;
     forcedZeroCount = 0;
     forcedZeroRawCount = 0;
+    rawPhase = 0;
+    illegalTransitions = 0;
+    quadratureState = (digitalRead(PIN_ENCODER_A) << 1) | digitalRead(PIN_ENCODER_B);
     
-    pinA_state = digitalRead(PIN_ENCODER_A);
-    pinB_state = digitalRead(PIN_ENCODER_B);
+    // 配置外部中断处理函数（双中断模式，A/B 共用同一个查表解码 ISR）
+    attachInterrupt(digitalPinToInterrupt(PIN_ENCODER_A), handleABPhaseInterrupt, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(PIN_ENCODER_B), handleABPhaseInterrupt, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(PIN_ENCODER_Z), handleZPhaseInterrupt, FALLING);
 }
 
 /**
  * 获取当前逻辑位置（0-199）
  */
 int Encoder::getCurrentPosition() {
-    int position = rawEncoderCount % ENCODER_LOGICAL_POSITION_RANGE;
-    if (position < 0) {
-        position += ENCODER_LOGICAL_POSITION_RANGE;
-    }
-    // 叠加零位偏移量，补偿各机器编码器安装位置差异
-    return (position + phaseOffset) % ENCODER_LOGICAL_POSITION_RANGE;
+    return applyPhaseOffset(rawPhase);
 }
 
 /**
@@ -80,39 +87,29 @@ void Encoder::setPhaseCallback(void* context, PhaseCallback callback) {
 }
 
 /**
- * A相中断处理函数
+ * A/B 相共用中断处理函数
+ * 一次寄存器读取同时获得两相电平，查表得到步进方向，相位计数增量回绕
  */
-void Encoder::handleAPhaseInterrupt() {
+void IRAM_ATTR Encoder::handleABPhaseInterrupt() {
+    PROFILE_SCOPE(PROBE_ENCODER_ISR);
     Encoder* enc = getInstance();
-    int A = digitalRead(PIN_ENCODER_A);
-    if (A != enc->pinA_state) {
-        int dN = (A == enc->pinB_state) ? 1 : -1;
-        if (ENCODER_REVERSE_DIRECTION) {
-            enc->rawEncoderCount -= dN;
-        } else {
-            enc->rawEncoderCount += dN;
-        }
-        enc->pinA_state = A;
-        enc->triggerPhaseCallback();
-    }
-}
-
-/**
- * B相中断处理函数
- */
-void Encoder::handleBPhaseInterrupt() {
-    Encoder* enc = getInstance();
-    int B = digitalRead(PIN_ENCODER_B);
-    if (B != enc->pinB_state) {
-        int dN = (enc->pinA_state != B) ? 1 : -1;
-        if (ENCODER_REVERSE_DIRECTION) {
-            enc->rawEncoderCount -= dN;
-        } else {
-            enc->rawEncoderCount += dN;
-        }
-        enc->pinB_state = B;
-        enc->triggerPhaseCallback();
+    uint32_t in = REG_READ(GPIO_IN_REG);
+    uint8_t state = (((in >> PIN_ENCODER_A) & 1) << 1) | ((in >> PIN_ENCODER_B) & 1);
+    
+    int8_t step = QUADRATURE_TRANSITION_TABLE[(enc->quadratureState << 2) | state];
+    enc->quadratureState = state;
+    
+    if (step == 0) return; // 电平未变化（抖动或另一相已处理）
+    if (step == QUADRATURE_ILLEGAL) {
+        enc->illegalTransitions++;
+        return;
     }
+    
+    step *= ENCODER_STEP_SIGN;
+    enc->speedEstimator.recordEdge((uint32_t)esp_timer_get_time(), step);
+    enc->rawEncoderCount += step;
+    enc->rawPhase = wrapPhaseStep(enc->rawPhase, step, ENCODER_LOGICAL_POSITION_RANGE);
+    enc->triggerPhaseCallback(enc->applyPhaseOffset(enc->rawPhase));
 }
 
 /**
@@ -136,6 +133,7 @@ void Encoder::handleZPhaseInterrupt() {
         enc->forcedZeroCount++;
         // 直接设为0
         enc->rawEncoderCount = 0;
+        enc->rawPhase = 0;
     }
     
     // 调用触发相位回调的方法，传递特殊相位值255表示Z相信号
@@ -146,13 +144,9 @@ void Encoder::handleZPhaseInterrupt() {
 
 /**
  * 私有方法：触发相位回调
- * 避免代码重复，在A相、B相和Z相中断处理中被调用
  */
-void Encoder::triggerPhaseCallback() {
+void IRAM_ATTR Encoder::triggerPhaseCallback(int phase) {
     if (encoderPhaseCallback != nullptr) {
-        int raw = rawEncoderCount % ENCODER_LOGICAL_POSITION_RANGE;
-        if (raw < 0) raw += ENCODER_LOGICAL_POSITION_RANGE;
-        int currentPhase = (raw + phaseOffset) % ENCODER_LOGICAL_POSITION_RANGE;
-        encoderPhaseCallback(encoderPhaseCallbackContext, currentPhase);
+        encoderPhaseCallback(encoderPhaseCallbackContext, phase);
     }
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "../config.h"
 
 #include "../utils/singleton.h"
+#include "speed_estimator.h"
 
 // 回调函数类型定义 - 只保留相位回调
 // 使用void*参数来支持类成员函数回调
@@ -25,9 +26,13 @@ private:
     long forcedZeroRawCount;        // 强制清零时的原始计数值
     int phaseOffset;                // 零位偏移量：补偿各机器编码器安装位置差异
     
-    // 引脚状态缓存（参考 SimpleFOC 优化）
-    volatile int pinA_state;        // A相上一个状态
-    volatile int pinB_state;        // B相上一个状态
+    // 查表解码状态
+    volatile uint8_t quadratureState;       // 上一次的 AB 状态 (A << 1) | B
+    volatile int rawPhase;                  // 未叠加偏移的相位 (0-199)，随边沿增量回绕
+    volatile uint32_t illegalTransitions;   // 非法的双相同时跳变次数（指示丢沿或干扰）
+    
+    // 边沿时间戳速度估计（ISR 记录时间戳，任务侧计算速度/加速度）
+    SpeedEstimator speedEstimator;
     
     // 回调函数指针和上下文
     PhaseCallback encoderPhaseCallback;  // 相位回调
@@ -37,7 +42,13 @@ private:
     Encoder();
     
     // 触发相位回调的私有方法
-    void triggerPhaseCallback();
+    void triggerPhaseCallback(int phase);
+    
+    // 叠加零位偏移量：phase 与 phaseOffset 均在 [0, 200) 内，一次条件减法即可回绕
+    int applyPhaseOffset(int phase) const {
+        phase += phaseOffset;
+        return (phase >= ENCODER_MAX_PHASE) ? phase - ENCODER_MAX_PHASE : phase;
+    }
     
 public:
     // initialize方法移至public
@@ -72,9 +83,14 @@ public:
     // 获取强制清零时的原始计数值
     long getForcedZeroRawCount() const { return forcedZeroRawCount; }
     
+    // 获取非法跳变次数（AB 两相同时翻转）
+    uint32_t getIllegalTransitionCount() const { return illegalTransitions; }
+    
+    // 获取速度估计器（时间基准为 esp_timer 微秒）
+    SpeedEstimator* getSpeedEstimator() { return &speedEstimator; }
+    
     // 中断处理函数
-    static void handleAPhaseInterrupt();  // A相中断
-    static void handleBPhaseInterrupt();  // B相中断
+    static void handleABPhaseInterrupt(); // A/B 相共用中断（查表解码）
     static void handleZPhaseInterrupt();  // Z相中断
 };
 
@@ -0,0 +1,68 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+/**
+ * 延迟分布统计（纯逻辑，无硬件依赖）
+ *
+ * 以 2 的幂分桶：桶 0 为 0us，桶 b (b >= 1) 为 [2^(b-1), 2^b) us，最后一个桶收纳所有更大的值。
+ * 记录为 O(1)（一次 clz），同时维护最小/最大/累计值，用于比较事件驱动与轮询两种调度方式。
+ * 仅由单一任务写入；其它任务读取时可能看到略有不一致的计数，只用于诊断显示。
+ */
+class LatencyHistogram {
+public:
+    static const int BUCKET_COUNT = 16;     // 最后一个桶 >= 16.4ms
+
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        for (int b = 0; b < BUCKET_COUNT; b++) buckets[b] = 0;
+        count = 0;
+        sumUs = 0;
+        minUs = 0xFFFFFFFFu;
+        maxUs = 0;
+    }
+
+    void record(uint32_t us) {
+        int b = (us == 0) ? 0 : 32 - __builtin_clz(us);
+        if (b >= BUCKET_COUNT) b = BUCKET_COUNT - 1;
+        buckets[b]++;
+        count++;
+        sumUs += us;
+        if (us < minUs) minUs = us;
+        if (us > maxUs) maxUs = us;
+    }
+
+    // 桶 b 的上界 (us, 不含)，最后一个桶返回 0 表示无上界
+    static uint32_t bucketUpperBoundUs(int b) {
+        return (b >= BUCKET_COUNT - 1) ? 0 : (1u << b);
+    }
+
+    // 覆盖至少 percent% 样本的最小桶上界 (us)，无样本返回 0
+    uint32_t percentileUpperBoundUs(int percent) const {
+        if (count == 0) return 0;
+        uint64_t target = ((uint64_t)count * percent + 99) / 100;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKET_COUNT; b++) {
+            seen += buckets[b];
+            if (seen >= target) return (b == BUCKET_COUNT - 1) ? maxUs : (1u << b);
+        }
+        return maxUs;
+    }
+
+    uint32_t getBucket(int b) const { return buckets[b]; }
+    uint32_t getCount() const { return count; }
+    uint32_t getMinUs() const { return count ? minUs : 0; }
+    uint32_t getMaxUs() const { return maxUs; }
+    uint32_t getAverageUs() const { return count ? (uint32_t)(sumUs / count) : 0; }
+
+private:
+    uint32_t buckets[BUCKET_COUNT];
+    uint32_t count;
+    uint64_t sumUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+};
+
+#endif // LATENCY_HISTOGRAM_H
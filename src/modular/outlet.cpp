@@ -11,38 +11,32 @@ void Outlet::initialize() {
     physicalOpen = false;
     readyToOpenState = false;
     stayOpenNext = false;
-}
-
-/**
- * 更新脉冲时序（由 Sorter 定时调用）
- */
-void Outlet::update() {
-    if (isPulsing) {
-        // 使用硬编码的非对称脉宽常数
-        uint32_t currentThreshold = targetPulseState ? PULSE_OPEN_MS : PULSE_CLOSE_MS;
-        
-        if (millis() - pulseStateChangeTime >= currentThreshold) {
-            stopPulse();
-        }
-    }
+    pulsePending = false;
 }
 
 /**
  * 执行目标动作（当 readyToOpenState 改变时触发）
+ * 只登记脉冲，真正起动由 startPendingPulse() 完成，以便多个出口错峰通电
  */
 void Outlet::execute() {
-    // 如果目标位置与当前物理留驻位置一致且没有正在发出的脉冲，则忽略
-    if (readyToOpenState == physicalOpen && !isPulsing) {
+    // 目标位置与当前物理留驻位置（即正在发出的脉冲方向）一致：撤销尚未起动的反向脉冲即可
+    if (readyToOpenState == physicalOpen) {
+        pulsePending = false;
         return;
     }
 
-    // 如果已经在向目标方向发送脉冲，则维持当前状态
-    if (isPulsing && targetPulseState == readyToOpenState) {
-        return; 
-    }
+    // 登记向目标方向的 H 桥换向脉冲
+    pulsePending = true;
+    pendingOpen = readyToOpenState;
+}
 
-    // 根据逻辑目标启动 H 桥换向脉冲
-    if (readyToOpenState) {
+/**
+ * 起动已登记的脉冲
+ */
+void Outlet::startPendingPulse() {
+    if (!pulsePending) return;
+    pulsePending = false;
+    if (pendingOpen) {
         executeOpen();
     } else {
         executeClose();
@@ -50,19 +44,24 @@ void Outlet::execute() {
 }
 
 void Outlet::executeOpen() {
+    actuationCount++;
     isPulsing = true;
-    pulseStateChangeTime = millis();
+    pulseStartUs = micros();
     targetPulseState = true;
     physicalOpen = true; 
 }
 
 void Outlet::executeClose() {
+    actuationCount++;
     isPulsing = true;
-    pulseStateChangeTime = millis();
+    pulseStartUs = micros();
     targetPulseState = false; 
     physicalOpen = false;
 }
 
-void Outlet::stopPulse() {
+/**
+ * 结束当前脉冲（截止时刻由 Sorter 的脉冲定时器按 getPulseWidthUs() 装定）
+ */
+void Outlet::endPulse() {
     isPulsing = false;
 }
@@ -2,24 +2,32 @@
 #define OUTLET_H
 
 #include <Arduino.h>
+#include "../config.h"
 
 class Outlet {
 private:
 public:
     Outlet() : 
           isPulsing(false), 
-          pulseStateChangeTime(0), 
+          pulseStartUs(0), 
           targetPulseState(false), 
           physicalOpen(false), 
           readyToOpenState(false), 
-          stayOpenNext(false),
           matchDiameterMin(0), 
           matchDiameterMax(0),
-          targetLength(0) {} // 0: ANY, 1: S, 2: M, 3: L
+          stayOpenNext(false),
+          pulsePending(false),
+          pendingOpen(false),
+          targetLength(0), // 0: ANY, 1: S, 2: M, 3: L
+          mechanicalLatencyMs(OUTLET_MECHANICAL_LATENCY_MS),
+          closeLatencyMs(OUTLET_CLOSE_LATENCY_MS),
+          actuationCount(0) {}
 
     void initialize();
-    void update();
-    void execute();
+    void endPulse();    // 脉冲到期（由脉冲定时器调用）
+    void execute();     // 按目标状态登记换向脉冲（由 Sorter 的起动调度器择机发出）
+    void startPendingPulse();
+    bool hasPendingPulse() const { return pulsePending; }
 
     // 预见性控制接口
     void setStayOpenNext(bool stay) { stayOpenNext = stay; }
@@ -32,6 +40,12 @@ public:
     bool isOpenPulseActive() const { return isPulsing && targetPulseState; }
     bool isClosePulseActive() const { return isPulsing && !targetPulseState; }
 
+    // 当前脉冲的起始时刻与宽度 (us)，供脉冲定时器装定截止时刻
+    uint32_t getPulseStartUs() const { return pulseStartUs; }
+    uint32_t getPulseWidthUs() const { return pulseWidthUs(targetPulseState); }
+    uint32_t getPendingPulseWidthUs() const { return pulseWidthUs(pendingOpen); }
+    static uint32_t pulseWidthUs(bool open) { return (open ? PULSE_OPEN_MS : PULSE_CLOSE_MS) * 1000u; }
+
     // 直径匹配配置
     void setMatchDiameter(int min, int max) {
         matchDiameterMin = min;
@@ -48,9 +62,18 @@ public:
     void setTargetLength(uint8_t len) { targetLength = len; }
     uint8_t getTargetLength() const { return targetLength; }
 
+    // 机械行程时间（从脉冲开始到翻板完全到位），用于按速度提前触发
+    void setMechanicalLatencyMs(uint16_t ms) { mechanicalLatencyMs = ms; }
+    uint16_t getMechanicalLatencyMs() const { return mechanicalLatencyMs; }
+    void setCloseLatencyMs(uint16_t ms) { closeLatencyMs = ms; }
+    uint16_t getCloseLatencyMs() const { return closeLatencyMs; }
+
+    // 自启动以来的线圈动作次数（打开 + 关闭脉冲），用于评估翻板保持策略
+    uint32_t getActuationCount() const { return actuationCount; }
+
 private:
     bool isPulsing;               // 正在发送高电平脉冲
-    unsigned long pulseStateChangeTime; // 脉冲起始时间
+    uint32_t pulseStartUs;        // 脉冲起始时间 (us)
     bool targetPulseState;        // 当前脉冲的目标方向（true=吸合, false=释放）
     bool physicalOpen;            // 电磁铁物理留驻位置（true=Open, false=Close）
     bool readyToOpenState;        // 软件下达的目标逻辑状态
@@ -58,11 +81,15 @@ private:
     int matchDiameterMin;
     int matchDiameterMax;
     bool stayOpenNext;            // 预见性：标记下一个托盘是否也需要进此洞
+    bool pulsePending;            // 已登记、尚未起动的换向脉冲
+    bool pendingOpen;             // 待起动脉冲的方向
     uint8_t targetLength;         // 0: ANY, 1: S, 2: M, 3: L
+    uint16_t mechanicalLatencyMs; // 翻板打开行程时间
+    uint16_t closeLatencyMs;      // 翻板关闭行程时间
+    uint32_t actuationCount;      // 线圈脉冲次数
 
     void executeOpen();
     void executeClose();
-    void stopPulse();
 };
 
 #endif // OUTLET_H
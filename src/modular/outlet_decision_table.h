@@ -0,0 +1,154 @@
+#ifndef OUTLET_DECISION_TABLE_H
+#define OUTLET_DECISION_TABLE_H
+
+#include <stdint.h>
+
+/**
+ * 直径 × 长度 -> 出口位掩码 预编译查找表（纯逻辑，无硬件依赖）
+ *
+ * 出口配置变化时编译一次，每个托盘的判定退化为一次查表：
+ *   行：直径向上取整到 mm，q = ceil(d / 10)。配置区间为整 mm 的 (min, max]，
+ *       因此 d > min*10 且 d <= max*10 等价于 min < q <= max，量化不引入误差
+ *   列：长度索引 0 = 未识别，1 = S，2 = M，3 = L
+ *   值：bit i = 出口 i 匹配
+ * 编译时同时统计重叠（同一格匹配多个出口）与空档（最小下限与最大上限之间无出口匹配），
+ * 使配置问题可被显式检查。
+ */
+
+// 单个出口的分级规则（与 Outlet 的配置一一对应）
+struct OutletRule {
+    int minMm;              // 下限（不含）
+    int maxMm;              // 上限（含）
+    uint8_t lengthMask;     // LengthMask，LEN_NONE / LEN_ALL 表示不限长度
+    bool enabled;           // false：不参与直径分级（如出口 0 的多物检测模式）
+};
+
+class OutletDecisionTable {
+public:
+    static const int MAX_DIAMETER_MM = 255;    // 配置上限即为 255mm
+    static const int LENGTH_INDEX_COUNT = 4;   // 未识别 / S / M / L
+    static const uint8_t NO_OUTLET = 0xFF;     // selectOutlet() 无匹配出口（与 TRAY_NO_OUTLET 相同）
+
+    OutletDecisionTable() : overlapCells(0), gapCells(0), firstOverlapMm(-1), firstGapMm(-1) {
+        for (int q = 0; q <= MAX_DIAMETER_MM; q++) {
+            for (int l = 0; l < LENGTH_INDEX_COUNT; l++) {
+                table[q][l] = 0;
+            }
+        }
+    }
+
+    // LengthMask (单一长度) -> 长度索引
+    static int lengthIndex(uint8_t lengthMask) {
+        switch (lengthMask) {
+            case 0x01: return 1;    // LEN_S
+            case 0x02: return 2;    // LEN_M
+            case 0x04: return 3;    // LEN_L
+            default:   return 0;
+        }
+    }
+
+    /**
+     * 根据出口规则重新编译查找表
+     * @param rules 出口规则数组，下标即出口编号（最多 8 个）
+     */
+    void compile(const OutletRule* rules, int count) {
+        if (count > 8) count = 8;
+        int lowestMin = MAX_DIAMETER_MM;
+        int highestMax = 0;
+        for (int i = 0; i < count; i++) {
+            if (!rules[i].enabled || rules[i].maxMm <= rules[i].minMm) continue;
+            if (rules[i].minMm < lowestMin) lowestMin = rules[i].minMm;
+            if (rules[i].maxMm > highestMax) highestMax = rules[i].maxMm;
+        }
+
+        overlapCells = 0;
+        gapCells = 0;
+        firstOverlapMm = -1;
+        firstGapMm = -1;
+
+        for (int q = 0; q <= MAX_DIAMETER_MM; q++) {
+            for (int l = 0; l < LENGTH_INDEX_COUNT; l++) {
+                uint8_t detected = (l == 0) ? 0 : (uint8_t)(1 << (l - 1));
+                uint8_t mask = 0;
+                for (int i = 0; i < count; i++) {
+                    if (matches(rules[i], q, detected)) mask |= (uint8_t)(1 << i);
+                }
+                table[q][l] = mask;
+
+                // 仅对已识别长度、且位于配置覆盖范围内的直径检查重叠/空档
+                if (l == 0 || q <= lowestMin || q > highestMax) continue;
+                if (mask & (mask - 1)) {
+                    overlapCells++;
+                    if (firstOverlapMm < 0) firstOverlapMm = q;
+                } else if (mask == 0) {
+                    gapCells++;
+                    if (firstGapMm < 0) firstGapMm = q;
+                }
+            }
+        }
+    }
+
+    /**
+     * 查询匹配的出口
+     * @param diameterDeciMm 直径 (0.1mm)，<= 0 视为空托盘
+     * @param lengthMask 检测到的长度 (LEN_S / LEN_M / LEN_L)
+     */
+    uint8_t lookup(int diameterDeciMm, uint8_t lengthMask) const {
+        if (diameterDeciMm <= 0) return 0;
+        int q = (diameterDeciMm + 9) / 10;
+        if (q > MAX_DIAMETER_MM) return 0;
+        return table[q][lengthIndex(lengthMask)];
+    }
+
+    // 匹配多个出口的 (直径 mm, 长度) 格数，及第一个重叠的直径
+    int getOverlapCells() const { return overlapCells; }
+    int getFirstOverlapMm() const { return firstOverlapMm; }
+
+    // 覆盖范围内无出口匹配的 (直径 mm, 长度) 格数，及第一个空档的直径
+    int getGapCells() const { return gapCells; }
+    int getFirstGapMm() const { return firstGapMm; }
+
+private:
+    uint8_t table[MAX_DIAMETER_MM + 1][LENGTH_INDEX_COUNT];
+    int overlapCells;
+    int gapCells;
+    int firstOverlapMm;
+    int firstGapMm;
+
+    // 与 prepareOutlets 原有判定一致：min < q <= max，长度按位与（不限长度时忽略）
+    static bool matches(const OutletRule& rule, int q, uint8_t detectedLength) {
+        if (!rule.enabled) return false;
+        if (q <= rule.minMm || q > rule.maxMm) return false;
+        if (rule.lengthMask != 0x00 && rule.lengthMask != 0x07) {   // LEN_NONE / LEN_ALL
+            if (!(rule.lengthMask & detectedLength)) return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * 锁存时为托盘确定唯一目标出口（Sorter::decideOutlet 的纯逻辑部分）
+ * 多个出口匹配时，托盘在最先到达的分流点即被分走：取分流点位置最小者
+ * @param divergencePoints 各出口的分流点位置，下标即出口编号（最多 8 个）
+ * @return 出口编号，无匹配时返回 OutletDecisionTable::NO_OUTLET
+ */
+inline uint8_t selectOutlet(const OutletDecisionTable& table, const uint8_t* divergencePoints, int outletCount,
+                            uint8_t outlet0Mode, int diameterDeciMm, uint8_t lengthMask, int objectCount,
+                            bool lowConfidence) {
+    if (outletCount > 8) outletCount = 8;
+    // 通用直径匹配：低置信度托盘不参与直径分级，避免误分
+    uint8_t mask = lowConfidence ? 0 : table.lookup(diameterDeciMm, lengthMask);
+    // 出口 0 的特殊识别模式：多物体/碎料检测，同时作为低置信度托盘的剔除出口
+    if (outlet0Mode == 0 && (objectCount > 1 || lowConfidence)) mask |= 0x01;
+
+    uint8_t target = OutletDecisionTable::NO_OUTLET;
+    for (int i = 0; i < outletCount; i++) {
+        if (!(mask & (1u << i))) continue;
+        if (target == OutletDecisionTable::NO_OUTLET || divergencePoints[i] < divergencePoints[target]) {
+            target = (uint8_t)i;
+        }
+    }
+    return target;
+}
+
+#endif // OUTLET_DECISION_TABLE_H
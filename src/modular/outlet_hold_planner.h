@@ -0,0 +1,40 @@
+#ifndef OUTLET_HOLD_PLANNER_H
+#define OUTLET_HOLD_PLANNER_H
+
+#include <stdint.h>
+
+/**
+ * 翻板保持规划（纯逻辑，无硬件依赖）
+ *
+ * 同一出口的连续物品之间常夹着个别空托盘。空托盘经过打开的翻板不会掉落任何东西，
+ * 因此只要在前瞻窗口内下一个非空托盘仍属于本出口，翻板就可以保持打开，
+ * 省去一次关闭 + 一次打开（PULSE_CLOSE_MS + PULSE_OPEN_MS 的线圈电流与机械磨损）。
+ * 安全条件：翻板保持打开期间经过分流点的每个托盘都必须是 "目标" 或 "确定为空"；
+ * 窗口内出现其它物品、未知托盘（丢帧/尚未扫描）或窗口耗尽时必须关闭。
+ * lookahead = 1 时与原先只看下一个托盘的行为完全一致。
+ */
+
+// 分流点上游某一托盘相对于某出口的分类
+enum HoldSlot : uint8_t {
+    HOLD_SLOT_EMPTY = 0,    // 确定为空，可在翻板打开时安全通过
+    HOLD_SLOT_TARGET,       // 本出口的物品
+    HOLD_SLOT_OTHER         // 其它物品或状态未知，翻板必须关闭
+};
+
+/**
+ * 判断翻板在当前托盘之后是否可以保持打开
+ * @param position  分流点位置（当前托盘所在位置）
+ * @param lookahead 最多向上游查看的托盘数
+ * @param classify  classify(p) 返回位置 p 上托盘的 HoldSlot，p < 0 时应返回 HOLD_SLOT_OTHER
+ */
+template <typename Classify>
+inline bool planHoldOpen(int position, int lookahead, Classify classify) {
+    for (int k = 1; k <= lookahead; k++) {
+        HoldSlot slot = classify(position - k);
+        if (slot == HOLD_SLOT_TARGET) return true;
+        if (slot != HOLD_SLOT_EMPTY) return false;
+    }
+    return false;
+}
+
+#endif // OUTLET_HOLD_PLANNER_H
@@ -0,0 +1,118 @@
+#ifndef OUTLET_WIRING_H
+#define OUTLET_WIRING_H
+
+#include <stdint.h>
+
+/**
+ * 出口 -> 74HC595 位映射（编译期描述，纯逻辑，无硬件依赖）
+ *
+ * 每个出口在输出帧中占 3 位：LED 指示位、H 桥打开位、H 桥关闭位。
+ * 字节序号为输出帧下标（0 最先移出，位于链路最远端的芯片）。
+ * 出口状态以位图表示（bit i = 出口 i），OutletFramePacker 在编译期把映射展开为
+ * 固定下标的移位/或运算，组帧无分支、无循环。更换布线的板子只需换一张表。
+ */
+
+struct OutletWiring {
+    uint8_t ledByte;    // LED 所在帧字节
+    uint8_t ledBit;
+    uint8_t coilByte;   // H 桥所在帧字节
+    uint8_t openBit;
+    uint8_t closeBit;
+};
+
+/**
+ * 当前板：帧字节 0 = 芯片2（出口 0-3 H 桥），1 = 芯片1（出口 4-7 H 桥），2 = 芯片0（LED）
+ * 布线特点：两片 H 桥芯片对调；出口 4-7 的 LED 反向接在 bit 7-4
+ */
+constexpr OutletWiring BOARD_OUTLET_WIRING_TABLE[] = {
+    // led byte/bit  coil byte/open/close
+    {2, 0,           0, 0, 1},  // 出口 0
+    {2, 1,           0, 2, 3},  // 出口 1
+    {2, 2,           0, 4, 5},  // 出口 2
+    {2, 3,           0, 6, 7},  // 出口 3
+    {2, 7,           1, 0, 1},  // 出口 4
+    {2, 6,           1, 2, 3},  // 出口 5
+    {2, 5,           1, 4, 5},  // 出口 6
+    {2, 4,           1, 6, 7}   // 出口 7
+};
+
+struct BoardOutletWiring {
+    static constexpr int OUTLET_COUNT = 8;
+    static constexpr int CHAIN_LENGTH = 3;
+    static constexpr OutletWiring outlet(int i) { return BOARD_OUTLET_WIRING_TABLE[i]; }
+};
+
+/**
+ * 运行期组帧：按出口编号模板递归展开，每个出口 3 条 "取位-移位-或" 指令，字节下标与位号均为编译期常量
+ * @param bytes 输出帧（调用前清零），长度为 Wiring::CHAIN_LENGTH
+ * @param positionMask 翻板物理位置为打开的出口
+ * @param openMask / closeMask 正在发出打开/关闭脉冲的出口
+ */
+template <typename Wiring, int I = 0, bool END = (I >= Wiring::OUTLET_COUNT)>
+struct OutletFramePacker {
+    enum : uint8_t {
+        LED_BYTE = Wiring::outlet(I).ledByte,
+        LED_BIT = Wiring::outlet(I).ledBit,
+        COIL_BYTE = Wiring::outlet(I).coilByte,
+        OPEN_BIT = Wiring::outlet(I).openBit,
+        CLOSE_BIT = Wiring::outlet(I).closeBit
+    };
+
+    static inline void pack(uint8_t* bytes, uint32_t positionMask, uint32_t openMask, uint32_t closeMask) {
+        bytes[LED_BYTE] |= (uint8_t)(((positionMask >> I) & 1u) << LED_BIT);
+        bytes[COIL_BYTE] |= (uint8_t)(((openMask >> I) & 1u) << OPEN_BIT);
+        bytes[COIL_BYTE] |= (uint8_t)(((closeMask >> I) & 1u) << CLOSE_BIT);
+        OutletFramePacker<Wiring, I + 1>::pack(bytes, positionMask, openMask, closeMask);
+    }
+};
+
+template <typename Wiring, int I>
+struct OutletFramePacker<Wiring, I, true> {
+    static inline void pack(uint8_t*, uint32_t, uint32_t, uint32_t) {}
+};
+
+// ==========================================
+// 编译期校验
+// ==========================================
+
+// 编译期组出帧字节 byteIndex（与 OutletFramePacker 语义相同）
+template <typename Wiring>
+constexpr uint8_t packedWiringByte(int byteIndex, uint32_t positionMask, uint32_t openMask, uint32_t closeMask,
+                                   int i = 0) {
+    return (i >= Wiring::OUTLET_COUNT) ? 0 :
+        (uint8_t)(((Wiring::outlet(i).ledByte == byteIndex) ? (((positionMask >> i) & 1u) << Wiring::outlet(i).ledBit) : 0) |
+                  ((Wiring::outlet(i).coilByte == byteIndex) ? (((openMask >> i) & 1u) << Wiring::outlet(i).openBit) : 0) |
+                  ((Wiring::outlet(i).coilByte == byteIndex) ? (((closeMask >> i) & 1u) << Wiring::outlet(i).closeBit) : 0) |
+                  packedWiringByte<Wiring>(byteIndex, positionMask, openMask, closeMask, i + 1));
+}
+
+constexpr int wiringPopcount8(uint8_t x) {
+    return (x & 1) + ((x >> 1) & 1) + ((x >> 2) & 1) + ((x >> 3) & 1) +
+           ((x >> 4) & 1) + ((x >> 5) & 1) + ((x >> 6) & 1) + ((x >> 7) & 1);
+}
+
+// 所有信号全部置位时帧中的置位数；等于 3 * 出口数说明任意两个信号都不共用同一位
+template <typename Wiring>
+constexpr int wiringUsedBits(int byteIndex = 0) {
+    return (byteIndex >= Wiring::CHAIN_LENGTH) ? 0 :
+        wiringPopcount8(packedWiringByte<Wiring>(byteIndex, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu)) +
+        wiringUsedBits<Wiring>(byteIndex + 1);
+}
+
+// 原 updateShiftRegisters 的位映射（LED：0-3 正序、4-7 反序；H 桥：出口 0-3 在帧字节 0，4-7 在帧字节 1）
+// 只校验单个信号的位置；与旧版组帧代码的全组合逐帧比较见 test/test_outlet_wiring
+constexpr bool boardWiringMatchesLegacy(int i = 0) {
+    return (i >= BoardOutletWiring::OUTLET_COUNT) ? true :
+        packedWiringByte<BoardOutletWiring>(2, 1u << i, 0, 0) == (uint8_t)(1u << ((i < 4) ? i : 7 - (i - 4))) &&
+        packedWiringByte<BoardOutletWiring>((i < 4) ? 0 : 1, 0, 1u << i, 0) == (uint8_t)(1u << ((i % 4) * 2)) &&
+        packedWiringByte<BoardOutletWiring>((i < 4) ? 0 : 1, 0, 0, 1u << i) == (uint8_t)(1u << ((i % 4) * 2 + 1)) &&
+        boardWiringMatchesLegacy(i + 1);
+}
+
+static_assert(sizeof(BOARD_OUTLET_WIRING_TABLE) / sizeof(BOARD_OUTLET_WIRING_TABLE[0]) == BoardOutletWiring::OUTLET_COUNT,
+              "Wiring table size must match OUTLET_COUNT");
+static_assert(wiringUsedBits<BoardOutletWiring>() == 3 * BoardOutletWiring::OUTLET_COUNT,
+              "Two outlet signals share one shift register bit");
+static_assert(boardWiringMatchesLegacy(), "Board wiring table differs from the current board");
+
+#endif // OUTLET_WIRING_H
@@ -0,0 +1,135 @@
+#ifndef PHASE_SCHEDULER_H
+#define PHASE_SCHEDULER_H
+
+#include <stdint.h>
+#include <atomic>
+
+// 相位事件回调：eventId 为 addEvent() 返回的编号
+typedef void (*PhaseEventCallback)(void* context, int eventId);
+
+/**
+ * 相位阈值穿越事件调度器
+ *
+ * 与精确相等匹配不同，每次相位更新时触发所有阈值落在 (lastPhase, phase] 区间内的事件，
+ * 并按穿越先后顺序依次回调。因此即使丢失边沿或 Z 相强制清零导致相位跳变，
+ * 也不会漏掉任何一个分拣时序事件。
+ *
+ * - 前向距离超过半圈视为反向抖动：不触发事件，也不推进水位线（同一周期内事件只触发一次）
+ * - 阈值使用原子变量存储，允许任务侧在运行中调整（ISR 侧无需加锁）
+ * - 回调中调整阈值（如锁存事件改写执行相位）时，移到本次区间剩余部分的事件仍在本次触发，
+ *   移到已越过部分的不再触发；同一次更新中每个事件最多触发一次
+ * - 纯逻辑实现，不依赖 Arduino，可在主机上单独编译
+ *
+ * @tparam MAX_EVENTS 可注册事件数量上限
+ */
+template <int MAX_EVENTS>
+class PhaseEventScheduler {
+    static_assert(MAX_EVENTS <= 32, "fired events are tracked in a 32-bit mask");
+
+public:
+    explicit PhaseEventScheduler(int phaseRange) :
+        range(phaseRange),
+        eventCount(0),
+        lastPhase(-1),
+        skipOccurrences(0),
+        skippedPhases(0),
+        callback(nullptr),
+        callbackContext(nullptr) {}
+
+    // 设置事件回调及上下文
+    void setEventCallback(void* context, PhaseEventCallback cb) {
+        callback = cb;
+        callbackContext = context;
+    }
+
+    /**
+     * 注册一个相位事件
+     * @param phase 触发阈值 (0 ~ range-1)
+     * @return 事件编号，容量已满返回 -1
+     */
+    int addEvent(int phase) {
+        if (eventCount >= MAX_EVENTS) return -1;
+        eventPhases[eventCount].store(normalize(phase));
+        return eventCount++;
+    }
+
+    // 调整已注册事件的触发阈值（可在任务上下文中调用）
+    void setEventPhase(int eventId, int phase) {
+        if (eventId >= 0 && eventId < eventCount) {
+            eventPhases[eventId].store(normalize(phase), std::memory_order_relaxed);
+        }
+    }
+
+    int getEventPhase(int eventId) const {
+        return (eventId >= 0 && eventId < eventCount) ? eventPhases[eventId].load(std::memory_order_relaxed) : -1;
+    }
+
+    // 遗忘水位线，下一次相位更新视为起点
+    void reset() { lastPhase = -1; }
+
+    /**
+     * 相位更新入口（ISR 上下文）
+     * 触发所有在 (lastPhase, phase] 区间内被穿越的事件
+     */
+    void onPhase(int phase) {
+        if (phase < 0 || phase >= range) return;
+
+        int last = lastPhase;
+        if (last < 0) last = (phase == 0) ? range - 1 : phase - 1; // 起点：仅触发恰好位于当前相位的事件
+
+        int delta = phase - last;
+        if (delta < 0) delta += range;
+        if (delta == 0 || delta > range / 2) return; // 无变化或反向抖动
+
+        lastPhase = phase;
+        if (delta > 1) {
+            skipOccurrences++;
+            skippedPhases += delta - 1;
+        }
+
+        // 按穿越先后逐个触发：每次重新读取阈值，选出尚未触发、且不早于上一个触发位置的最近事件
+        // （同一阈值按注册顺序）。回调可能改写阈值，因此不能预先收集整个区间
+        uint32_t fired = 0;
+        int position = 0;   // 上一个触发事件的穿越距离 (0 = 紧随 last 之后)
+        for (;;) {
+            int next = -1;
+            int nextDist = delta;
+            for (int i = 0; i < eventCount; i++) {
+                if (fired & (1u << i)) continue;
+                int dist = eventPhases[i].load(std::memory_order_relaxed) - last - 1;
+                if (dist < 0) dist += range;
+                if (dist < position || dist >= nextDist) continue;
+                next = i;
+                nextDist = dist;
+            }
+            if (next < 0) break;
+
+            fired |= 1u << next;
+            position = nextDist;
+            if (callback != nullptr) callback(callbackContext, next);
+        }
+    }
+
+    // 发生相位跳变（单次前进超过 1 个相位）的次数
+    uint32_t getSkipOccurrences() const { return skipOccurrences; }
+
+    // 累计被跳过的相位数
+    uint32_t getSkippedPhases() const { return skippedPhases; }
+
+private:
+    int range;
+    int eventCount;
+    std::atomic<int> eventPhases[MAX_EVENTS];
+    volatile int lastPhase;              // 水位线：最近一次前进到的相位
+    volatile uint32_t skipOccurrences;
+    volatile uint32_t skippedPhases;
+    PhaseEventCallback callback;
+    void* callbackContext;
+
+    int normalize(int phase) const {
+        phase %= range;
+        return (phase < 0) ? phase + range : phase;
+    }
+};
+
+#endif // PHASE_SCHEDULER_H
@@ -0,0 +1,67 @@
+#ifndef PULSE_SCHEDULER_H
+#define PULSE_SCHEDULER_H
+
+#include <stdint.h>
+
+/**
+ * 电磁铁脉冲截止调度（纯逻辑，无硬件依赖，时间由调用方传入）
+ *
+ * 每个通道记录一个脉冲截止时刻 (us)。硬件侧只需一个单次定时器：
+ * 启动脉冲后按 nextDelay() 装定时器，到期时调用 expire() 取得应结束的通道并刷新输出，
+ * 再按 nextDelay() 重新装定时器。脉宽精度因此取决于定时器而非控制循环的节拍。
+ * 时间比较按 32 位回绕处理（约 71 分钟一圈），单个脉宽不得超过 2^31 us。
+ *
+ * @tparam CHANNELS 通道数 (<= 32)
+ */
+template <int CHANNELS>
+class PulseScheduler {
+public:
+    PulseScheduler() : activeMask(0) {
+        for (int ch = 0; ch < CHANNELS; ch++) deadlineUs[ch] = 0;
+    }
+
+    // 通道 ch 在 startUs 开始一个宽度为 widthUs 的脉冲（覆盖该通道尚未结束的脉冲）
+    void start(int ch, uint32_t startUs, uint32_t widthUs) {
+        deadlineUs[ch] = startUs + widthUs;
+        activeMask |= (1u << ch);
+    }
+
+    void cancel(int ch) { activeMask &= ~(1u << ch); }
+
+    bool isActive(int ch) const { return (activeMask >> ch) & 1; }
+    uint32_t getActiveMask() const { return activeMask; }
+
+    // 取出所有在 nowUs 或之前到期的通道（位图），并将其移出活动集合
+    uint32_t expire(uint32_t nowUs) {
+        uint32_t expired = 0;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if (!isActive(ch)) continue;
+            if ((int32_t)(nowUs - deadlineUs[ch]) >= 0) expired |= (1u << ch);
+        }
+        activeMask &= ~expired;
+        return expired;
+    }
+
+    /**
+     * 距最近一个截止时刻的延迟
+     * @return 无活动脉冲时返回 false；已过期的脉冲延迟为 0
+     */
+    bool nextDelay(uint32_t nowUs, uint32_t& delayUs) const {
+        bool found = false;
+        int32_t best = 0;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if (!isActive(ch)) continue;
+            int32_t remaining = (int32_t)(deadlineUs[ch] - nowUs);
+            if (!found || remaining < best) best = remaining;
+            found = true;
+        }
+        delayUs = (best > 0) ? (uint32_t)best : 0;
+        return found;
+    }
+
+private:
+    uint32_t deadlineUs[CHANNELS];
+    uint32_t activeMask;
+};
+
+#endif // PULSE_SCHEDULER_H
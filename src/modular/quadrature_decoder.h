@@ -0,0 +1,38 @@
+#ifndef QUADRATURE_DECODER_H
+#define QUADRATURE_DECODER_H
+
+#include <stdint.h>
+
+/**
+ * 正交编码器四状态查表解码（与 hmiEncoderISR 同构）
+ *
+ * 状态编码：state = (A << 1) | B
+ * 索引方式：QUADRATURE_TRANSITION_TABLE[(lastState << 2) | newState]
+ * 返回值：  +1/-1 = 有效步进，0 = 电平未变化，QUADRATURE_ILLEGAL = 双相同时翻转（丢沿/干扰）
+ *
+ * 方向约定与旧版 A/B 分离中断处理保持一致：00 -> 01 -> 11 -> 10 -> 00 为正向 (+1)。
+ * 注意 HMI 旋钮使用的是相反的方向约定。
+ */
+static const int8_t QUADRATURE_ILLEGAL = 2;
+
+static const int8_t QUADRATURE_TRANSITION_TABLE[16] = {
+     0,  1, -1,  2,
+    -1,  0,  2,  1,
+     1,  2,  0, -1,
+     2, -1,  1,  0
+};
+
+/**
+ * 增量回绕：相位计数器在 [0, range) 内按 ±1 步进，避免每个边沿做取模运算
+ */
+inline int wrapPhaseStep(int phase, int step, int range) {
+    phase += step;
+    if (phase >= range) {
+        phase -= range;
+    } else if (phase < 0) {
+        phase += range;
+    }
+    return phase;
+}
+
+#endif // QUADRATURE_DECODER_H
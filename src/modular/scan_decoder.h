@@ -0,0 +1,148 @@
+#ifndef SCAN_DECODER_H
+#define SCAN_DECODER_H
+
+#include <stdint.h>
+
+/**
+ * 扫描窗口位图解码（纯函数，无硬件依赖）
+ *
+ * 每个通道的采样以位图存储：第 i 次采样对应 bits[i >> 5] 的第 (i & 31) 位。
+ * 解码以 32 位为单位并行处理：
+ *   prev = (x << 1) | carry     上一采样点电平
+ *   rise = x & ~prev            上升沿（物体开始遮挡）
+ *   fall = ~x & prev            下降沿（物体离开，计为一个物体）
+ * 物体数为下降沿的 popcount；脉宽取最后一个上升沿开始的高电平段长度，
+ * 与逐点回放的语义一致（新物体遮挡时重新计数，窗口结束仍为高电平时计到窗口末尾）。
+ */
+
+static const int SCAN_BITS_PER_WORD = 32;
+
+struct ScanChannelResult {
+    int pulseWidth;     // 最后一段高电平的采样点数
+    int objectCount;    // 完整通过（高->低）的物体数
+};
+
+// 最高置位的位序号（x != 0）
+inline int scanHighestBit(uint32_t x) {
+    return 31 - __builtin_clz(x);
+}
+
+/**
+ * 解码单个通道
+ * @param bits 通道位图（sampleCount 之后的位必须为 0）
+ * @param sampleCount 有效采样点数
+ */
+inline ScanChannelResult decodeChannelBits(const volatile uint32_t* bits, int sampleCount) {
+    ScanChannelResult result = {0, 0};
+    int words = (sampleCount + SCAN_BITS_PER_WORD - 1) / SCAN_BITS_PER_WORD;
+    uint32_t carry = 0;
+    int lastRise = -1;
+    int lastFall = -1;
+
+    for (int w = 0; w < words; w++) {
+        uint32_t x = bits[w];
+        uint32_t prev = (x << 1) | carry;
+        carry = x >> 31;
+
+        uint32_t validMask = 0xFFFFFFFFu;
+        int remaining = sampleCount - w * SCAN_BITS_PER_WORD;
+        if (remaining < SCAN_BITS_PER_WORD) validMask = (1u << remaining) - 1;
+
+        uint32_t rise = x & ~prev;
+        uint32_t fall = ~x & prev & validMask;
+
+        result.objectCount += __builtin_popcount(fall);
+        if (rise) lastRise = w * SCAN_BITS_PER_WORD + scanHighestBit(rise);
+        if (fall) lastFall = w * SCAN_BITS_PER_WORD + scanHighestBit(fall);
+    }
+
+    if (lastRise >= 0) {
+        result.pulseWidth = (lastFall > lastRise) ? lastFall - lastRise : sampleCount - lastRise;
+    }
+    return result;
+}
+
+/**
+ * 边沿列表（游程）记录：仅在某通道电平变化时记录一条
+ * 约定与位图一致：窗口开始前电平视为低，sampleIndex 处的采样即为新电平
+ */
+struct ScanEdge {
+    uint16_t sampleIndex;   // 发生变化的采样序号
+    uint8_t channel;        // 通道号 0-3
+    uint8_t level;          // 变化后的电平 (1 = 上升沿, 0 = 下降沿)
+};
+
+/**
+ * 一次遍历解码边沿列表，得到各通道脉宽与物体数，复杂度 O(edges)
+ * @param edges 按采样序号递增排列的边沿
+ * @param results 输出数组，长度为 channelCount
+ */
+inline void decodeEdgeList(const volatile ScanEdge* edges, int edgeCount, int sampleCount,
+                           ScanChannelResult* results, int channelCount) {
+    int lastRise[8];
+    int lastFall[8];
+    for (int ch = 0; ch < channelCount; ch++) {
+        results[ch].pulseWidth = 0;
+        results[ch].objectCount = 0;
+        lastRise[ch] = -1;
+        lastFall[ch] = -1;
+    }
+
+    for (int i = 0; i < edgeCount; i++) {
+        int ch = edges[i].channel;
+        if (ch >= channelCount) continue;
+        if (edges[i].level) {
+            lastRise[ch] = edges[i].sampleIndex;
+        } else {
+            lastFall[ch] = edges[i].sampleIndex;
+            results[ch].objectCount++;
+        }
+    }
+
+    for (int ch = 0; ch < channelCount; ch++) {
+        if (lastRise[ch] >= 0) {
+            results[ch].pulseWidth = (lastFall[ch] > lastRise[ch]) ? lastFall[ch] - lastRise[ch]
+                                                                   : sampleCount - lastRise[ch];
+        }
+    }
+}
+
+// 由边沿列表还原某通道在指定采样点的电平（诊断显示用）
+inline uint8_t edgeListLevelAt(const volatile ScanEdge* edges, int edgeCount, int channel, int sampleIndex) {
+    uint8_t level = 0;
+    for (int i = 0; i < edgeCount; i++) {
+        if (edges[i].sampleIndex > sampleIndex) break;
+        if (edges[i].channel == channel) level = edges[i].level;
+    }
+    return level;
+}
+
+/**
+ * 亚相位插值（定点数，1 个采样间隔 = 256）
+ *
+ * 传感器跳变发生在两个编码器边沿之间。以跳变时刻距上一个边沿的时间 dt 与
+ * 当前边沿周期 period（即瞬时速度的倒数）之比，把跳变定位到相位的小数部分。
+ * 仅使用整数运算，可在 ISR 中调用。
+ */
+static const int SCAN_SUBPHASE_SHIFT = 8;
+static const int32_t SCAN_SUBPHASE_ONE = 1 << SCAN_SUBPHASE_SHIFT;
+
+inline int32_t interpolateSubPhase(uint32_t dt, uint32_t period) {
+    if (period == 0 || period > 0x00FFFFFFu) return 0;  // 无周期数据或近乎停转：退化为整相位
+    if (dt >= period) return SCAN_SUBPHASE_ONE - 1;     // 减速中，尚未到达下一个边沿
+    return (int32_t)((dt << SCAN_SUBPHASE_SHIFT) / period);
+}
+
+/**
+ * 由最后一次上升/下降沿的定点位置计算脉宽（定点数）
+ * @param rise 最后一次上升沿位置，< 0 表示窗口内从未变高
+ * @param fall 最后一次下降沿位置，< 0 表示无
+ * @param endPos 窗口结束位置（仍为高电平时计到此处）
+ */
+inline int32_t finePulseWidth(int32_t rise, int32_t fall, int32_t endPos) {
+    if (rise < 0) return 0;
+    int32_t width = (fall > rise) ? fall - rise : endPos - rise;
+    return (width > 0) ? width : 0;
+}
+
+#endif // SCAN_DECODER_H
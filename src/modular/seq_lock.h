@@ -0,0 +1,54 @@
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * 顺序锁 (seqlock)（纯逻辑，无硬件依赖）
+ *
+ * 写入方在修改前后各将序号加一（写入期间为奇数），写入方之间须由调用方另行串行化；
+ * 读取方不加锁：读取前后序号相同且为偶数才接受本次读取，否则重试，从不阻塞写入方。
+ * 读取体 read() 可能执行多次，只能读取受保护的数据，不能有其它副作用。
+ */
+class SeqLock {
+public:
+    SeqLock() : seq(0) {}
+
+    void beginWrite() {
+        seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void endWrite() {
+        std::atomic_thread_fence(std::memory_order_release);
+        seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * 读取一份一致的数据：读取体来自同一次写入前或写入后
+     * @param readBody 无参可调用对象，拷贝受保护的数据
+     * @return 因写入打断（序号为奇数或前后不同）而重试的次数
+     */
+    template <typename ReadBody>
+    uint32_t read(ReadBody readBody) const {
+        uint32_t retries = 0;
+        uint32_t s0, s1;
+        while (true) {
+            s0 = seq.load(std::memory_order_acquire);
+            readBody();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = seq.load(std::memory_order_relaxed);
+            if (!(s0 & 1) && s0 == s1) return retries;
+            retries++;
+        }
+    }
+
+    // 当前序号（奇数表示写入进行中），用于诊断
+    uint32_t getSequence() const { return seq.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> seq;
+};
+
+#endif // SEQ_LOCK_H
@@ -1,32 +1,81 @@
 #include "shift_register_driver.h"
 
-ShiftRegisterDriver::ShiftRegisterDriver(int ds, int shcp, int stcp) 
-    : lastShiftData(0xFFFFFFFF), dsPin(ds), shcpPin(shcp), stcpPin(stcp) {
-}
+// ==========================================
+// 软件位操作后端
+// ==========================================
 
-void ShiftRegisterDriver::initialize() {
+bool BitBangShiftBus::begin() {
     pinMode(dsPin, OUTPUT);
     pinMode(shcpPin, OUTPUT);
     pinMode(stcpPin, OUTPUT);
     digitalWrite(stcpPin, LOW);
+    return true;
 }
 
-void ShiftRegisterDriver::write(uint8_t chip2, uint8_t chip1, uint8_t led) {
-    uint32_t currentData = ((uint32_t)chip2 << 16) | ((uint32_t)chip1 << 8) | led;
-    
-    if (currentData != lastShiftData) {
-        forceUpdate(chip2, chip1, led);
-        lastShiftData = currentData;
+bool BitBangShiftBus::transmit(const uint8_t* bytes, int count) {
+    digitalWrite(stcpPin, LOW);
+    for (int i = 0; i < count; i++) {
+        shiftOut(dsPin, shcpPin, MSBFIRST, bytes[i]);
     }
+    digitalWrite(stcpPin, HIGH);
+    return true;
 }
 
-void ShiftRegisterDriver::forceUpdate(uint8_t chip2, uint8_t chip1, uint8_t led) {
-    digitalWrite(stcpPin, LOW);
-    shiftOut(dsPin, shcpPin, MSBFIRST, chip2);
-    shiftOut(dsPin, shcpPin, MSBFIRST, chip1);
-    shiftOut(dsPin, shcpPin, MSBFIRST, led);
-    digitalWrite(stcpPin, HIGH);
-    
-    // 同步记录，以防后续 write() 冗余
-    lastShiftData = ((uint32_t)chip2 << 16) | ((uint32_t)chip1 << 8) | led;
+// ==========================================
+// 硬件 SPI 后端
+// ==========================================
+
+bool SpiShiftBus::begin() {
+    spi_bus_config_t busConfig = {};
+    busConfig.mosi_io_num = dsPin;
+    busConfig.miso_io_num = -1;
+    busConfig.sclk_io_num = shcpPin;
+    busConfig.quadwp_io_num = -1;
+    busConfig.quadhd_io_num = -1;
+    busConfig.max_transfer_sz = MAX_BYTES;
+
+    // 74HC595：SHCP 上升沿移位 (SPI mode 0)，STCP 上升沿锁存（CS 事务结束时拉高）
+    spi_device_interface_config_t deviceConfig = {};
+    deviceConfig.mode = 0;
+    deviceConfig.clock_speed_hz = SHIFT_REGISTER_SPI_CLOCK_HZ;
+    deviceConfig.spics_io_num = stcpPin;
+    deviceConfig.queue_size = SLOT_COUNT;
+
+    if (spi_bus_initialize(SPI3_HOST, &busConfig, SPI_DMA_DISABLED) != ESP_OK ||
+        spi_bus_add_device(SPI3_HOST, &deviceConfig, &device) != ESP_OK) {
+        device = nullptr;
+        Serial.println("[HC595] Error: SPI init failed");
+        return false;
+    }
+    return true;
+}
+
+// 回收已完成的事务槽
+void SpiShiftBus::reclaim(TickType_t wait) {
+    spi_transaction_t* done = nullptr;
+    while (inFlight > 0 && spi_device_get_trans_result(device, &done, wait) == ESP_OK) {
+        inFlight--;
+        wait = 0;
+    }
+}
+
+bool SpiShiftBus::transmit(const uint8_t* bytes, int count) {
+    if (device == nullptr || count > MAX_BYTES) return false;
+
+    // 槽位用尽时等待最早的事务完成（24 位 @ 10MHz 约 2.4us）；事务按序完成，轮转的下一槽即最早的槽
+    reclaim(0);
+    if (inFlight >= SLOT_COUNT) reclaim(1);
+    if (inFlight >= SLOT_COUNT) return false;
+
+    int slot = nextSlot;
+    nextSlot = (nextSlot + 1) % SLOT_COUNT;
+    memcpy(buffers[slot], bytes, count);
+
+    spi_transaction_t& t = transactions[slot];
+    memset(&t, 0, sizeof(t));
+    t.length = count * 8;
+    t.tx_buffer = buffers[slot];
+    if (spi_device_queue_trans(device, &t, 0) != ESP_OK) return false;
+    inFlight++;
+    return true;
 }
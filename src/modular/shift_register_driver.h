@@ -2,27 +2,127 @@
 #define SHIFT_REGISTER_DRIVER_H
 
 #include <Arduino.h>
+#include <type_traits>
+#include <driver/spi_master.h>
+#include "../config.h"
 
 /**
- * @brief 74HC595 移位寄存器硬件驱动
- * 负责 3 个级联芯片的串屏输出（芯片2：出口4-7，芯片1：出口0-3，芯片0：LED）
+ * @brief 74HC595 级联链输出帧
+ * bytes[0] 最先移出，最终停留在链路最远端的芯片（当前为芯片2：出口0-3）
+ */
+template <int CHAIN_LENGTH>
+struct ShiftRegisterFrame {
+    uint8_t bytes[CHAIN_LENGTH];
+
+    bool operator==(const ShiftRegisterFrame& other) const {
+        for (int i = 0; i < CHAIN_LENGTH; i++) {
+            if (bytes[i] != other.bytes[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const ShiftRegisterFrame& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief 软件位操作后端（shiftOut，阻塞，每位两次 digitalWrite）
+ */
+class BitBangShiftBus {
+private:
+    int dsPin, shcpPin, stcpPin;
+
+public:
+    BitBangShiftBus(int ds, int shcp, int stcp) : dsPin(ds), shcpPin(shcp), stcpPin(stcp) {}
+    bool begin();
+    bool transmit(const uint8_t* bytes, int count);
+};
+
+/**
+ * @brief 硬件 SPI 后端（DS/SHCP/STCP 对应 MOSI/SCK/CS）
+ * 事务排队后立即返回，由 SPI 外设移位；CS 在事务结束时拉高，其上升沿即 74HC595 的锁存脉冲。
+ * 使用少量轮转的事务槽，发送缓冲在事务完成前保持有效。
  */
-class ShiftRegisterDriver {
+class SpiShiftBus {
+public:
+    static const int MAX_BYTES = 16;    // 单帧最大字节数（非 DMA 传输上限为 64）
+    static const int SLOT_COUNT = 2;
+
 private:
-    uint32_t lastShiftData;
     int dsPin, shcpPin, stcpPin;
+    spi_device_handle_t device;
+    spi_transaction_t transactions[SLOT_COUNT];
+    uint8_t buffers[SLOT_COUNT][MAX_BYTES];
+    int nextSlot;
+    int inFlight;
+
+    void reclaim(TickType_t wait);
 
 public:
-    ShiftRegisterDriver(int ds, int shcp, int stcp);
-    
-    // 初始化引脚
-    void initialize();
-    
-    // 写入数据（带脏检查）
-    void write(uint8_t chip2, uint8_t chip1, uint8_t led);
-    
-    // 强制刷新（忽略脏检查）
-    void forceUpdate(uint8_t chip2, uint8_t chip1, uint8_t led);
+    SpiShiftBus(int ds, int shcp, int stcp)
+        : dsPin(ds), shcpPin(shcp), stcpPin(stcp), device(nullptr), nextSlot(0), inFlight(0) {}
+    bool begin();
+    bool transmit(const uint8_t* bytes, int count);
 };
 
+/**
+ * @brief 74HC595 移位寄存器硬件驱动
+ * 链长度为编译期参数（当前 3 片：芯片2：出口0-3，芯片1：出口4-7，芯片0：LED），
+ * 扩展出口或指示灯只需增加 CHAIN_LENGTH。写入带脏检查，帧不变时不产生任何总线活动。
+ */
+template <int CHAIN_LENGTH, typename Bus>
+class ShiftRegisterChain {
+public:
+    typedef ShiftRegisterFrame<CHAIN_LENGTH> Frame;
+
+private:
+    Bus bus;
+    Frame lastFrame;
+    bool hasLastFrame;
+
+    // 帧刷新耗时统计 (us)，用于比较位操作与 SPI 两种后端
+    uint32_t lastTransmitUs;
+    uint32_t maxTransmitUs;
+    uint32_t frameCount;
+
+public:
+    ShiftRegisterChain(int ds, int shcp, int stcp)
+        : bus(ds, shcp, stcp), hasLastFrame(false), lastTransmitUs(0), maxTransmitUs(0), frameCount(0) {}
+
+    // 初始化引脚 / 外设
+    void initialize() { bus.begin(); }
+
+    // 写入数据（带脏检查），返回是否实际发送
+    bool write(const Frame& frame) {
+        if (hasLastFrame && frame == lastFrame) return false;
+        forceUpdate(frame);
+        return true;
+    }
+
+    // 强制刷新（忽略脏检查）；发送失败时不记录，下一次 write() 会重试
+    void forceUpdate(const Frame& frame) {
+        uint32_t start = micros();
+        bool sent = bus.transmit(frame.bytes, CHAIN_LENGTH);
+        lastTransmitUs = micros() - start;
+        if (lastTransmitUs > maxTransmitUs) maxTransmitUs = lastTransmitUs;
+        if (!sent) {
+            hasLastFrame = false;
+            return;
+        }
+        frameCount++;
+
+        // 同步记录，以防后续 write() 冗余
+        lastFrame = frame;
+        hasLastFrame = true;
+    }
+
+    uint32_t getLastTransmitUs() const { return lastTransmitUs; }
+    uint32_t getMaxTransmitUs() const { return maxTransmitUs; }
+    uint32_t getFrameCount() const { return frameCount; }
+};
+
+static_assert(SHIFT_REGISTER_CHAIN_LENGTH <= SpiShiftBus::MAX_BYTES, "Shift register chain too long for SpiShiftBus");
+
+// 按配置选择后端
+typedef std::conditional<SHIFT_REGISTER_USE_SPI, SpiShiftBus, BitBangShiftBus>::type ShiftRegisterBus;
+typedef ShiftRegisterChain<SHIFT_REGISTER_CHAIN_LENGTH, ShiftRegisterBus> ShiftRegisterDriver;
+
 #endif // SHIFT_REGISTER_DRIVER_H
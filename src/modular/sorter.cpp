@@ -1,31 +1,61 @@
 #include "sorter.h"
 #include "HardwareSerial.h"
-#include "user_interface/oled.h"
 #include "../config.h"
 #include "tray_system.h"
+#include "cycle_profiler.h"
+#include "deferred_log.h"
 #include <Arduino.h>
 #include <cstddef>
 #include <EEPROM.h>
+#include <esp_timer.h>
 
 Sorter::Sorter() :
-    flagScanStart(false), 
-    flagDataLatch(false), 
-    flagOutletExecute(false), 
-    flagOutletReset(false),
-    lastSpeedCheckTime(0),
-    lastEncoderPosition(0), 
-    lastSpeed(0.0f), 
+    phaseScheduler(ENCODER_MAX_PHASE),
+    decodedLatchCount(0),
+    pendingExecuteMask(0), 
+    pendingResetMask(0),
+    controlTask(nullptr),
     lastObjectCount(0),
-    shiftDriver(PIN_HC595_DS, PIN_HC595_SHCP, PIN_HC595_STCP)
+    positionMask(0),
+    openPulseMask(0),
+    closePulseMask(0),
+    shiftDriver(PIN_HC595_DS, PIN_HC595_SHCP, PIN_HC595_STCP),
+    actuationScheduler(OUTLET_MAX_CONCURRENT_COILS, OUTLET_PULSE_STAGGER_US),
+    pulseTimer(nullptr)
 {
     // 实例化互斥锁
     mutex = xSemaphoreCreateMutex();
+    outputMutex = xSemaphoreCreateMutex();
 
     // 实例获取
     encoder = Encoder::getInstance();
+    speedEstimator = encoder->getSpeedEstimator();
     simpleHmi = SimpleHMI::getInstance();
     trayManager = TraySystem::getInstance();
     scanner = DiameterScanner::getInstance(); // 初始化scanner指针，防止空指针异常
+    scanner->setEdgeClock(speedEstimator);    // 传感器跳变按编码器边沿时间戳做亚相位插值
+    trace = TraceRecorder::getInstance();
+    
+    // 注册分拣时序事件（注册顺序与 SorterPhaseEvent 一致），初始为零速时的名义相位
+    phaseScheduler.addEvent(PHASE_SCAN_START);
+    phaseScheduler.addEvent(PHASE_DATA_LATCH);
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        plannedExecutePhases[i] = PHASE_OUTLET_EXECUTE;
+        phaseScheduler.addEvent(PHASE_OUTLET_EXECUTE);
+    }
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        plannedResetPhases[i] = PHASE_OUTLET_RESET;
+        phaseScheduler.addEvent(PHASE_OUTLET_RESET);
+    }
+    phaseScheduler.setEventCallback(this, onSchedulerPhaseEvent);
+    for (int i = 0; i < SORTER_PHASE_EVENT_COUNT; i++) {
+        eventTimestampUs[i] = 0;
+    }
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        scheduledActuations[i] = 0;
+        requestDeadlinesUs[i] = 0;
+    }
+    outputFrame = ShiftRegisterDriver::Frame();
     
     // 构造函数仅进行基础变量重置，所有硬件和业务参数初始化统一由 initialize() 处理
 }
@@ -43,8 +73,19 @@ void Sorter::initialize() {
         outlets[i].initialize();
     }
     
+    // 脉冲截止定时器（在 esp_timer 任务中回调）
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onPulseTimer;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "outlet_pulse";
+    if (esp_timer_create(&timerArgs, &pulseTimer) != ESP_OK) {
+        pulseTimer = nullptr;
+        Serial.println("[Sorter] Error: failed to create pulse timer");
+    }
+
     // 执行一次物理引脚同步
-    updateShiftRegisters();
+    commitOutlets();
     Serial.println("Sorter components initialized (Software states set).");
     
     // 初始化托盘系统
@@ -94,6 +135,35 @@ void Sorter::restoreOutletConfig() {
     for (uint8_t i = 0; i < NUM_OUTLETS; i++) {
         outlets[i].initialize();
     }
+
+    compileDecisionTable();
+}
+
+// 将出口配置编译为查找表，并报告区间重叠/空档（调用方持有 mutex 或处于初始化阶段）
+void Sorter::compileDecisionTable() {
+    OutletRule rules[NUM_OUTLETS];
+    for (uint8_t i = 0; i < NUM_OUTLETS; i++) {
+        rules[i].minMm = outlets[i].getMatchDiameterMin();
+        rules[i].maxMm = outlets[i].getMatchDiameterMax();
+        rules[i].lengthMask = outlets[i].getTargetLength();
+        rules[i].enabled = !(i == 0 && outlet0Mode == 0); // 出口 0 多物检测模式不参与直径分级
+    }
+    decisionTable.compile(rules, NUM_OUTLETS);
+
+    // 调用方持有 mutex：经延迟日志输出，不在锁内等待串口
+    if (decisionTable.getOverlapCells() > 0 || decisionTable.getGapCells() > 0) {
+        LOG_WARN("[Sorter] Outlet ranges: %d overlap cells (first %dmm), %d gap cells (first %dmm)\n",
+                 decisionTable.getOverlapCells(), decisionTable.getFirstOverlapMm(),
+                 decisionTable.getGapCells(), decisionTable.getFirstGapMm());
+    }
+}
+
+// 锁存时对新托盘做一次出口判定（查表），结果随托盘记录移动，之后各分流点只做比较
+uint8_t Sorter::decideOutlet(const TrayRecord& record) const {
+    static_assert(OutletDecisionTable::NO_OUTLET == TRAY_NO_OUTLET, "Outlet selection must use the tray 'no outlet' marker");
+    bool lowConfidence = (record.flags & TRAY_FLAG_LOW_CONFIDENCE) != 0;
+    return selectOutlet(decisionTable, outletDivergencePoints, NUM_OUTLETS, outlet0Mode,
+                        record.diameterDeciMm, record.lengthLevel, record.scanCount, lowConfidence);
 }
 
 // 初始化出口位置实现
@@ -110,20 +180,242 @@ void Sorter::initializeDivergencePoints(const uint8_t positions[NUM_OUTLETS]) {
 }
 
 void Sorter::onPhaseChange(int phase) {
+    PROFILE_SCOPE(PROBE_PHASE_CALLBACK);
+    // 0. 事件追踪：相位与此刻的传感器电平（时间戳复用编码器 ISR 刚记录的边沿时刻）
+    if (TRACE_RECORDER_ENABLED) {
+        if (phase == 255) {
+            trace->record(TRACE_ZERO, (uint32_t)esp_timer_get_time(), 0, 0);
+        } else {
+            trace->record(TRACE_PHASE, speedEstimator->getLastEdgeTicks(), DiameterScanner::readPackedLevels(), phase);
+        }
+    }
+
     // 1. 实时采样（必须在中断中完成）
     scanner->sample(phase); 
     
-    // 2. 标志位置位（原子化记录事件，等待 run() 处理）
-    switch (phase) {
-        case PHASE_SCAN_START:    flagScanStart = true;     break;
-        case PHASE_DATA_LATCH:    
-            scanner->stop(); // 关键：立即在中断中停止，彻底解决因任务调度延迟导致的计数溢出
-            flagDataLatch = true;     
-            break;
-        case PHASE_OUTLET_EXECUTE: flagOutletExecute = true; break;
-        case PHASE_OUTLET_RESET:   flagOutletReset = true;   break;
-        default: break;
+    // 2. 阈值穿越判定：触发自上次回调以来被越过的所有事件（Z 相信号 255 不参与）
+    phaseScheduler.onPhase(phase);
+}
+
+// 标志位置位（原子化记录事件，等待 run() 处理）
+void Sorter::onPhaseEvent(int eventId) {
+    if (eventId == EVENT_SCAN_START) {
+        scanner->start(); // 在中断中取空闲缓冲开始采集，与任务侧解码上一帧互不干扰
+    } else if (eventId == EVENT_DATA_LATCH) {
+        scanner->latch(); // 关键：立即在中断中停止并移交缓冲，解码时机不再受任务调度延迟影响
+        // 跳相时本次更新的剩余区间内可能还有执行/复位相位，调度器会按改写后的阈值继续判定
+        applyActuationTiming();
+    } else if (eventId < EVENT_OUTLET_RESET_BASE) {
+        pendingExecuteMask.fetch_or(1u << (eventId - EVENT_OUTLET_EXECUTE_BASE));
+    } else if (eventId < SORTER_PHASE_EVENT_COUNT) {
+        pendingResetMask.fetch_or(1u << (eventId - EVENT_OUTLET_RESET_BASE));
+    }
+
+    // 扫描起始在 ISR 内已处理完毕；其余事件需控制任务跟进
+    if (eventId != EVENT_SCAN_START && eventId < SORTER_PHASE_EVENT_COUNT) {
+        eventTimestampUs[eventId] = (uint32_t)esp_timer_get_time();
+        notifyControlTask();
+    }
+}
+
+// 唤醒控制任务（ISR 上下文）：若其优先级高于被中断任务，中断返回后立即切换
+void Sorter::notifyControlTask() {
+    if (!CONTROL_TASK_EVENT_DRIVEN || controlTask == nullptr) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(controlTask, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+TickType_t Sorter::getWakeTimeoutTicks() {
+    // 脉冲截止由脉冲定时器处理，控制任务只需按空闲超时更新速度估计
+    TickType_t ticks = pdMS_TO_TICKS(CONTROL_TASK_IDLE_TIMEOUT_MS);
+    return (ticks > 0) ? ticks : 1;
+}
+
+// 处理出口脉冲：登记新请求 -> 错峰/限流起动 -> 为新脉冲装定截止时刻，返回下一次需要处理的延迟
+// 调度器状态只在持有 outputMutex 时访问；出口脉冲状态与输出位图与 run()/诊断共享，只在 pulseMux 内读写
+bool Sorter::serviceOutlets(uint32_t nowUs, uint32_t& delayUs) {
+    // 1. 出口登记的换向请求交给起动调度器（最迟在登记时推算的截止时刻起动）
+    //    每次都重新登记：请求在起动前被反向改写时，脉宽与截止时刻随之更新
+    uint32_t pendingMask = 0;
+    uint32_t pendingWidthUs[NUM_OUTLETS];
+    uint32_t pendingDeadlineUs[NUM_OUTLETS];
+    portENTER_CRITICAL(&pulseMux);
+    for (uint8_t i = 0; i < NUM_OUTLETS; i++) {
+        if (!outlets[i].hasPendingPulse()) continue;
+        pendingMask |= (1u << i);
+        pendingWidthUs[i] = outlets[i].getPendingPulseWidthUs();
+        pendingDeadlineUs[i] = requestDeadlinesUs[i];
+    }
+    portEXIT_CRITICAL(&pulseMux);
+
+    for (uint8_t i = 0; i < NUM_OUTLETS; i++) {
+        if (pendingMask & (1u << i)) {
+            actuationScheduler.request(i, pendingWidthUs[i], pendingDeadlineUs[i]);
+        } else {
+            actuationScheduler.cancel(i);
+        }
+    }
+    uint32_t started = actuationScheduler.dispatch(nowUs);
+
+    // 2. 起动脉冲并更新输出位图；取出新发出脉冲的起始时刻与宽度
+    uint32_t newPulses = 0;
+    uint32_t openPulses = 0;
+    uint32_t pulseStartUs[NUM_OUTLETS];
+    uint32_t pulseWidthUs[NUM_OUTLETS];
+    portENTER_CRITICAL(&pulseMux);
+    for (uint8_t i = 0; i < NUM_OUTLETS; i++) {
+        if (started & (1u << i)) {
+            outlets[i].startPendingPulse();
+            updateOutletMasks(i);
+        }
+        uint32_t actuations = outlets[i].getActuationCount();
+        if (actuations == scheduledActuations[i]) continue;
+        scheduledActuations[i] = actuations;
+        if (outlets[i].isOpenPulseActive() || outlets[i].isClosePulseActive()) {
+            newPulses |= (1u << i);
+            if (outlets[i].isOpenPulseActive()) openPulses |= (1u << i);
+            pulseStartUs[i] = outlets[i].getPulseStartUs();
+            pulseWidthUs[i] = outlets[i].getPulseWidthUs();
+        }
+    }
+    portEXIT_CRITICAL(&pulseMux);
+
+    // 3. 为新发出的脉冲装定截止时刻（以出口记录的起始时刻为准，与何时被发现无关）
+    for (uint8_t i = 0; i < NUM_OUTLETS; i++) {
+        if (!(newPulses & (1u << i))) continue;
+        pulseScheduler.start(i, pulseStartUs[i], pulseWidthUs[i]);
+        trace->record(TRACE_PULSE, nowUs, i | ((openPulses & (1u << i)) ? 0x80 : 0), pulseWidthUs[i] / 1000);
+    }
+
+    // 4. 定时器在下一个脉冲截止或下一个可起动时刻（取较早者）触发
+    uint32_t endDelay = 0;
+    uint32_t startDelay = 0;
+    bool endPending = pulseScheduler.nextDelay(nowUs, endDelay);
+    bool startPending = actuationScheduler.nextDelay(nowUs, startDelay);
+    if (endPending && startPending) {
+        delayUs = (endDelay < startDelay) ? endDelay : startDelay;
+    } else {
+        delayUs = endPending ? endDelay : startDelay;
+    }
+    return endPending || startPending;
+}
+
+void Sorter::armPulseTimer(bool pending, uint32_t delayUs) {
+    if (!pending || pulseTimer == nullptr) return;
+    esp_timer_stop(pulseTimer);  // 未运行时返回错误，可忽略
+    esp_timer_start_once(pulseTimer, delayUs);
+}
+
+void Sorter::commitOutlets() {
+    if (xSemaphoreTake(outputMutex, portMAX_DELAY) != pdTRUE) return;
+    uint32_t delayUs = 0;
+    bool pending = serviceOutlets((uint32_t)esp_timer_get_time(), delayUs);
+    updateShiftRegisters();
+    flushShiftRegisters();
+    armPulseTimer(pending, delayUs);
+    xSemaphoreGive(outputMutex);
+}
+
+void Sorter::onPulseTimer(void* arg) {
+    static_cast<Sorter*>(arg)->handlePulseTimer();
+}
+
+// 脉冲定时器到期：结束所有已到期的脉冲并立即刷新输出，再装定下一个截止时刻
+void Sorter::handlePulseTimer() {
+    PROFILE_SCOPE(PROBE_PULSE_TIMER);
+    if (xSemaphoreTake(outputMutex, portMAX_DELAY) != pdTRUE) return;
+    uint32_t nowUs = (uint32_t)esp_timer_get_time();
+    uint32_t expired = pulseScheduler.expire(nowUs);
+    portENTER_CRITICAL(&pulseMux);
+    for (uint8_t i = 0; i < NUM_OUTLETS; i++) {
+        if (expired & (1u << i)) {
+            outlets[i].endPulse();
+            updateOutletMasks(i);
+        }
+    }
+    portEXIT_CRITICAL(&pulseMux);
+
+    // 起动等待中的请求，期间由诊断模式登记的脉冲也在此一并处理
+    uint32_t delayUs = 0;
+    bool pending = serviceOutlets(nowUs, delayUs);
+    updateShiftRegisters();
+    flushShiftRegisters();
+    armPulseTimer(pending, delayUs);
+    xSemaphoreGive(outputMutex);
+}
+
+// 记录单个事件从 ISR 触发到被 run() 处理的延迟
+void Sorter::recordEventLatency(int eventId, uint32_t nowUs) {
+    eventLatency.record(nowUs - eventTimestampUs[eventId]);
+}
+
+void Sorter::resetEventLatency() {
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        eventLatency.reset();
+        xSemaphoreGive(mutex);
+    }
+}
+
+void Sorter::printEventLatencyReport() {
+    const LatencyHistogram& h = eventLatency;
+    Serial.printf("[Sorter] Event latency (%s): n=%u min=%uus avg=%uus p99<=%uus max=%uus\n",
+                  CONTROL_TASK_EVENT_DRIVEN ? "event" : "poll",
+                  h.getCount(), h.getMinUs(), h.getAverageUs(), h.percentileUpperBoundUs(99), h.getMaxUs());
+    Serial.printf("[Sorter] Coils: peak=%d/%d minSlack=%dus missed=%u forced=%u\n",
+                  actuationScheduler.getPeakConcurrent(), OUTLET_MAX_CONCURRENT_COILS,
+                  (int)actuationScheduler.getMinSlackUs(), actuationScheduler.getMissCount(),
+                  actuationScheduler.getForcedCount());
+    Serial.printf("[Sorter] HC595 (%s): frames=%u last=%uus max=%uus\n",
+                  SHIFT_REGISTER_USE_SPI ? "spi" : "bitbang", shiftDriver.getFrameCount(),
+                  shiftDriver.getLastTransmitUs(), shiftDriver.getMaxTransmitUs());
+    for (int b = 0; b < LatencyHistogram::BUCKET_COUNT; b++) {
+        if (h.getBucket(b) == 0) continue;
+        uint32_t upper = LatencyHistogram::bucketUpperBoundUs(b);
+        if (upper) {
+            Serial.printf("  <%6uus : %u\n", upper, h.getBucket(b));
+        } else {
+            Serial.printf("  >=%5uus : %u\n", LatencyHistogram::bucketUpperBoundUs(b - 1), h.getBucket(b));
+        }
+    }
+}
+
+// 导出格式（主机端 src/host/trace_replay 解析）：
+//   [TRACE] BEGIN v1 total=<累计条数> kept=<保留条数>
+//   [TRACE] CONFIG offset=<相位偏移> outlet0Mode=<模式>
+//   [TRACE] OUTLET <i> min=<mm> max=<mm> len=<长度掩码>
+//   [TRACE] TRAY <位置> d=<0.1mm> n=<数量> len=<长度> occ=<有物> conf=<置信度> flags=<标志> outlet=<出口>
+//   [TRACE] D <每条 16 个十六进制字符，最多 8 条>
+//   [TRACE] END
+// 托盘队列快照与暂停记录在同一把锁内完成，回放据此还原追踪开始前已在队列中的托盘
+void Sorter::dumpTrace() {
+    TraySnapshot snapshot;
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(100)) != pdTRUE) return;
+    trace->pause();
+    trayManager->getSnapshot(snapshot);
+    xSemaphoreGive(mutex);
+    vTaskDelay(1);  // 让另一核上正在进行的写入完成
+
+    Serial.printf("[TRACE] BEGIN v1 total=%u kept=%u\n", trace->getTotalCount(), trace->getRetainedCount());
+    Serial.printf("[TRACE] CONFIG offset=%d outlet0Mode=%d\n", encoder->getPhaseOffset(), outlet0Mode);
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        Serial.printf("[TRACE] OUTLET %d min=%d max=%d len=%d\n", i, outlets[i].getMatchDiameterMin(),
+                      outlets[i].getMatchDiameterMax(), outlets[i].getTargetLength());
+    }
+    for (int p = 0; p < TRAY_QUEUE_POSITIONS; p++) {
+        const TrayRecord& r = snapshot.records[p];
+        Serial.printf("[TRACE] TRAY %d d=%u n=%u len=%u occ=%u conf=%u flags=%u outlet=%u\n", p,
+                      r.diameterDeciMm, r.scanCount, r.lengthLevel, r.occupied, r.confidence, r.flags, r.outlet);
     }
+    trace->printRecords();
+    Serial.println("[TRACE] END");
+    trace->resume();
+}
+
+void Sorter::onSchedulerPhaseEvent(void* context, int eventId) {
+    static_cast<Sorter*>(context)->onPhaseEvent(eventId);
 }
 
 // 实现静态回调函数
@@ -135,70 +427,143 @@ void Sorter::onEncoderPhaseChange(void* context, int phase) {
 // 主循环处理函数 (事件驱动消费)
 void Sorter::run() {
     if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) != pdTRUE) return;
+    PROFILE_SCOPE(PROBE_CONTROL_RUN);
 
-    // 1. 速度更新逻辑（每 100ms 计算一次）
-    if (millis() - lastSpeedCheckTime >= 100) {
-        lastSpeedCheckTime = millis();
-        long currentPulse = encoder->getRawCount();
-        long diff = currentPulse - lastEncoderPosition;
-        lastEncoderPosition = currentPulse;
-        lastSpeed = (float)diff / 20.0f; 
-    }
+    // 1. 速度更新（基于 ISR 记录的边沿时间戳，每次循环更新）
+    speedEstimator->update((uint32_t)esp_timer_get_time());
+    updateActuationTiming();
 
     // 2. 异步事件消费 (处理由 onPhaseChange 置位的标志位)
 
-    // A. 启动扫描阶段 (50)
-    if (flagScanStart) {
-        scanner->start();
-        flagScanStart = false;
-    } 
-
-    // B. 数据锁存阶段 (170) -> 这里完成物体的判定
-    if (flagDataLatch) {
-        int diameterMm = scanner->getDiameterAndStop();
+    // A/B. 数据锁存阶段 (170) -> 按锁存顺序解码已移交的扫描帧，完成物体的判定
+    //      扫描起始 (50) 与缓冲切换均在 ISR 中完成；解码可落后采集一帧而不丢数据
+    uint32_t nowUs = (uint32_t)esp_timer_get_time();
+    uint32_t latched = scanner->getLatchCount();
+    if (decodedLatchCount != latched) recordEventLatency(EVENT_DATA_LATCH, nowUs);
+    while (decodedLatchCount != latched) {
+        PROFILE_SCOPE(PROBE_LATCH_DECODE);
+        // 丢帧（解码落后超过一帧）时按空托盘补位，保证托盘队列与实际托架对齐
+        bool captured = scanner->decodeFrame(decodedLatchCount);
+        int diameterDeciMm = scanner->getDiameterDeciMm();
         int objectCount = scanner->getTotalObjectCount();
         int lengthLevel = scanner->getLengthLevel();
+        uint8_t confidence = scanner->getConfidence();
+
+        uint8_t flags = 0;
+        if (!captured) flags |= TRAY_FLAG_FRAME_DROPPED;
+        if (diameterDeciMm > 0 && confidence < SCANNER_MIN_CONFIDENCE) flags |= TRAY_FLAG_LOW_CONFIDENCE;
         
-        // 推送到托盘系统的起始端
-        trayManager->pushNewAsparagus(diameterMm, objectCount, lengthLevel);
+        // 推送到托盘系统的起始端（0.1mm 精度，附带融合置信度与一次性判定的目标出口）
+        TrayRecord record = TraySystem::makeRecord(diameterDeciMm, objectCount, lengthLevel, confidence, flags);
+        record.outlet = decideOutlet(record);
+        trayManager->pushTray(record);
+        trace->record(TRACE_LATCH, nowUs, record.outlet, record.diameterDeciMm);
+        trace->record(TRACE_LATCH_INFO, nowUs, record.flags,
+                      record.confidence | (record.scanCount << 8) | (record.lengthLevel << 12) | (record.occupied << 15));
         prepareOutlets(); // 预计算出口状态
         
-        flagDataLatch = false;
+        decodedLatchCount++;
     }
 
-    // C. 执行分拣动作 (30)
-    if (flagOutletExecute) {
+    // C. 执行分拣动作 (名义 30，按速度提前)
+    // D. 重置/关闭驱动信号 (名义 150，高速时提前以保证下一托盘到达前闭合)
+    //    出口脉冲状态与脉冲定时器共享：pulseMux 内只登记换向请求，延迟统计与起动调度都在临界区外
+    //    换向请求的最迟起动时刻由触发事件推算，同样在临界区外计算
+    uint32_t executeMask = pendingExecuteMask.exchange(0);
+    uint32_t resetMask = pendingResetMask.exchange(0);
+    uint32_t executeDeadlineUs[NUM_OUTLETS];
+    uint32_t resetDeadlineUs[NUM_OUTLETS];
+    float speed = speedEstimator->getVelocity();
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        if (executeMask & (1u << i)) {
+            recordEventLatency(EVENT_OUTLET_EXECUTE_BASE + i, nowUs);
+            executeDeadlineUs[i] = planRequestDeadline(EVENT_OUTLET_EXECUTE_BASE + i, i,
+                                                       outlets[i].isReadyToOpen(), speed);
+        }
+        if (resetMask & (1u << i)) {
+            recordEventLatency(EVENT_OUTLET_RESET_BASE + i, nowUs);
+            resetDeadlineUs[i] = planRequestDeadline(EVENT_OUTLET_RESET_BASE + i, i, false, speed);
+        }
+    }
+    if (executeMask | resetMask) {
+        portENTER_CRITICAL(&pulseMux);
         for (int i = 0; i < NUM_OUTLETS; i++) {
+            if (!(executeMask & (1u << i))) continue;
             outlets[i].execute();
+            requestDeadlinesUs[i] = executeDeadlineUs[i];
         }
-        flagOutletExecute = false;
-    }
-
-    // D. 重置/关闭驱动信号 (150)
-    if (flagOutletReset) {
         for (int i = 0; i < NUM_OUTLETS; i++) {
-            if (outlets[i].shouldStayOpenNext()) continue;
+            if (!(resetMask & (1u << i)) || outlets[i].shouldStayOpenNext()) continue;
             outlets[i].setReadyToOpen(false);
             outlets[i].execute();
+            requestDeadlinesUs[i] = resetDeadlineUs[i];
         }
-        flagOutletReset = false;
+        portEXIT_CRITICAL(&pulseMux);
     }
 
-    // 3. 通用物理更新（每帧执行，处理脉冲宽度管理）
-    for (uint8_t i = 0; i < NUM_OUTLETS; i++) {
-        outlets[i].update();
-    }
-    updateShiftRegisters();
+    // 3. 错峰起动新脉冲、装定截止时刻并刷新输出（推迟的起动与脉冲结束由脉冲定时器完成）
+    commitOutlets();
 
     xSemaphoreGive(mutex);
 }
 
 
 
+// 根据实测速度与各出口机械延迟规划打开/关闭相位
+void Sorter::updateActuationTiming() {
+    float speed = speedEstimator->getVelocity();
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        // 提前量包含起动调度可能的推迟，错峰后翻板仍在托盘到达分流点前到位；打开与关闭行程分别计算
+        int openLead = latencyToLeadPhases(speed, outlets[i].getMechanicalLatencyMs() + OUTLET_ACTUATION_BUDGET_MS,
+                                           ENCODER_MAX_PHASE);
+        int closeLead = latencyToLeadPhases(speed, outlets[i].getCloseLatencyMs() + OUTLET_ACTUATION_BUDGET_MS,
+                                            ENCODER_MAX_PHASE);
+        ActuationPhases phases = computeActuationPhases(PHASE_OUTLET_EXECUTE, PHASE_OUTLET_RESET,
+                                                        PHASE_DATA_LATCH, ENCODER_MAX_PHASE,
+                                                        OUTLET_MIN_DROP_PHASES, openLead, closeLead);
+        plannedExecutePhases[i] = phases.executePhase;
+        plannedResetPhases[i] = phases.resetPhase;
+    }
+}
+
+// 换向请求的最迟起动时刻：翻板须在托盘下一次到达分流点 (PHASE_OUTLET_EXECUTE) 前完成本次行程；
+// 事件号越界时没有触发相位可依，按静止处理
+uint32_t Sorter::planRequestDeadline(int eventId, uint8_t outletIndex, bool open, float speed) const {
+    if (eventId < 0 || eventId >= SORTER_PHASE_EVENT_COUNT || outletIndex >= NUM_OUTLETS) {
+        return (uint32_t)esp_timer_get_time() + OUTLET_IDLE_ACTUATION_SLACK_MS * 1000u;
+    }
+    uint16_t latencyMs = open ? outlets[outletIndex].getMechanicalLatencyMs() : outlets[outletIndex].getCloseLatencyMs();
+    return actuationDeadlineUs(eventTimestampUs[eventId], phaseScheduler.getEventPhase(eventId),
+                               PHASE_OUTLET_EXECUTE, ENCODER_MAX_PHASE, speed, latencyMs,
+                               OUTLET_IDLE_ACTUATION_SLACK_MS * 1000u);
+}
+
+// 将规划相位写入调度器（ISR 上下文，仅整数拷贝）
+void Sorter::applyActuationTiming() {
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        phaseScheduler.setEventPhase(EVENT_OUTLET_EXECUTE_BASE + i, plannedExecutePhases[i]);
+        phaseScheduler.setEventPhase(EVENT_OUTLET_RESET_BASE + i, plannedResetPhases[i]);
+    }
+}
+
+int Sorter::getOutletExecutePhase(uint8_t outletIndex) const {
+    return (outletIndex < NUM_OUTLETS) ? phaseScheduler.getEventPhase(EVENT_OUTLET_EXECUTE_BASE + outletIndex) : -1;
+}
+
+int Sorter::getOutletResetPhase(uint8_t outletIndex) const {
+    return (outletIndex < NUM_OUTLETS) ? phaseScheduler.getEventPhase(EVENT_OUTLET_RESET_BASE + outletIndex) : -1;
+}
+
 // 出口控制公共方法实现
 void Sorter::setOutletState(uint8_t outletIndex, bool open) {
+    // 手动操作没有托盘到达时刻，按静止处理
+    uint32_t deadlineUs = (uint32_t)esp_timer_get_time() + OUTLET_IDLE_ACTUATION_SLACK_MS * 1000u;
+    portENTER_CRITICAL(&pulseMux);
     outlets[outletIndex].setReadyToOpen(open);
     outlets[outletIndex].execute();
+    requestDeadlinesUs[outletIndex] = deadlineUs;
+    portEXIT_CRITICAL(&pulseMux);
+    commitOutlets();
 }
 
 // 获取特定出口对象的指针（用于诊断模式同步，返回地址）
@@ -210,60 +575,37 @@ Outlet* Sorter::getOutlet(uint8_t index) {
 
 // 实现预设出口功能
 void Sorter::prepareOutlets() {
+    PROFILE_SCOPE(PROBE_PREPARE_OUTLETS);
     uint8_t capacity = TraySystem::getCapacity();
-    int asparagusLength = scanner->getLengthLevel();
-
-    // 定义统一的匹配判定逻辑 (Lambda)
-    auto isMatch = [&](int p, int outletIdx) -> bool {
-        if (p < 0 || p >= capacity) return false;
-        
-        if (outletIdx == 0 && outlet0Mode == 0) {
-            // 出口 0 的特殊识别模式：多物体/碎料检测
-            return trayManager->getTrayScanCount(p) > 1;
-        }
-
-        // 通用直径匹配
-        int diameter = trayManager->getTrayDiameter(p);
-        if (diameter <= 0) return false; // 排除空位或无效数据
 
-        int minD = outlets[outletIdx].getMatchDiameterMin();
-        int maxD = outlets[outletIdx].getMatchDiameterMax();
-        
-        // 统一区间判定 (minD < diameter <= maxD)
-        if (diameter <= minD || diameter > maxD) return false;
-
-        // 【新增阶段】长度匹配 (位掩码逻辑)
-        int detectedLength = trayManager->getTrayLengthLevel(p);
-        uint8_t targetLenMask = outlets[outletIdx].getTargetLength();
-        if (targetLenMask != LEN_ALL && targetLenMask != LEN_NONE) {
-            // detectedLength 也是一个 LengthMask (LEN_S, LEN_M, LEN_L)
-            // 直接通过位与运算判定是否在允许范围内
-            if (!(targetLenMask & detectedLength)) return false;
-        }
-
-        return true;
-    };
+    // 一次无锁读取所有托盘位置，之后的判定只访问快照（不再逐项加锁，也不会因取锁失败误判为空托盘）
+    trayManager->getSnapshot(traySnapshot);
 
     for (int i = 0; i < NUM_OUTLETS; i++) {
         int pos = outletDivergencePoints[i];
-        
-        bool currentMatch = isMatch(pos, i);
-        // [预判前瞻] 此处暂不考虑长度前瞻，仅以直径合意为准或需精确判定
-        bool nextMatch = isMatch(pos - 1, i);
 
-        outlets[i].setReadyToOpen(currentMatch);
-        outlets[i].setStayOpenNext(currentMatch && nextMatch);
+        // 托盘分类：目标出口已在锁存时确定，此处仅做比较；丢帧托盘内容未知，不能当作空托盘
+        auto classify = [&](int p) -> HoldSlot {
+            if (p < 0 || p >= capacity) return HOLD_SLOT_OTHER;
+            const TrayRecord& tray = traySnapshot.records[p];
+            if (tray.outlet == i) return HOLD_SLOT_TARGET;
+            if (!tray.occupied && !(tray.flags & TRAY_FLAG_FRAME_DROPPED)) return HOLD_SLOT_EMPTY;
+            return HOLD_SLOT_OTHER;
+        };
+
+        HoldSlot current = classify(pos);
+        // 上一周期已决定保持打开（当前为中间的空托盘）时继续保持，否则仅目标物品打开
+        bool open = (current == HOLD_SLOT_TARGET) ||
+                    (current == HOLD_SLOT_EMPTY && outlets[i].shouldStayOpenNext());
+
+        outlets[i].setReadyToOpen(open);
+        outlets[i].setStayOpenNext(open && planHoldOpen(pos, OUTLET_HOLD_LOOKAHEAD, classify));
     }
 }
 
-// 获取最新直径
+// 获取最新直径（托盘系统读取为无锁快照，无需 Sorter 互斥锁）
 int Sorter::getLatestDiameter() {
-    int val = 0;
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        val = trayManager->getTrayDiameter(0);
-        xSemaphoreGive(mutex);
-    }
-    return val;
+    return trayManager->getTrayDiameter(0);
 }
 
 // 获取已经输送的托架数量
@@ -273,14 +615,14 @@ int Sorter::getTransportedTrayCount() {
     // 注：此计数来自编码器，编码器本身是原子读取，无需 Sorter 互斥锁保护
 }
 
-// 获取传送带速度（托架/秒）- 返回float类型
+// 获取传送带速度（托架/秒）- 估计值以原子变量发布，无需互斥锁
 float Sorter::getConveyorSpeedPerSecond() {
-    float val = 0.0f;
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        val = lastSpeed;
-        xSemaphoreGive(mutex);
-    }
-    return val;
+    return speedEstimator->getVelocity();
+}
+
+// 获取传送带加速度（托架/秒²）
+float Sorter::getConveyorAcceleration() {
+    return speedEstimator->getAcceleration();
 }
 
 // 获取显示数据（用于 UserInterface）
@@ -314,6 +656,7 @@ void Sorter::setOutletMinDiameter(uint8_t outletIndex, int minDiameter) {
     if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
         if (outletIndex < NUM_OUTLETS) {
             outlets[outletIndex].setMatchDiameterMin(minDiameter);
+            compileDecisionTable();
         }
         xSemaphoreGive(mutex);
     }
@@ -324,53 +667,63 @@ void Sorter::setOutletMaxDiameter(uint8_t outletIndex, int maxDiameter) {
     if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
         if (outletIndex < NUM_OUTLETS) {
             outlets[outletIndex].setMatchDiameterMax(maxDiameter);
+            compileDecisionTable();
         }
         xSemaphoreGive(mutex);
     }
 }
 
-
-void Sorter::updateShiftRegisters() {
-    uint8_t ledByte = 0;      // Byte 0 (Index 0): 8个 LED
-    uint8_t chip1Byte = 0;    // Byte 1 (Index 1): 出口 0-3 的 H 桥对
-    uint8_t chip2Byte = 0;    // Byte 2 (Index 2): 出口 4-7 的 H 桥对
-    
-    // 构建 LED 指示灯位图 (反映当前物理位置)
-    for (int i = 0; i < NUM_OUTLETS; i++) {
-        if (outlets[i].isPositionOpen()) {
-            // 硬件映射修正：0-3 位正常映射，4-7 位反向映射 (7-6-5-4)
-            if (i < 4) {
-                ledByte |= (1 << i);
-            } else {
-                // i=4 -> bit 7, i=5 -> bit 6, i=6 -> bit 5, i=7 -> bit 4
-                ledByte |= (1 << (7 - (i - 4)));
-            }
+// 设置出口目标长度
+void Sorter::setOutletTargetLength(uint8_t outletIndex, uint8_t lengthMask) {
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        if (outletIndex < NUM_OUTLETS) {
+            outlets[outletIndex].setTargetLength(lengthMask);
+            compileDecisionTable();
         }
+        xSemaphoreGive(mutex);
     }
+}
 
-    // 构建电磁铁 H 桥位图 (每 2 位控制一个电磁铁)
-    // 根据硬件修正：Chip 1 控制出口 4-7
-    for (int i = 0; i < 4; i++) {
-        if (outlets[i + 4].isOpenPulseActive()) {
-            chip1Byte |= (1 << (i * 2));     // Bit 0, 2, 4, 6 为 Open 信号
-        }
-        if (outlets[i + 4].isClosePulseActive()) {
-            chip1Byte |= (1 << (i * 2 + 1)); // Bit 1, 3, 5, 7 为 Close 信号
-        }
+// 设置出口 0 模式
+void Sorter::setOutlet0Mode(uint8_t mode) {
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        outlet0Mode = mode;
+        compileDecisionTable();
+        xSemaphoreGive(mutex);
     }
-    
-    // 根据硬件修正：Chip 2 控制出口 0-3
-    for (int i = 0; i < 4; i++) {
-        if (outlets[i].isOpenPulseActive()) {
-            chip2Byte |= (1 << (i * 2));     // 对位到 Chip 2 的 Bit 0, 2, 4, 6
-        }
-        if (outlets[i].isClosePulseActive()) {
-            chip2Byte |= (1 << (i * 2 + 1)); // 对位到 Chip 2 的 Bit 1, 3, 5, 7
-        }
+}
+
+
+// 由单个出口的状态刷新输出位图
+void Sorter::updateOutletMasks(uint8_t outletIndex) {
+    uint32_t bit = 1u << outletIndex;
+    positionMask = outlets[outletIndex].isPositionOpen() ? (positionMask | bit) : (positionMask & ~bit);
+    openPulseMask = outlets[outletIndex].isOpenPulseActive() ? (openPulseMask | bit) : (openPulseMask & ~bit);
+    closePulseMask = outlets[outletIndex].isClosePulseActive() ? (closePulseMask | bit) : (closePulseMask & ~bit);
+}
+
+void Sorter::updateShiftRegisters() {
+    PROFILE_SCOPE(PROBE_UPDATE_SHIFT);
+    portENTER_CRITICAL(&pulseMux);
+    uint32_t position = positionMask;
+    uint32_t openPulse = openPulseMask;
+    uint32_t closePulse = closePulseMask;
+    portEXIT_CRITICAL(&pulseMux);
+
+    // 按布线表组帧（LED 反序、芯片对调等板级差异均在 BOARD_OUTLET_WIRING_TABLE 中描述）
+    ShiftRegisterDriver::Frame frame = ShiftRegisterDriver::Frame();
+    OutletFramePacker<BoardOutletWiring>::pack(frame.bytes, position, openPulse, closePulse);
+    outputFrame = frame;
+}
+
+// 发送最新输出帧（由 Driver 负责脏检查）
+void Sorter::flushShiftRegisters() {
+    PROFILE_SCOPE(PROBE_FLUSH_SHIFT);
+    if (shiftDriver.write(outputFrame)) {
+        // 帧追踪只覆盖前 3 个字节（当前级联长度）
+        trace->record(TRACE_FRAME, (uint32_t)esp_timer_get_time(), outputFrame.bytes[0],
+                      outputFrame.bytes[1] | (outputFrame.bytes[2] << 8));
     }
-    
-    // 物理刷新 (由 Driver 负责脏检查)
-    shiftDriver.write(chip2Byte, chip1Byte, ledByte);
 }
 void Sorter::saveConfig() {
     Serial.println("[Sorter] Saving configuration to EEPROM...");
@@ -382,5 +735,11 @@ void Sorter::saveConfig() {
     }
     EEPROM.write(EEPROM_ADDR_OUTLET0_MODE, outlet0Mode);
     EEPROM.commit();
+
+    // 保存时重新编译一次，确保查找表与已持久化的配置一致（也覆盖经 getOutlet() 直接修改的情况）
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        compileDecisionTable();
+        xSemaphoreGive(mutex);
+    }
     Serial.println("[Sorter] Configuration saved successfully.");
 }
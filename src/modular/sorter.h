@@ -5,12 +5,26 @@
 #include "tray_system.h"
 #include "outlet.h"
 #include "shift_register_driver.h"
+#include "phase_scheduler.h"
+#include "actuation_timing.h"
+#include "outlet_decision_table.h"
+#include "outlet_hold_planner.h"
+#include "latency_histogram.h"
+#include "pulse_scheduler.h"
+#include "actuation_scheduler.h"
+#include "outlet_wiring.h"
+#include "trace_recorder.h"
 #include "../config.h"
 #include "main.h"
 #include "user_interface/simple_hmi.h"
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <atomic>
+#include <esp_timer.h>
+
+static_assert(BoardOutletWiring::OUTLET_COUNT == NUM_OUTLETS, "Outlet wiring table must cover NUM_OUTLETS");
+static_assert(BoardOutletWiring::CHAIN_LENGTH == SHIFT_REGISTER_CHAIN_LENGTH, "Outlet wiring table must match the 74HC595 chain");
+static_assert(SHIFT_REGISTER_CHAIN_LENGTH == 3, "TRACE_FRAME records carry exactly three 74HC595 bytes");
 
 // 定义分拣系统参数
 // 注：NUM_OUTLETS 及其它全局物理定义已在 config.h 中由中央管理
@@ -18,6 +32,16 @@
 // 托盘相关常量已在 TraySystem 中定义，此处仅保留逻辑引用
 static const int EMPTY_TRAY = 0;  
 
+// 分拣时序事件（注册到相位调度器，编号即注册顺序）
+// 执行/复位事件按出口拆分，触发相位随速度动态补偿
+enum SorterPhaseEvent {
+    EVENT_SCAN_START = 0,
+    EVENT_DATA_LATCH,
+    EVENT_OUTLET_EXECUTE_BASE,                                  // + 出口索引
+    EVENT_OUTLET_RESET_BASE = EVENT_OUTLET_EXECUTE_BASE + NUM_OUTLETS, // + 出口索引
+    SORTER_PHASE_EVENT_COUNT = EVENT_OUTLET_RESET_BASE + NUM_OUTLETS
+};
+
 // 定义Sorter类
 class Sorter {
 private:
@@ -33,29 +57,77 @@ private:
     Encoder* encoder;
     SimpleHMI* simpleHmi;
     TraySystem* trayManager;
+    TraceRecorder* trace;
 
-
+    
+    // 相位阈值穿越调度器：保证跳相时分拣事件不丢失
+    PhaseEventScheduler<SORTER_PHASE_EVENT_COUNT> phaseScheduler;
     
     // 状态触发标志位 (ISR 置位, run() 消费)
-    std::atomic<bool> flagScanStart;
-    std::atomic<bool> flagDataLatch;
-    std::atomic<bool> flagOutletExecute;
-    std::atomic<bool> flagOutletReset;
-    
-    // 速度计算相关变量
-    unsigned long lastSpeedCheckTime;
-    long lastEncoderPosition;  // 上次编码器位置
-    float lastSpeed;  // 上一次计算的速度值，用于过滤短时间差的异常值
+    // 扫描起始/锁存由 ISR 直接驱动扫描仪的乒乓缓冲，run() 按锁存序号依次解码
+    uint32_t decodedLatchCount;                // 已解码（已推入托盘系统）的锁存序号
+    std::atomic<uint32_t> pendingExecuteMask; // 待执行出口位图 (bit i = 出口 i)
+    std::atomic<uint32_t> pendingResetMask;   // 待复位出口位图
+    
+    // 事件驱动调度：相位事件 ISR 通知控制任务，并记录事件时间戳用于统计处理延迟
+    TaskHandle_t controlTask;
+    volatile uint32_t eventTimestampUs[SORTER_PHASE_EVENT_COUNT];
+    LatencyHistogram eventLatency;             // 事件 -> run() 处理 的延迟分布（仅控制任务写入）
+    void notifyControlTask();
+    void recordEventLatency(int eventId, uint32_t nowUs);
+
+    // 按速度补偿后的各出口触发相位（任务侧计算，锁存事件时由 ISR 写入调度器）
+    volatile int plannedExecutePhases[NUM_OUTLETS];
+    volatile int plannedResetPhases[NUM_OUTLETS];
+    
+    // 出口配置编译得到的 直径×长度 -> 出口位掩码 查找表（配置变化时重新编译，持有 mutex 时访问）
+    OutletDecisionTable decisionTable;
+    void compileDecisionTable();
+    uint8_t decideOutlet(const TrayRecord& record) const;  // 锁存时为新托盘确定唯一目标出口
+
+    // 出口预判使用的托盘快照（仅控制任务访问，作为成员以免占用任务栈）
+    TraySnapshot traySnapshot;
+    
+    // 速度估计（边沿时间戳 M/T 法，见 SpeedEstimator）
+    SpeedEstimator* speedEstimator;
     int lastObjectCount;  // 保留用于向后兼容
     
     // 私有方法
     void prepareOutlets();
     void restoreOutletConfig(); // Initializes EEPROM and creates outlets
     void initializeDivergencePoints(const uint8_t positions[NUM_OUTLETS]);
+    void updateActuationTiming();  // 根据实测速度与各出口机械延迟重新规划触发相位
+    void applyActuationTiming();   // 将规划结果写入调度器（锁存事件 ISR 中调用）
     
     // 74HC595 硬件驱动 (支持 3 级联：LED + Open Coils + Close Coils)
-    void updateShiftRegisters();
+    // 输出帧由出口输出位图的快照生成，再由 flushShiftRegisters() 发送（SPI 排队不能在临界区内进行）
+    void updateShiftRegisters();   // 持有 outputMutex 时调用
+    void flushShiftRegisters();    // 持有 outputMutex 时调用
+    // 出口输出状态位图 (bit i = 出口 i)，在脉冲起动/结束时更新，组帧直接按布线表展开
+    uint32_t positionMask;         // 翻板物理位置为打开
+    uint32_t openPulseMask;        // 正在发出打开脉冲
+    uint32_t closePulseMask;       // 正在发出关闭脉冲
+    void updateOutletMasks(uint8_t outletIndex);  // 持有 pulseMux 时调用
     ShiftRegisterDriver shiftDriver;
+    ShiftRegisterDriver::Frame outputFrame;
+    SemaphoreHandle_t outputMutex;  // 串行化各任务的出口调度、组帧与发送，保证最后发送的总是最新帧
+
+    // 脉冲起动：出口只登记换向请求，由起动调度器错峰、限流后按截止时刻最早优先发出
+    ActuationScheduler<NUM_OUTLETS> actuationScheduler;
+
+    // 脉冲截止：单次 esp_timer 在最早的截止时刻触发，结束到期脉冲并立即刷新移位寄存器，
+    // 脉宽不再受控制循环节拍影响
+    PulseScheduler<NUM_OUTLETS> pulseScheduler;
+    uint32_t scheduledActuations[NUM_OUTLETS];  // 已装定截止时刻的脉冲序号（对应 Outlet::getActuationCount）
+    uint32_t requestDeadlinesUs[NUM_OUTLETS];   // 已登记换向请求的最迟起动时刻（与请求一同在 pulseMux 内写入）
+    uint32_t planRequestDeadline(int eventId, uint8_t outletIndex, bool open, float speed) const;
+    esp_timer_handle_t pulseTimer;
+    portMUX_TYPE pulseMux = portMUX_INITIALIZER_UNLOCKED; // 仅保护出口脉冲状态与输出位图（控制任务 / 定时器任务）
+    bool serviceOutlets(uint32_t nowUs, uint32_t& delayUs); // 持有 outputMutex 时调用
+    void armPulseTimer(bool pending, uint32_t delayUs);
+    void commitOutlets();                        // 装定新脉冲并刷新输出
+    static void onPulseTimer(void* arg);
+    void handlePulseTimer();
 
     // 线程安全互斥锁
     SemaphoreHandle_t mutex;
@@ -70,9 +142,44 @@ public:
     
     // 主循环处理函数 (FSM Executor)
     void run();
+
+    // 事件驱动调度：登记控制任务，ISR 在相位事件时直接唤醒它
+    void setControlTask(TaskHandle_t task) { controlTask = task; }
+    // 控制任务阻塞等待的最长时间：有脉冲进行中时到脉冲结束，否则为空闲超时
+    TickType_t getWakeTimeoutTicks();
+
+    // 相位事件处理延迟分布（诊断用）
+    const LatencyHistogram& getEventLatency() const { return eventLatency; }
+    void resetEventLatency();
+    void printEventLatencyReport();
+
+    // 线圈起动调度统计（诊断用）
+    int getPeakConcurrentCoils() const { return actuationScheduler.getPeakConcurrent(); }
+    int32_t getMinActuationSlackUs() const { return actuationScheduler.getMinSlackUs(); }
+    uint32_t getActuationMissCount() const { return actuationScheduler.getMissCount(); }
+    uint32_t getForcedActuationCount() const { return actuationScheduler.getForcedCount(); }
+    uint32_t getActuationDispatchCount() const { return actuationScheduler.getDispatchedCount(); }
+
+    // 导出事件追踪：暂停记录，经串口输出配置与全部保留记录后恢复（供主机端回放）
+    void dumpTrace();
+
+    // 移位寄存器帧刷新耗时 (us)（诊断用，比较位操作与 SPI 后端）
+    uint32_t getShiftFrameMaxUs() const { return shiftDriver.getMaxTransmitUs(); }
     
     // 采样回调函数（供编码器调用，参数为相位）
     void onPhaseChange(int phase);
+    
+    // 相位事件回调（由 phaseScheduler 在 ISR 中按穿越顺序调用）
+    void onPhaseEvent(int eventId);
+    static void onSchedulerPhaseEvent(void* context, int eventId);
+    
+    // 相位跳变统计（单次前进超过 1 个相位的次数 / 累计跳过的相位数）
+    uint32_t getPhaseSkipOccurrences() const { return phaseScheduler.getSkipOccurrences(); }
+    uint32_t getSkippedPhaseCount() const { return phaseScheduler.getSkippedPhases(); }
+    
+    // 获取出口当前生效的打开/关闭触发相位（诊断用）
+    int getOutletExecutePhase(uint8_t outletIndex) const;
+    int getOutletResetPhase(uint8_t outletIndex) const;
 
 
     
@@ -93,18 +200,31 @@ public:
     // 获取已经输送的托架数量
     int getTransportedTrayCount();
     
-    // 获取传送带速度（托架/秒，返回float类型）
+    // 获取传送带速度（托架/秒，返回float类型，无锁）
     float getConveyorSpeedPerSecond();
     
+    // 获取传送带加速度（托架/秒²，无锁）
+    float getConveyorAcceleration();
+    
     // 获取和设置出口直径范围的方法
     int getOutletMinDiameter(uint8_t outletIndex);
     int getOutletMaxDiameter(uint8_t outletIndex);
     void setOutletMinDiameter(uint8_t outletIndex, int minDiameter);
     void setOutletMaxDiameter(uint8_t outletIndex, int maxDiameter);
+    void setOutletTargetLength(uint8_t outletIndex, uint8_t lengthMask);
+    
+    // 出口分流点（托盘队列位置）
+    uint8_t getOutletDivergencePoint(uint8_t outletIndex) const {
+        return (outletIndex < NUM_OUTLETS) ? outletDivergencePoints[outletIndex] : 0;
+    }
     
     // 出口 0 模式控制 (0: 多物检测, 1: 直径分级)
     uint8_t getOutlet0Mode() { return outlet0Mode; }
-    void setOutlet0Mode(uint8_t mode) { outlet0Mode = mode; }
+    void setOutlet0Mode(uint8_t mode);
+
+    // 出口配置检查：重叠/空档的 (直径 mm, 长度) 格数
+    int getOutletOverlapCells() const { return decisionTable.getOverlapCells(); }
+    int getOutletGapCells() const { return decisionTable.getGapCells(); }
     
     // 配置持久化
     void saveConfig();
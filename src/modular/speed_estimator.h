@@ -0,0 +1,174 @@
+#ifndef SPEED_ESTIMATOR_H
+#define SPEED_ESTIMATOR_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * 基于边沿时间戳的 M/T 法速度估计器
+ *
+ * - ISR 侧：recordEdge() 仅记录时间戳、周期与净计数（顺序锁写入，几条指令）
+ * - 任务侧：update() 取 "上次更新以来的边沿数 M" 与 "首尾边沿之间的精确时间 T"，
+ *   v = M / T。高速时 M 大（M 法），低速时 M = 1 退化为单周期测量（T 法），
+ *   没有新边沿时以 "距最后一个边沿的时间" 作为速度上界，实现平滑衰减与停转检测。
+ * - 结果以原子 float 发布，UI 等其它任务读取时无需加锁
+ * - 时间单位为抽象 tick（由构造参数给定频率），纯逻辑实现，可在主机上用合成时间戳驱动
+ */
+class SpeedEstimator {
+public:
+    /**
+     * @param ticksPerSecond 时间戳频率（esp_timer 为 1000000）
+     * @param edgesPerTray   每个托架对应的编码器边沿数
+     * @param stallTimeoutTicks 超过该时长无边沿则判定停转，速度归零
+     */
+    SpeedEstimator(uint32_t ticksPerSecond, int edgesPerTray, uint32_t stallTimeoutTicks) :
+        ticksToTraysPerSecond((float)ticksPerSecond / (float)edgesPerTray),
+        ticksPerSecondF((float)ticksPerSecond),
+        stallTicks(stallTimeoutTicks),
+        seq(0),
+        edgeCount(0),
+        lastEdgeTicks(0),
+        lastPeriodTicks(0),
+        hasPreviousEdge(false),
+        hasEdgeReference(false),
+        prevCount(0),
+        prevEdgeTicks(0),
+        prevVelocityEdgeTicks(0),
+        velocity(0.0f),
+        acceleration(0.0f) {}
+
+    /**
+     * 记录一个编码器边沿（ISR 上下文）
+     * @param timestamp 边沿时间戳
+     * @param step 方向 (+1 / -1)
+     */
+    inline void recordEdge(uint32_t timestamp, int step) {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        // 复位后的第一个边沿、停转后重新起步的第一个边沿没有有效的前一个边沿，周期记为 0（未知）
+        uint32_t period = timestamp - lastEdgeTicks;
+        lastPeriodTicks = (hasPreviousEdge && period < stallTicks) ? period : 0;
+        hasPreviousEdge = true;
+        lastEdgeTicks = timestamp;
+        edgeCount += step;
+        std::atomic_thread_fence(std::memory_order_release);
+        seq.store(s + 2, std::memory_order_relaxed);
+    }
+
+    /**
+     * 更新速度与加速度估计（单一任务调用）
+     * @param now 当前时间戳（与 recordEdge 同一时基）
+     */
+    void update(uint32_t now) {
+        int32_t count;
+        uint32_t edgeTicks;
+        bool edgeSeen;
+        readSnapshot(count, edgeTicks, edgeSeen);
+
+        if (!hasEdgeReference) {
+            // 以第一个真实边沿建立参考点，不输出速度（此前的时间戳 0 不是边沿时刻）
+            if (!edgeSeen) return;
+            prevCount = count;
+            prevEdgeTicks = edgeTicks;
+            prevVelocityEdgeTicks = edgeTicks;
+            hasEdgeReference = true;
+            return;
+        }
+
+        int32_t m = count - prevCount;
+        float v = velocity.load(std::memory_order_relaxed);
+
+        if (m != 0) {
+            uint32_t t = edgeTicks - prevEdgeTicks;
+            if (t >= stallTicks) {
+                // 首尾边沿之间跨越了停转：重新以最新边沿建立参考点，下一次更新再输出速度
+                prevCount = count;
+                prevEdgeTicks = edgeTicks;
+                prevVelocityEdgeTicks = edgeTicks;
+                return;
+            }
+            if (t == 0) t = 1;
+            float newV = (float)m * ticksToTraysPerSecond / (float)t;
+
+            // 加速度：相邻两次估计之间以边沿时间计差分，并做一阶低通
+            uint32_t dtTicks = edgeTicks - prevVelocityEdgeTicks;
+            if (dtTicks > 0) {
+                float a = (newV - v) * ticksPerSecondF / (float)dtTicks;
+                float prevA = acceleration.load(std::memory_order_relaxed);
+                acceleration.store(prevA + ACCEL_SMOOTHING * (a - prevA), std::memory_order_relaxed);
+            }
+            prevVelocityEdgeTicks = edgeTicks;
+
+            velocity.store(newV, std::memory_order_relaxed);
+            prevCount = count;
+            prevEdgeTicks = edgeTicks;
+            return;
+        }
+
+        // 无新边沿：速度不可能高于 "1 个边沿 / 距最后边沿的时间"
+        uint32_t since = now - prevEdgeTicks;
+        if (since >= stallTicks) {
+            velocity.store(0.0f, std::memory_order_relaxed);
+            acceleration.store(0.0f, std::memory_order_relaxed);
+            return;
+        }
+        if (since > 0) {
+            float bound = ticksToTraysPerSecond / (float)since;
+            if (v > bound) velocity.store(bound, std::memory_order_relaxed);
+            else if (v < -bound) velocity.store(-bound, std::memory_order_relaxed);
+        }
+    }
+
+    // 速度（托架/秒，带方向）
+    float getVelocity() const { return velocity.load(std::memory_order_relaxed); }
+
+    // 加速度（托架/秒²）
+    float getAcceleration() const { return acceleration.load(std::memory_order_relaxed); }
+
+    // 是否已停转（速度归零）
+    bool isStalled() const { return getVelocity() == 0.0f; }
+
+    // 最近一个边沿的时间戳与周期（供亚相位插值等 ISR 侧使用），周期为 0 表示未知
+    uint32_t getLastEdgeTicks() const { return lastEdgeTicks; }
+    uint32_t getLastPeriodTicks() const { return lastPeriodTicks; }
+
+private:
+    static constexpr float ACCEL_SMOOTHING = 0.2f;
+
+    const float ticksToTraysPerSecond;
+    const float ticksPerSecondF;
+    const uint32_t stallTicks;
+
+    // ISR 写入的数据（顺序锁保护）
+    std::atomic<uint32_t> seq;
+    volatile int32_t edgeCount;
+    volatile uint32_t lastEdgeTicks;
+    volatile uint32_t lastPeriodTicks;
+    volatile bool hasPreviousEdge;
+
+    // update() 私有状态
+    bool hasEdgeReference;
+    int32_t prevCount;
+    uint32_t prevEdgeTicks;
+    uint32_t prevVelocityEdgeTicks;
+
+    // 发布结果
+    std::atomic<float> velocity;
+    std::atomic<float> acceleration;
+
+    // 读取一致的 (count, edgeTicks, 是否已有边沿) 快照；被 ISR 打断则重试
+    void readSnapshot(int32_t& count, uint32_t& edgeTicks, bool& edgeSeen) const {
+        uint32_t s0, s1;
+        do {
+            s0 = seq.load(std::memory_order_acquire);
+            count = edgeCount;
+            edgeTicks = lastEdgeTicks;
+            edgeSeen = hasPreviousEdge;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = seq.load(std::memory_order_relaxed);
+        } while ((s0 & 1) || s0 != s1);
+    }
+};
+
+#endif // SPEED_ESTIMATOR_H
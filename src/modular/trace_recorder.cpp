@@ -0,0 +1,18 @@
+#include "trace_recorder.h"
+#include <Arduino.h>
+
+void TraceRecorder::printRecords() {
+    // 每行 8 条，行首 "[TRACE] D " 便于从混杂的串口日志中提取
+    static const uint32_t RECORDS_PER_LINE = 8;
+    char line[16 + RECORDS_PER_LINE * 16];
+    uint32_t count = getRetainedCount();
+    for (uint32_t i = 0; i < count; i += RECORDS_PER_LINE) {
+        int length = snprintf(line, sizeof(line), "[TRACE] D ");
+        for (uint32_t j = i; j < count && j < i + RECORDS_PER_LINE; j++) {
+            const TraceRecord& r = getRecord(j);
+            length += snprintf(line + length, sizeof(line) - length, "%08x%02x%02x%04x",
+                               (unsigned)r.timestampUs, r.type, r.arg8, r.arg16);
+        }
+        Serial.println(line);
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <stdint.h>
+#include <atomic>
+#include "../config.h"
+#include "../utils/singleton.h"
+
+static_assert(TRACE_RING_CAPACITY > 0 && (TRACE_RING_CAPACITY & (TRACE_RING_CAPACITY - 1)) == 0,
+              "TRACE_RING_CAPACITY must be a power of two");
+
+// 追踪记录类型（导出格式的一部分，只能追加）
+enum TraceType : uint8_t {
+    TRACE_NONE = 0,
+    TRACE_PHASE,        // 编码器相位：arg8 = 扫描传感器电平 (bit i = 通道 i)，arg16 = 逻辑相位
+    TRACE_ZERO,         // Z 相信号
+    TRACE_SENSOR,       // 扫描窗口内的传感器跳变中断：arg8 = 通道，arg16 = 电平
+    TRACE_LATCH,        // 锁存结果：arg8 = 目标出口，arg16 = 直径 (0.1mm)
+    TRACE_LATCH_INFO,   // 锁存结果（续）：arg8 = 标志位，arg16 = 置信度 | 数量 << 8 | 长度 << 12 | 有物 << 15
+    TRACE_PULSE,        // 线圈脉冲起动：arg8 = 出口 | 0x80 (打开)，arg16 = 脉宽 (ms)
+    TRACE_FRAME         // 74HC595 帧：arg8 = 第 0 字节，arg16 = 第 1 字节 | 第 2 字节 << 8
+};
+
+// 单条记录 8 字节：时间戳 (esp_timer us 低 32 位) + 类型 + 两个参数
+struct TraceRecord {
+    uint32_t timestampUs;
+    uint8_t type;
+    uint8_t arg8;
+    uint16_t arg16;
+};
+
+static_assert(sizeof(TraceRecord) == 8, "TraceRecord must stay packed into 8 bytes");
+
+/**
+ * 二进制事件追踪（RAM 环形缓冲）
+ *
+ * - 写入无锁：一次原子 fetch_add 取得槽位后写入 8 字节，ISR、定时器与控制任务可同时记录，
+ *   时间戳由调用方提供（通常复用已读取的边沿时间），每条记录只有十几条指令
+ * - 缓冲写满后覆盖最旧的记录，始终保留最近 TRACE_RING_CAPACITY 条
+ * - 导出前 pause()：暂停后的写入直接丢弃，读取期间内容不再变化
+ * - TRACE_RECORDER_ENABLED 为 false 时 record() 为空函数
+ */
+class TraceRecorder : public Singleton<TraceRecorder> {
+    friend class Singleton<TraceRecorder>;
+public:
+    static const uint32_t CAPACITY = TRACE_RING_CAPACITY;
+
+    inline void record(uint8_t type, uint32_t timestampUs, uint8_t arg8, uint16_t arg16) {
+        if (!TRACE_RECORDER_ENABLED || paused.load(std::memory_order_relaxed)) return;
+        uint32_t index = head.fetch_add(1, std::memory_order_relaxed) & (CAPACITY - 1);
+        TraceRecord& r = ring[index];
+        r.timestampUs = timestampUs;
+        r.type = type;
+        r.arg8 = arg8;
+        r.arg16 = arg16;
+    }
+
+    void pause() { paused.store(true); }
+    void resume() { paused.store(false); }
+    void clear() { head.store(0); }
+
+    // 累计写入条数（含已被覆盖的）与当前保留的条数
+    uint32_t getTotalCount() const { return head.load(); }
+    uint32_t getRetainedCount() const {
+        uint32_t total = head.load();
+        return (total < CAPACITY) ? total : CAPACITY;
+    }
+    // 保留记录中第 i 条（0 为最旧）
+    const TraceRecord& getRecord(uint32_t i) const {
+        uint32_t total = head.load();
+        uint32_t first = (total < CAPACITY) ? 0 : total - CAPACITY;
+        return ring[(first + i) & (CAPACITY - 1)];
+    }
+
+    // 以十六进制逐行输出保留的记录（每条 "ttttttttTTAAaaaa"），调用前应先 pause()
+    void printRecords();
+
+private:
+    TraceRecorder() : head(0), paused(false) {}
+
+    TraceRecord ring[CAPACITY];
+    std::atomic<uint32_t> head;
+    std::atomic<bool> paused;
+};
+
+#endif // TRACE_RECORDER_H
@@ -0,0 +1,80 @@
+#ifndef TRAY_RING_H
+#define TRAY_RING_H
+
+#include <stdint.h>
+
+/**
+ * 托盘环形队列（纯逻辑，无硬件依赖）
+ *
+ * 每推入一个托盘，全局托盘序号加一；槽位由序号取低位确定，推入为 O(1)，无需整体搬移。
+ * "距扫描位第 k 个位置的托盘" 即序号 (head - 1 - k)，查询只需一次减法与一次掩码。
+ * 超出 POSITIONS 个位置或早于最近一次 reset() 的托盘视为空托盘。
+ *
+ * @tparam Record    托盘记录类型，默认构造即为空托盘
+ * @tparam POSITIONS 逻辑位置数（扫描位 0 到最后一个出口之后）
+ */
+
+// 不小于 n 的最小 2 的幂（C++11 constexpr 递归形式）
+constexpr uint32_t trayRingCapacity(uint32_t n, uint32_t p = 1) {
+    return (p >= n) ? p : trayRingCapacity(n, p << 1);
+}
+
+template <typename Record, int POSITIONS>
+class TrayRing {
+public:
+    static const uint32_t CAPACITY = trayRingCapacity(POSITIONS);
+    static const uint32_t MASK = CAPACITY - 1;
+
+    TrayRing() : head(0), base(0) {}
+
+    // 在扫描位推入一个新托盘，原有托盘整体后移一个位置
+    void push(const Record& record) {
+        slots[head & MASK] = record;
+        head++;
+    }
+
+    // 清空所有位置（O(1)：仅移动有效起点）
+    void reset() { base = head; }
+
+    // 位置 k 上是否有有效托盘记录
+    bool isValid(int position) const {
+        if (position < 0 || position >= POSITIONS) return false;
+        return (uint32_t)position < head - base;
+    }
+
+    // 位置 k 上的托盘记录，无效位置返回空记录
+    Record at(int position) const {
+        return isValid(position) ? slots[(head - 1 - (uint32_t)position) & MASK] : Record();
+    }
+
+    // 位置 k 上托盘记录的可写引用，无效位置返回 nullptr（用于就地修改已推入的托盘）
+    Record* find(int position) {
+        return isValid(position) ? &slots[(head - 1 - (uint32_t)position) & MASK] : nullptr;
+    }
+
+    // 将位置 0 ~ count-1 的记录依次复制到 out（无效位置为空记录）
+    void copyPositions(Record* out, int count) const {
+        for (int k = 0; k < count; k++) {
+            out[k] = at(k);
+        }
+    }
+
+    // 位置 k 上托盘的序号（自启动以来第几个托盘，从 0 开始）
+    uint32_t sequenceAt(int position) const { return head - 1 - (uint32_t)position; }
+
+    // 已推入的托盘总数（下一个托盘的序号）
+    uint32_t getHead() const { return head; }
+
+private:
+    Record slots[CAPACITY];
+    uint32_t head;   // 下一个写入的序号
+    uint32_t base;   // 最近一次 reset() 时的序号，更早的托盘视为空
+};
+
+template <typename Record, int POSITIONS>
+const uint32_t TrayRing<Record, POSITIONS>::CAPACITY;
+
+template <typename Record, int POSITIONS>
+const uint32_t TrayRing<Record, POSITIONS>::MASK;
+
+#endif // TRAY_RING_H
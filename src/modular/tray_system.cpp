@@ -2,6 +2,10 @@
 #include <Arduino.h>
 #include <EEPROM.h>
 
+// 托盘快照需放入 EEPROM_ADDR_TRAY_DATA 与下一个配置区之间
+static_assert(1 + TRAY_QUEUE_POSITIONS * TRAY_RECORD_BYTES <= EEPROM_ADDR_PHASE_OFFSET - EEPROM_ADDR_TRAY_DATA,
+              "Tray EEPROM snapshot overlaps the phase offset area");
+
 // 初始化静态实例变量
 TraySystem* TraySystem::instance = nullptr;
 
@@ -9,15 +13,10 @@ TraySystem* TraySystem::instance = nullptr;
  * 构造函数实现
  */
 TraySystem::TraySystem() {
-    // 1. 创建互斥锁
+    // 1. 创建互斥锁（仅用于写入方之间串行化）
     mutex = xSemaphoreCreateMutex();
     
-    // 2. 初始化所有成员变量
-    for (uint8_t i = 0; i < QUEUE_CAPACITY; i++) {
-        asparagusDiameters[i] = EMPTY_TRAY;
-        asparagusCounts[i] = 0;
-        asparagusLengths[i] = 0;
-    }
+    // 2. 初始化统计数据（环形队列默认构造即为全空）
     totalIdentifiedItems = 0;
     totalTransportedTrays = 0;
     Serial.println("[TRAY] TraySystem instance created (Thread-safe).");
@@ -40,58 +39,68 @@ TraySystem* TraySystem::getInstance() {
     return instance;
 }
 
+/**
+ * 构造紧凑托盘记录实现
+ */
+TrayRecord TraySystem::makeRecord(int diameterDeciMm, int scanCount, int lengthLevel, uint8_t confidence,
+                                  uint8_t flags) {
+    TrayRecord record;
+    record.diameterDeciMm = (uint16_t)constrain(diameterDeciMm, 0, 0xFFFF);
+    record.scanCount = (uint8_t)constrain(scanCount, 0, 15);
+    record.lengthLevel = (uint8_t)(lengthLevel & LEN_ALL);
+    record.occupied = (diameterDeciMm > 0 || scanCount > 0) ? 1 : 0;
+    record.confidence = confidence;
+    record.flags = flags;
+    return record;
+}
+
 /**
  * 添加新直径数据实现
  */
-void TraySystem::pushNewAsparagus(int diameter, int scanCount, int lengthLevel) {
+void TraySystem::pushNewAsparagus(int diameterDeciMm, int scanCount, int lengthLevel, uint8_t confidence,
+                                  uint8_t flags) {
+    pushTray(makeRecord(diameterDeciMm, scanCount, lengthLevel, confidence, flags));
+}
+
+/**
+ * 推入托盘记录实现
+ */
+void TraySystem::pushTray(const TrayRecord& record) {
     if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        // 将所有现有数据向右移动一位
-        shiftToRight();
-        
-        // 在索引0处添加新数据
-        asparagusDiameters[0] = diameter;
-        asparagusCounts[0] = scanCount;
-        asparagusLengths[0] = lengthLevel;
+        // 在索引0处添加新数据，原有托盘随序号自动后移一个位置
+        seqLock.beginWrite();
+        trays.push(record);
+        seqLock.endWrite();
         
         // 映射：只有直径大于 6mm 的芦笋才算作一个有效 Item (每个托盘最多计 1 个)
-        if (diameter > 6 && scanCount > 0) {
+        if (record.diameterDeciMm > 60 && record.scanCount > 0) {
             totalIdentifiedItems++;
         }
         totalTransportedTrays++;
 
         xSemaphoreGive(mutex);
     } else {
-        Serial.println("[TRAY] Warning: Failed to get mutex in pushNewAsparagus");
+        Serial.println("[TRAY] Warning: Failed to get mutex in pushTray");
     }
 }
 
 /**
- * 移动托盘数据实现
+ * 改写托盘目标出口实现
  */
-void TraySystem::shiftToRight() {
-    // 从最后一个位置开始，向前移动数据
-    asparagusDiameters[QUEUE_CAPACITY - 1] = EMPTY_TRAY; // 最后一个位置数据丢弃
-    asparagusCounts[QUEUE_CAPACITY - 1] = 0; // 扫描次数重置为0
-    asparagusLengths[QUEUE_CAPACITY - 1] = 0;
-    
-    for (int8_t i = QUEUE_CAPACITY - 2; i >= 0; i--) {
-        if (asparagusDiameters[i] != EMPTY_TRAY) {
-            // 将当前位置数据复制到下一个位置
-            asparagusDiameters[i + 1] = asparagusDiameters[i];
-            asparagusCounts[i + 1] = asparagusCounts[i];
-            asparagusLengths[i + 1] = asparagusLengths[i];
-        } else {
-            asparagusDiameters[i + 1] = EMPTY_TRAY;
-            asparagusCounts[i + 1] = 0;
-            asparagusLengths[i + 1] = 0;
+bool TraySystem::setTrayOutlet(int index, uint8_t outlet) {
+    bool updated = false;
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        TrayRecord* record = trays.find(index);
+        if (record) {
+            seqLock.beginWrite();
+            record->outlet = outlet;
+            record->flags |= TRAY_FLAG_OVERRIDDEN;
+            seqLock.endWrite();
+            updated = true;
         }
-        // 重置当前位置
-        asparagusDiameters[i] = EMPTY_TRAY;
-        asparagusCounts[i] = 0;
-        asparagusLengths[i] = 0;
+        xSemaphoreGive(mutex);
     }
-    
-    // Serial.println("所有直径数据已向右移动");
+    return updated;
 }
 
 /**
@@ -99,56 +108,81 @@ void TraySystem::shiftToRight() {
  */
 void TraySystem::resetAllTraysData() {
     if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        for (uint8_t i = 0; i < QUEUE_CAPACITY; i++) {
-            asparagusDiameters[i] = EMPTY_TRAY;
-            asparagusCounts[i] = 0;
-            asparagusLengths[i] = 0;
-        }
+        seqLock.beginWrite();
+        trays.reset();
+        seqLock.endWrite();
         xSemaphoreGive(mutex);
         Serial.println("所有分拣数据已重置");
     }
 }
 
+/**
+ * 获取托盘快照实现（顺序锁读取：被写入打断则重试，从不阻塞写入方）
+ */
+void TraySystem::getSnapshot(TraySnapshot& out) const {
+    seqLock.read([&]() {
+        trays.copyPositions(out.records, QUEUE_CAPACITY);
+        out.headSequence = trays.getHead();
+    });
+}
+
+/**
+ * 获取单个托盘记录实现
+ */
+TrayRecord TraySystem::getTray(int index) const {
+    TrayRecord record;
+    seqLock.read([&]() { record = trays.at(index); });
+    return record;
+}
 
 /**
  * 获取托盘直径数据实现
  */
-int TraySystem::getTrayDiameter(int index) {
-    int val = EMPTY_TRAY;
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        if (index >= 0 && index < QUEUE_CAPACITY) {
-            val = asparagusDiameters[index];
-        }
-        xSemaphoreGive(mutex);
-    }
-    return val;
+int TraySystem::getTrayDiameter(int index) const {
+    return (getTray(index).diameterDeciMm + 5) / 10;
+}
+
+/**
+ * 获取托盘直径数据 (0.1mm) 实现
+ */
+int TraySystem::getTrayDiameterDeciMm(int index) const {
+    return getTray(index).diameterDeciMm;
 }
 
 /**
  * 获取托盘扫描次数实现
  */
-int TraySystem::getTrayScanCount(int index) {
-    int val = 0;
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        if (index >= 0 && index < QUEUE_CAPACITY) {
-            val = asparagusCounts[index];
-        }
-        xSemaphoreGive(mutex);
-    }
-    return val;
+int TraySystem::getTrayScanCount(int index) const {
+    return getTray(index).scanCount;
 }
 
 /**
  * 获取托盘长度等级实现
  */
-int TraySystem::getTrayLengthLevel(int index) {
-    int val = 0;
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        if (index >= 0 && index < QUEUE_CAPACITY) {
-            val = asparagusLengths[index];
-        }
-        xSemaphoreGive(mutex);
-    }
+int TraySystem::getTrayLengthLevel(int index) const {
+    return getTray(index).lengthLevel;
+}
+
+/**
+ * 获取托盘直径置信度实现
+ */
+uint8_t TraySystem::getTrayConfidence(int index) const {
+    return getTray(index).confidence;
+}
+
+/**
+ * 获取托盘目标出口实现
+ */
+uint8_t TraySystem::getTrayOutlet(int index) const {
+    return getTray(index).outlet;
+}
+
+/**
+ * 获取托盘序号实现
+ */
+uint32_t TraySystem::getTraySequence(int index) const {
+    uint32_t val;
+    seqLock.read([&]() { val = trays.sequenceAt(index); });
     return val;
 }
 
@@ -163,16 +197,18 @@ uint8_t TraySystem::getCapacity() {
  * 保存托盘数据到EEPROM实现
  */
 void TraySystem::saveToEEPROM(int startAddr) {
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
-        int addr = startAddr;
-        EEPROM.write(addr++, 0xCC);
-        for (uint8_t i = 0; i < QUEUE_CAPACITY; i++) {
-            EEPROM.put(addr, asparagusDiameters[i]);
-            addr += sizeof(int);
-            EEPROM.put(addr, asparagusCounts[i]);
-            addr += sizeof(int);
+    // 读取方：基于快照写入，不与控制任务争用互斥锁
+    TraySnapshot snapshot;
+    getSnapshot(snapshot);
+
+    int addr = startAddr;
+    EEPROM.write(addr++, EEPROM_MAGIC);
+    for (uint8_t i = 0; i < QUEUE_CAPACITY; i++) {
+        uint8_t bytes[TRAY_RECORD_BYTES];
+        packTrayRecord(snapshot.records[i], bytes);
+        for (int b = 0; b < TRAY_RECORD_BYTES; b++) {
+            EEPROM.write(addr++, bytes[b]);
         }
-        xSemaphoreGive(mutex);
     }
 }
 
@@ -183,13 +219,23 @@ void TraySystem::loadFromEEPROM(int startAddr) {
     if (xSemaphoreTake(mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
         int addr = startAddr;
         uint8_t magic = EEPROM.read(addr++);
-        if (magic == 0xCC) {
+        if (magic == EEPROM_MAGIC) {
+            // 快照按位置 0 (最新) 到末尾存储，从最旧的托盘开始依次推入以还原位置
+            TrayRecord records[QUEUE_CAPACITY];
             for (uint8_t i = 0; i < QUEUE_CAPACITY; i++) {
-                EEPROM.get(addr, asparagusDiameters[i]);
-                addr += sizeof(int);
-                EEPROM.get(addr, asparagusCounts[i]);
-                addr += sizeof(int);
+                uint8_t bytes[TRAY_RECORD_BYTES];
+                for (int b = 0; b < TRAY_RECORD_BYTES; b++) {
+                    bytes[b] = EEPROM.read(addr++);
+                }
+                records[i] = unpackTrayRecord(bytes);
+                if (records[i].occupied) records[i].flags |= TRAY_FLAG_RESTORED;
+            }
+            seqLock.beginWrite();
+            trays.reset();
+            for (int i = QUEUE_CAPACITY - 1; i >= 0; i--) {
+                trays.push(records[i]);
             }
+            seqLock.endWrite();
             Serial.println("[TRAY] Tray data restored from EEPROM.");
         } else {
             Serial.println("[TRAY] No valid tray data in EEPROM.");
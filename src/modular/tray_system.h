@@ -4,6 +4,77 @@
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <atomic>
+#include "../config.h"
+#include "tray_ring.h"
+#include "seq_lock.h"
+
+// 托盘记录标志位 (TrayRecord::flags)
+enum TrayFlag : uint8_t {
+    TRAY_FLAG_LOW_CONFIDENCE = 0x01,    // 直径融合置信度低于 SCANNER_MIN_CONFIDENCE
+    TRAY_FLAG_FRAME_DROPPED  = 0x02,    // 该托盘的扫描窗口因丢帧未被采集
+    TRAY_FLAG_RESTORED       = 0x04,    // 由 EEPROM 快照恢复
+    TRAY_FLAG_OVERRIDDEN     = 0x08     // 出口判定被上层策略改写（setTrayOutlet）
+};
+
+// TrayRecord::outlet 取值：不分流，随传送带流到末端
+static const uint8_t TRAY_NO_OUTLET = 0xFF;
+
+/**
+ * 单个托盘的数据记录（紧凑布局，6 字节，默认构造即为空托盘）
+ * 一次读取即得到该托盘的全部信息；EEPROM 持久化经 packTrayRecord / unpackTrayRecord 逐字节编码，不依赖位域布局
+ */
+struct TrayRecord {
+    uint16_t diameterDeciMm;    // 直径 (0.1mm)，0 表示空托盘
+    uint8_t scanCount : 4;      // 物体数量（饱和于 15）
+    uint8_t lengthLevel : 3;    // 长度等级 LengthMask (LEN_S / LEN_M / LEN_L)
+    uint8_t occupied : 1;       // 托盘上检测到物体
+    uint8_t confidence;         // 直径融合置信度 (0-100)
+    uint8_t flags;              // TrayFlag 位组合
+    uint8_t outlet;             // 锁存时判定的目标出口，TRAY_NO_OUTLET 表示不分流
+
+    TrayRecord() : diameterDeciMm(0), scanCount(0), lengthLevel(0), occupied(0),
+                   confidence(0), flags(0), outlet(TRAY_NO_OUTLET) {}
+};
+
+static_assert(sizeof(TrayRecord) == 6, "TrayRecord must stay packed into 6 bytes");
+
+// EEPROM 中每个托盘记录的字节数：
+//   [0] 直径低字节 [1] 直径高字节 [2] 数量 (bit 0-3) | 长度 (bit 4-6) | 有物 (bit 7)
+//   [3] 置信度 [4] 标志位 [5] 目标出口
+static const int TRAY_RECORD_BYTES = 6;
+
+inline void packTrayRecord(const TrayRecord& record, uint8_t* out) {
+    out[0] = (uint8_t)(record.diameterDeciMm & 0xFF);
+    out[1] = (uint8_t)(record.diameterDeciMm >> 8);
+    out[2] = (uint8_t)(record.scanCount | (record.lengthLevel << 4) | (record.occupied << 7));
+    out[3] = record.confidence;
+    out[4] = record.flags;
+    out[5] = record.outlet;
+}
+
+inline TrayRecord unpackTrayRecord(const uint8_t* in) {
+    TrayRecord record;
+    record.diameterDeciMm = (uint16_t)(in[0] | (in[1] << 8));
+    record.scanCount = in[2] & 0x0F;
+    record.lengthLevel = (in[2] >> 4) & 0x07;
+    record.occupied = (in[2] >> 7) & 0x01;
+    record.confidence = in[3];
+    record.flags = in[4];
+    record.outlet = in[5];
+    return record;
+}
+
+// 所有托盘位置的一致性快照（一次读取，之后的判定不再访问 TraySystem）
+struct TraySnapshot {
+    TrayRecord records[TRAY_QUEUE_POSITIONS];   // 按位置索引，0 为扫描位
+    uint32_t headSequence;                      // 已推入的托盘总数（位置 0 的序号 + 1）
+
+    // 位置 k 上的托盘记录，越界返回空记录
+    TrayRecord at(int position) const {
+        return (position >= 0 && position < TRAY_QUEUE_POSITIONS) ? records[position] : TrayRecord();
+    }
+};
 
 /**
  * 托盘系统类
@@ -13,29 +84,24 @@
 class TraySystem {
 private:
     // 常量定义
-    static const uint8_t QUEUE_CAPACITY = 18; // 索引 0-17
+    static const uint8_t QUEUE_CAPACITY = TRAY_QUEUE_POSITIONS; // 索引 0 ~ QUEUE_CAPACITY-1
     static const int EMPTY_TRAY = 0;  // 无效直径值，用于表示该位置没有芦笋
+    static const uint8_t EEPROM_MAGIC = 0xD0; // 19 个位置 x 逐字节编码的 TrayRecord（0xCF: 18 个位置，0xCE: 出口位掩码，0xCD: int 直径+次数，0xCC: 直径为 mm）
     
-    // 成员变量
-    int asparagusDiameters[QUEUE_CAPACITY];    // 存储每个芦笋的直径数据
-    int asparagusCounts[QUEUE_CAPACITY];    // 存储每个位置的芦笋数量
-    int asparagusLengths[QUEUE_CAPACITY];   // 存储每个芦笋的长度等级 (1:S, 2:M, 3:L)
+    // 成员变量：按托盘序号寻址的环形队列，推入新托盘为 O(1)，不再整体搬移
+    TrayRing<TrayRecord, TRAY_QUEUE_POSITIONS> trays;
     
     // 累计统计数据
     uint32_t totalIdentifiedItems;             // 自启动以来识别到的芦笋总数
     uint32_t totalTransportedTrays;            // 自启动以来经过的托盘总数
 
-    // 线程安全互斥锁
+    // 线程安全：写入方之间以互斥锁串行化；读取方经顺序锁 (seqlock) 无锁读取，从不阻塞
     SemaphoreHandle_t mutex;
+    SeqLock seqLock;
     
     // 单例实例
     static TraySystem* instance;
     
-    /**
-     * 将所有托盘数据向右移动（索引值+1）
-     */
-    void shiftToRight();
-    
     /**
      * 构造函数
      * 初始化所有成员变量
@@ -60,38 +126,99 @@ public:
     
     /**
      * 从单一扫描仪添加新的芦笋数据（插入到索引0）
-     * @param diameter 直径值
+     * @param diameterDeciMm 直径值 (0.1mm)
      * @param scanCount 扫描次数
      * @param lengthLevel 长度等级 (1:S, 2:M, 3:L)
+     * @param confidence 直径融合置信度 (0-100)
+     * @param flags TrayFlag 位组合
      */
-    void pushNewAsparagus(int diameter, int scanCount, int lengthLevel = 0);
+    void pushNewAsparagus(int diameterDeciMm, int scanCount, int lengthLevel = 0, uint8_t confidence = 100,
+                          uint8_t flags = 0);
     
+    /**
+     * 由扫描结果构造紧凑托盘记录（各字段按位宽饱和）
+     */
+    static TrayRecord makeRecord(int diameterDeciMm, int scanCount, int lengthLevel, uint8_t confidence,
+                                 uint8_t flags);
+
+    /**
+     * 在索引0处推入一个完整的托盘记录（含出口判定）
+     */
+    void pushTray(const TrayRecord& record);
+
+    /**
+     * 改写已在队列中的托盘的目标出口（供配额等上层策略使用）
+     * @param index 托盘索引
+     * @param outlet 目标出口，TRAY_NO_OUTLET 表示不分流
+     * @return 该位置无有效托盘时返回 false
+     */
+    bool setTrayOutlet(int index, uint8_t outlet);
+
     /**
      * 重置所有直径数据
      */
     void resetAllTraysData();
     
     /**
-     * 获取托盘直径数据
+     * 获取所有托盘位置的一致性快照（无锁，可在任意任务中调用）
+     * @param out 输出快照
+     */
+    void getSnapshot(TraySnapshot& out) const;
+
+    /**
+     * 获取单个托盘记录（无锁），无效位置返回空记录
+     * @param index 托盘索引
+     */
+    TrayRecord getTray(int index) const;
+
+    /**
+     * 获取托盘直径数据（四舍五入到 mm，供显示使用）
+     * @param index 托盘索引
+     * @return 直径值 (mm)，无效返回0
+     */
+    int getTrayDiameter(int index) const;
+
+    /**
+     * 获取托盘直径数据（完整精度，供分拣判定使用）
      * @param index 托盘索引
-     * @return 直径值，无效返回0
+     * @return 直径值 (0.1mm)，无效返回0
      */
-    int getTrayDiameter(int index);
+    int getTrayDiameterDeciMm(int index) const;
     
     /**
      * 获取托盘扫描次数
      * @param index 托盘索引
      * @return 扫描次数
      */
-    int getTrayScanCount(int index);
+    int getTrayScanCount(int index) const;
 
     /**
      * 获取托盘长度等级
      * @param index 托盘索引
      * @return 长度等级 (1:S, 2:M, 3:L)，无效返回0
      */
-    int getTrayLengthLevel(int index);
+    int getTrayLengthLevel(int index) const;
+
+    /**
+     * 获取托盘直径置信度
+     * @param index 托盘索引
+     * @return 置信度 (0-100)，无效返回0
+     */
+    uint8_t getTrayConfidence(int index) const;
+
+    /**
+     * 获取托盘目标出口
+     * @param index 托盘索引
+     * @return 出口编号，不分流或无效返回 TRAY_NO_OUTLET
+     */
+    uint8_t getTrayOutlet(int index) const;
     
+    /**
+     * 获取托盘序号（自启动以来第几个托盘），用于跨位置跟踪同一托盘
+     * @param index 托盘索引
+     */
+    uint32_t getTraySequence(int index) const;
+
     /**
      * 获取托盘队列容量
      * @return 托盘队列容量
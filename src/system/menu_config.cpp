@@ -4,6 +4,7 @@
 #include "../handlers/hmi_diagnostic_handler.h"
 #include "../handlers/config_handler.h"
 #include "../handlers/scanner_diagnostic_handler.h"
+#include "../modular/sorter.h"
 
 extern PhaseOffsetConfigHandler phaseOffsetConfigHandler;
 
@@ -24,6 +25,7 @@ MenuNode hardwareOutletMenu("Divert Outlet", &hardwareDiagMenu);
 extern ScannerDiagnosticHandler scannerDiagnosticHandler;
 extern OutletDiagnosticHandler outletDiagnosticHandler;
 extern HMIDiagnosticHandler hmiDiagnosticHandler;
+extern Sorter sorter;
 
 void setupMenuTree() {
     menuSystem.setSensitivity(1); 
@@ -47,6 +49,12 @@ void setupMenuTree() {
         switchToMode(MODE_DIAGNOSE_HMI);
     }));
     hardwareDiagMenu.addItem(MenuItem("Divert Outlet >", MENU_TYPE_SUBMENU, &hardwareOutletMenu));
+    hardwareDiagMenu.addItem(MenuItem("CPU Profiler", MENU_TYPE_ACTION, nullptr, [](){
+        switchToMode(MODE_DIAGNOSE_PROFILER);
+    }));
+    hardwareDiagMenu.addItem(MenuItem("Dump Trace", MENU_TYPE_ACTION, nullptr, [](){
+        sorter.dumpTrace(); // 事件追踪以十六进制输出到串口，供主机端回放
+    }));
     hardwareDiagMenu.addItem(MenuItem("< Back", MENU_TYPE_BACK));
 
     // 2.1 扫描仪诊断
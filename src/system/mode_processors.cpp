@@ -40,10 +40,11 @@ void processNormalMode() {
     int identifiedCount = traySystem->getTotalIdentifiedItems();
     int transportedTrayCount = traySystem->getTransportedTrayCount();
     
-    // 获取最新一根物料的详细数据
-    int latestDiameter = traySystem->getTrayDiameter(0);
-    int latestScanCount = traySystem->getTrayScanCount(0);
-    int latestLengthLevel = traySystem->getTrayLengthLevel(0);
+    // 获取最新一根物料的详细数据（一次无锁读取，三项数据来自同一托盘）
+    TrayRecord latestTray = traySystem->getTray(0);
+    int latestDiameter = (latestTray.diameterDeciMm + 5) / 10;
+    int latestScanCount = latestTray.scanCount;
+    int latestLengthLevel = latestTray.lengthLevel;
     
     // 调用功能增强版的仪表盘，设置 forceRefresh 为 true，由 UITask 控制刷新节奏
     UserInterface::getInstance()->displayDashboard(
@@ -69,6 +70,7 @@ String getSystemModeName(SystemMode mode) {
         case MODE_CONFIG_DIAMETER: return "Config Diameter";
         case MODE_DIAGNOSE_HMI: return "HMI Encoder Diag";
         case MODE_CONFIG_PHASE_OFFSET: return "Config Phase Offset";
+        case MODE_DIAGNOSE_PROFILER: return "CPU Profiler";
         default: return "Unknown Mode";
     }
 }
@@ -7,6 +7,7 @@
 #include "handlers/encoder_diagnostic_handler.h"
 #include "handlers/config_handler.h"
 #include "handlers/hmi_diagnostic_handler.h"
+#include "handlers/profiler_diagnostic_handler.h"
 #include "handlers/base_diagnostic_handler.h"
 #include <EEPROM.h>
 
@@ -28,6 +29,7 @@ extern ScannerDiagnosticHandler scannerDiagnosticHandler;
 extern OutletDiagnosticHandler outletDiagnosticHandler;
 extern EncoderDiagnosticHandler encoderDiagnosticHandler;
 extern HMIDiagnosticHandler hmiDiagnosticHandler;
+extern ProfilerDiagnosticHandler profilerDiagnosticHandler;
 
 void switchToMode(SystemMode mode) {
     pendingMode = mode;
@@ -81,6 +83,9 @@ void handleModeChange() {
         case MODE_DIAGNOSE_HMI:
             activeHandler = &hmiDiagnosticHandler;
             break;
+        case MODE_DIAGNOSE_PROFILER:
+            activeHandler = &profilerDiagnosticHandler;
+            break;
         case MODE_CONFIG_DIAMETER:
             activeHandler = &diameterConfigHandler;
             break;
@@ -1,4 +1,5 @@
 #include "menu_system.h"
+#include "../modular/deferred_log.h"
 
 MenuSystem::MenuSystem(int visibleItems) {
     maxVisibleItems = visibleItems;
@@ -56,8 +57,8 @@ void MenuSystem::handleInput(int encoderDelta, bool btnPressed) {
             if (cursorIndex > maxIndex) cursorIndex = maxIndex;
             
             // 调试输出：观察菜单项目是如何跳转的
-            Serial.printf("[MENU] Delta: %d, Acc: %d, Steps: %d, New Index: %d/%d\n", 
-                          encoderDelta, deltaAccumulator, steps, cursorIndex, maxIndex);
+            LOG_DEBUG("[MENU] Delta: %d, Acc: %d, Steps: %d, New Index: %d/%d\n",
+                      encoderDelta, deltaAccumulator, steps, cursorIndex, maxIndex);
             
             updateScroll();
         }
@@ -1,5 +1,6 @@
 // 精简版人机交互模块实现
 #include "simple_hmi.h"
+#include "../modular/deferred_log.h"
 
 // 静态实例初始化
 SimpleHMI* SimpleHMI::instance = nullptr;
@@ -140,7 +141,7 @@ int SimpleHMI::getEncoderDelta() {
     }
     
     if (delta != 0) {
-        Serial.printf("[HMI_ENC] Logical Delta: %d, RawDiff: %d\n", delta, rawDiff);
+        LOG_DEBUG("[HMI_ENC] Logical Delta: %d, RawDiff: %d\n", delta, rawDiff);
     }
     
     return delta;
@@ -0,0 +1,224 @@
+// 线圈起动调度：以伪时钟驱动 "dispatch -> nextDelay -> 定时器到期" 循环，检查错峰间隔、并发上限、
+// 截止时刻最早优先与强制起动；再检查由触发相位与速度推算的截止时刻，
+// 最后在 NativeHal 虚拟时间中检查 Sorter 的手动操作与传送带仿真中的实际并发与强制起动次数
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "modular/actuation_scheduler.h"
+#include "modular/actuation_timing.h"
+#include "host/conveyor_sim.h"
+
+Sorter sorter;
+
+namespace {
+
+const int CHANNELS = 8;
+const int MAX_CONCURRENT = 4;
+const uint32_t STAGGER_US = 1500;
+const uint32_t OPEN_US = 100000;
+const uint32_t CLOSE_US = 300000;
+const uint32_t TIMER_JITTER_US = 100;
+
+struct Started {
+    int ch;
+    uint32_t atUs;
+};
+
+// 伪时钟：每次直接跳到 nextDelay() 给出的时刻并 dispatch，直到没有待起动请求
+std::vector<Started> runDispatchLoop(ActuationScheduler<CHANNELS>& scheduler, uint32_t nowUs) {
+    std::vector<Started> started;
+    while (true) {
+        uint32_t mask = scheduler.dispatch(nowUs);
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if (mask & (1u << ch)) {
+                Started s = {ch, nowUs};
+                started.push_back(s);
+            }
+        }
+        uint32_t delay = 0;
+        if (!scheduler.nextDelay(nowUs, delay)) break;
+        nowUs += delay;
+    }
+    return started;
+}
+
+// 帧记录：每个出口打开线圈位的上升时刻与同时通电的线圈数峰值
+struct CoilStarts {
+    uint64_t onUs[NUM_OUTLETS];
+    int maxConcurrent;
+};
+CoilStarts coilStarts;
+
+void recordCoilFrame(void* context, const uint8_t* bytes, int length) {
+    int active = 0;
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        const OutletWiring& w = BOARD_OUTLET_WIRING_TABLE[i];
+        bool open = (bytes[w.coilByte] >> w.openBit) & 1;
+        bool close = (bytes[w.coilByte] >> w.closeBit) & 1;
+        if (open || close) active++;
+        if (open && coilStarts.onUs[i] == 0) coilStarts.onUs[i] = NativeHal::nowUs();
+    }
+    if (active > coilStarts.maxConcurrent) coilStarts.maxConcurrent = active;
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::setSerialEcho(false);
+}
+
+void tearDown() {}
+
+void test_starts_are_staggered_and_capped_when_deadlines_allow() {
+    // 6 个打开请求，截止时刻留足一个脉宽：前 4 个错峰起动，其余等第一个线圈断电
+    ActuationScheduler<CHANNELS> scheduler(MAX_CONCURRENT, STAGGER_US);
+    uint32_t now = 1000;
+    for (int ch = 0; ch < 6; ch++) scheduler.request(ch, OPEN_US, now + 2 * OPEN_US);
+
+    std::vector<Started> started = runDispatchLoop(scheduler, now);
+    TEST_ASSERT_EQUAL_INT(6, (int)started.size());
+    for (int k = 0; k < MAX_CONCURRENT; k++) {
+        TEST_ASSERT_EQUAL_UINT32(now + k * STAGGER_US, started[k].atUs);
+    }
+    TEST_ASSERT_EQUAL_UINT32(now + OPEN_US, started[4].atUs);
+    TEST_ASSERT_EQUAL_UINT32(now + OPEN_US + STAGGER_US, started[5].atUs);
+    TEST_ASSERT_EQUAL_INT(MAX_CONCURRENT, scheduler.getPeakConcurrent());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getForcedCount());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getMissCount());
+}
+
+void test_earliest_deadline_starts_first() {
+    ActuationScheduler<CHANNELS> scheduler(MAX_CONCURRENT, STAGGER_US);
+    uint32_t now = 0;
+    scheduler.request(0, CLOSE_US, now + 90000);
+    scheduler.request(1, OPEN_US, now + 20000);
+    scheduler.request(2, OPEN_US, now + 50000);
+
+    std::vector<Started> started = runDispatchLoop(scheduler, now);
+    TEST_ASSERT_EQUAL_INT(3, (int)started.size());
+    TEST_ASSERT_EQUAL_INT(1, started[0].ch);
+    TEST_ASSERT_EQUAL_INT(2, started[1].ch);
+    TEST_ASSERT_EQUAL_INT(0, started[2].ch);
+}
+
+void test_short_budget_forces_starts_beyond_the_cap() {
+    // 截止时刻只留 10ms 预算：100-300ms 的脉冲在预算内不会断电，第 5、6 个请求只能强制起动，
+    // 但仍按错峰间隔逐个起动，且都不晚于截止时刻
+    ActuationScheduler<CHANNELS> scheduler(MAX_CONCURRENT, STAGGER_US);
+    uint32_t now = 5000;
+    uint32_t deadline = now + 10000;
+    for (int ch = 0; ch < 6; ch++) scheduler.request(ch, OPEN_US, deadline);
+
+    std::vector<Started> started = runDispatchLoop(scheduler, now);
+    TEST_ASSERT_EQUAL_INT(6, (int)started.size());
+    for (size_t k = 1; k < started.size(); k++) {
+        TEST_ASSERT_TRUE(started[k].atUs - started[k - 1].atUs >= STAGGER_US);
+    }
+    TEST_ASSERT_TRUE((int32_t)(started[5].atUs - deadline) <= 0);
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler.getForcedCount());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getMissCount());
+    TEST_ASSERT_EQUAL_INT(6, scheduler.getPeakConcurrent());
+}
+
+void test_deadlines_across_clock_wrap() {
+    ActuationScheduler<CHANNELS> scheduler(1, STAGGER_US);
+    uint32_t now = 0xFFFFFFFFu - 20000;
+    scheduler.request(3, OPEN_US, now + 2 * OPEN_US);   // 截止时刻回绕到 0 之后
+    scheduler.request(4, OPEN_US, now + 3 * OPEN_US);
+
+    std::vector<Started> started = runDispatchLoop(scheduler, now);
+    TEST_ASSERT_EQUAL_INT(2, (int)started.size());
+    TEST_ASSERT_EQUAL_INT(3, started[0].ch);
+    TEST_ASSERT_EQUAL_UINT32(now, started[0].atUs);
+    TEST_ASSERT_EQUAL_INT(4, started[1].ch);
+    TEST_ASSERT_EQUAL_UINT32(now + OPEN_US, started[1].atUs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getForcedCount());
+}
+
+void test_deadline_from_divergence_phase_and_speed() {
+    // 1 托盘/秒、200 相位/托盘：每相位 5ms
+    const int RANGE = 200;
+    // 打开：提前 22 相位（100ms 行程 + 10ms 预算）触发，余量为 10ms
+    TEST_ASSERT_EQUAL_UINT32(1000 + 10000, actuationDeadlineUs(1000, 8, 30, RANGE, 1.0f, 100, 0));
+    // 关闭：复位相位 150，到下一托盘到达分流点 30 共 80 相位 = 400ms，减 300ms 行程
+    TEST_ASSERT_EQUAL_UINT32(1000 + 100000, actuationDeadlineUs(1000, 150, 30, RANGE, 1.0f, 300, 0));
+    // 提前量被锁存窗口截断：余量为负，到达即须起动
+    TEST_ASSERT_EQUAL_UINT32(1000, actuationDeadlineUs(1000, 171, 30, RANGE, 3.0f, 300, 0));
+    // 静止：没有托盘到达时刻
+    TEST_ASSERT_EQUAL_UINT32(1000 + 600000, actuationDeadlineUs(1000, 150, 30, RANGE, 0.0f, 300, 600000));
+    // 事件时刻接近 2^32
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFF0u + 10000, actuationDeadlineUs(0xFFFFFFF0u, 8, 30, RANGE, 1.0f, 100, 0));
+}
+
+void test_sorter_manual_actuation_respects_cap() {
+    // 传送带静止时同时打开 6 个出口：截止时刻按静止余量推算，超出上限的出口等第一批脉冲结束再起动
+    NativeHal::reset();
+    EEPROM.begin(512);
+    sorter.initialize();
+    memset(&coilStarts, 0, sizeof(coilStarts));
+    NativeHal::advanceUs(1000);
+    uint32_t forcedBefore = sorter.getForcedActuationCount();
+    NativeHal::setFrameListener(recordCoilFrame, nullptr);
+
+    const int OPENED = 6;
+    for (int i = 0; i < OPENED; i++) sorter.setOutletState(i, true);
+    NativeHal::advanceUs(3 * PULSE_OPEN_MS * 1000u);
+    NativeHal::setFrameListener(nullptr, nullptr);
+
+    for (int i = 0; i < OPENED; i++) TEST_ASSERT_TRUE(sorter.getOutlet(i)->isPositionOpen());
+    TEST_ASSERT_LESS_OR_EQUAL(OUTLET_MAX_CONCURRENT_COILS, coilStarts.maxConcurrent);
+    TEST_ASSERT_EQUAL_UINT32(PULSE_OPEN_MS * 1000u,
+                             (uint32_t)(coilStarts.onUs[OUTLET_MAX_CONCURRENT_COILS] - coilStarts.onUs[0]));
+    TEST_ASSERT_EQUAL_UINT32(forcedBefore, sorter.getForcedActuationCount());
+}
+
+void test_sorter_conveyor_actuations_meet_deadlines() {
+    // 传送带仿真 1-2 托盘/秒：所有脉冲在推算的截止时刻前起动，报告并发峰值与强制起动次数
+    NativeHal::reset();
+    ProductStream stream;
+    stream.generate(7, 1000, 15, 5);
+
+    SimConfig config;
+    config.startTps = 1.0f;
+    config.stepTps = 0.5f;
+    config.maxTps = 2.0f;
+    config.traysPerStep = 200;
+    config.stopAtFirstFailure = false;
+
+    uint32_t forcedBefore = sorter.getForcedActuationCount();
+    uint32_t startedBefore = sorter.getActuationDispatchCount();
+    ConveyorSimulator simulator(&sorter, &stream, config);
+    const std::vector<SimStepResult>& results = simulator.runSweep();
+    TEST_ASSERT_EQUAL_INT(3, (int)results.size());
+
+    char message[160];
+    snprintf(message, sizeof(message), "conveyor: %u pulses, peak %d/%d coils, forced %u, min slack %dus",
+             sorter.getActuationDispatchCount() - startedBefore, sorter.getPeakConcurrentCoils(),
+             OUTLET_MAX_CONCURRENT_COILS, sorter.getForcedActuationCount() - forcedBefore,
+             (int)sorter.getMinActuationSlackUs());
+    TEST_MESSAGE(message);
+    // 强制起动发生在定时器回调中，回调本身的延迟（数 us）会使起动略晚于截止时刻
+    TEST_ASSERT_TRUE(sorter.getMinActuationSlackUs() > -(int32_t)TIMER_JITTER_US);
+    for (size_t i = 0; i < results.size(); i++) {
+        TEST_ASSERT_EQUAL_INT(0, results[i].lateOutlets);
+        TEST_ASSERT_EQUAL_INT(0, results[i].wrongDrops);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_starts_are_staggered_and_capped_when_deadlines_allow);
+    RUN_TEST(test_earliest_deadline_starts_first);
+    RUN_TEST(test_short_budget_forces_starts_beyond_the_cap);
+    RUN_TEST(test_deadlines_across_clock_wrap);
+    RUN_TEST(test_deadline_from_divergence_phase_and_speed);
+    RUN_TEST(test_sorter_manual_actuation_respects_cap);
+    RUN_TEST(test_sorter_conveyor_actuations_meet_deadlines);
+    return UNITY_END();
+}
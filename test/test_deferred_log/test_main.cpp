@@ -0,0 +1,143 @@
+// 延迟日志：DeferredLog 写入 / drain() 经 NativeHal 串口记录输出的内容与顺序，缓冲满时丢弃计数与 drain() 的丢弃报告，
+// 槽位序号在写满 CAPACITY 条之后的多圈回绕，以及按 DEFERRED_LOG_LEVEL 在编译期过滤（含参数求值）
+
+#include <Arduino.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include "modular/deferred_log.h"
+
+namespace {
+
+const int CAPACITY = (int)DeferredLog::CAPACITY;
+
+std::string captured;
+
+void recordSerial(void* context, const char* text, size_t length) {
+    captured.append(text, length);
+}
+
+std::string drainText(int expectedPrinted) {
+    captured.clear();
+    TEST_ASSERT_EQUAL_INT(expectedPrinted, DeferredLog::drain());
+    return captured;
+}
+
+// 按写入顺序拼出 "[T] n\n" 期望输出
+std::string numberedLines(int first, int count) {
+    std::string text;
+    char line[32];
+    for (int n = first; n < first + count; n++) {
+        snprintf(line, sizeof(line), "[T] %d\n", n);
+        text += line;
+    }
+    return text;
+}
+
+int evaluated = 0;
+
+int countEvaluation(int value) {
+    evaluated++;
+    return value;
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::setSerialEcho(false);
+    NativeHal::setSerialListener(recordSerial, nullptr);
+    DeferredLog::reset();
+    captured.clear();
+}
+
+void tearDown() {
+    NativeHal::setSerialListener(nullptr, nullptr);
+}
+
+void test_formats_integer_arguments_in_order() {
+    DeferredLog::write("[T] %d %u %x %c\n", -12, 40000u, 0xBEEF, 'Z');
+    DeferredLog::write("[T] no args\n");
+    DeferredLog::write("[T] %d %d %d %d %d %d\n", 1, 2, 3, 4, 5, 6);
+    TEST_ASSERT_EQUAL_STRING("[T] -12 40000 beef Z\n[T] no args\n[T] 1 2 3 4 5 6\n", drainText(3).c_str());
+    // 已输出的记录不再重复
+    TEST_ASSERT_EQUAL_STRING("", drainText(0).c_str());
+}
+
+void test_drops_when_full_and_reports_in_drain() {
+    const int EXTRA = 5;
+    for (int n = 0; n < CAPACITY + EXTRA; n++) DeferredLog::write("[T] %d\n", n);
+    TEST_ASSERT_EQUAL_UINT32(EXTRA, DeferredLog::getDroppedCount());
+
+    // 缓冲中保留最早的 CAPACITY 条，之后报告丢弃数
+    char report[64];
+    snprintf(report, sizeof(report), "[LOG] %d messages dropped (total %d)\n", EXTRA, EXTRA);
+    TEST_ASSERT_EQUAL_STRING((numberedLines(0, CAPACITY) + report).c_str(), drainText(CAPACITY).c_str());
+
+    // 没有新的丢弃时不再报告
+    DeferredLog::write("[T] %d\n", 1000);
+    TEST_ASSERT_EQUAL_STRING("[T] 1000\n", drainText(1).c_str());
+
+    // 再次丢弃时只报告新增部分，累计值继续增加
+    for (int n = 0; n < CAPACITY + 2; n++) DeferredLog::write("[T] %d\n", n);
+    TEST_ASSERT_EQUAL_UINT32(EXTRA + 2, DeferredLog::getDroppedCount());
+    snprintf(report, sizeof(report), "[LOG] %d messages dropped (total %d)\n", 2, EXTRA + 2);
+    TEST_ASSERT_EQUAL_STRING((numberedLines(0, CAPACITY) + report).c_str(), drainText(CAPACITY).c_str());
+}
+
+void test_freed_slots_are_reused_after_drain() {
+    // 缓冲写满即丢弃；drain 之后槽位归还，可以再写满一整圈
+    for (int n = 0; n < CAPACITY; n++) DeferredLog::write("[T] %d\n", n);
+    DeferredLog::write("[T] %d\n", -1);
+    TEST_ASSERT_EQUAL_UINT32(1, DeferredLog::getDroppedCount());
+    drainText(CAPACITY);
+
+    for (int n = 0; n < CAPACITY; n++) DeferredLog::write("[T] %d\n", n);
+    TEST_ASSERT_EQUAL_UINT32(1, DeferredLog::getDroppedCount());
+    TEST_ASSERT_EQUAL_STRING(numberedLines(0, CAPACITY).c_str(), drainText(CAPACITY).c_str());
+}
+
+void test_slot_sequence_wraps_over_many_laps() {
+    // 每轮写入的条数与 CAPACITY 互质，写位置相对槽位不断错开，共绕 CAPACITY 的多圈
+    const int PER_ROUND = CAPACITY / 2 + 3;
+    const int ROUNDS = 4 * CAPACITY / PER_ROUND + 5;
+    int next = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int n = 0; n < PER_ROUND; n++) DeferredLog::write("[T] %d\n", next + n);
+        TEST_ASSERT_EQUAL_STRING(numberedLines(next, PER_ROUND).c_str(), drainText(PER_ROUND).c_str());
+        next += PER_ROUND;
+    }
+    TEST_ASSERT_TRUE(next > 4 * CAPACITY);
+    TEST_ASSERT_EQUAL_UINT32(0, DeferredLog::getDroppedCount());
+}
+
+void test_level_filter_is_compile_time() {
+    evaluated = 0;
+    LOG_ERROR("[T] error %d\n", countEvaluation(1));
+    LOG_WARN("[T] warn %d\n", countEvaluation(2));
+    LOG_INFO("[T] info %d\n", countEvaluation(3));
+    LOG_DEBUG("[T] debug %d\n", countEvaluation(4));
+
+    std::string expected;
+    int kept = 0;
+    if (LOG_LEVEL_ERROR <= DEFERRED_LOG_LEVEL) { expected += "[T] error 1\n"; kept++; }
+    if (LOG_LEVEL_WARN <= DEFERRED_LOG_LEVEL)  { expected += "[T] warn 2\n"; kept++; }
+    if (LOG_LEVEL_INFO <= DEFERRED_LOG_LEVEL)  { expected += "[T] info 3\n"; kept++; }
+    if (LOG_LEVEL_DEBUG <= DEFERRED_LOG_LEVEL) { expected += "[T] debug 4\n"; kept++; }
+
+    // 被过滤的调用连参数都不求值，也不占用槽位
+    TEST_ASSERT_EQUAL_INT(kept, evaluated);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), drainText(kept).c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, DeferredLog::getDroppedCount());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_formats_integer_arguments_in_order);
+    RUN_TEST(test_drops_when_full_and_reports_in_drain);
+    RUN_TEST(test_freed_slots_are_reused_after_drain);
+    RUN_TEST(test_slot_sequence_wraps_over_many_laps);
+    RUN_TEST(test_level_filter_is_compile_time);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+// 多通道直径融合：固定的通道直径向量与期望的融合直径、置信度、参与通道
+// 参数与 DiameterScanner::decodeFrame() 相同：最小直径 SCANNER_MIN_DIAMETER_UNIT * 10，容差 SCANNER_FUSION_TOLERANCE_DECI_MM
+
+#include <unity.h>
+#include <stdint.h>
+#include "config.h"
+#include "modular/diameter_fusion.h"
+
+namespace {
+
+const int MIN_DECI_MM = SCANNER_MIN_DIAMETER_UNIT * 10;
+const int TOLERANCE = SCANNER_FUSION_TOLERANCE_DECI_MM;
+
+FusionResult fuse(int ch0, int ch1, int ch2, int ch3) {
+    int channels[4] = {ch0, ch1, ch2, ch3};
+    return fuseChannelDiameters(channels, 4, MIN_DECI_MM, TOLERANCE);
+}
+
+void checkFusion(const FusionResult& r, int diameterDeciMm, int confidence, uint8_t channelMask) {
+    TEST_ASSERT_EQUAL_INT(diameterDeciMm, r.diameterDeciMm);
+    TEST_ASSERT_EQUAL_INT(confidence, r.confidence);
+    TEST_ASSERT_EQUAL_HEX8(channelMask, r.channelMask);
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_configuration_matches_expected_values() {
+    // 下列期望值按 2.5mm 最小直径与 1.5mm 容差推算
+    TEST_ASSERT_EQUAL_INT(50, MIN_DECI_MM);
+    TEST_ASSERT_EQUAL_INT(15, TOLERANCE);
+}
+
+void test_all_channels_agree() {
+    checkFusion(fuse(200, 200, 200, 200), 200, 100, 0x0F);
+}
+
+void test_outlier_is_rejected() {
+    // 中位数 (200 + 202 + 1) / 2 = 201，通道 3 偏差 59 被剔除；
+    // 置信度 3/4 * 100 = 75，离散度 4 扣 4 * 50 / 15 = 13
+    checkFusion(fuse(200, 202, 198, 260), 200, 62, 0x07);
+}
+
+void test_median_reference_not_mean() {
+    // 平均值为 110，若以平均值为参考所有通道都在容差外；以中位数 100 为参考只剔除 140
+    checkFusion(fuse(100, 140, 100, 100), 100, 75, 0x0D);
+}
+
+void test_trimmed_mean_and_dispersion_penalty() {
+    // 全部在容差内：平均 795 / 4 取整为 199；离散度 15 等于容差，扣 50
+    checkFusion(fuse(190, 200, 205, 200), 199, 50, 0x0F);
+    // 两通道：中位数与平均值均按四舍五入
+    checkFusion(fuse(201, 0, 202, 0), 202, 97, 0x05);
+}
+
+void test_single_channel() {
+    // 只有一个通道被遮挡（短物体或其余通道低于最小直径），无法交叉验证
+    checkFusion(fuse(0, 0, 180, 30), 180, FUSION_SINGLE_CHANNEL_CONFIDENCE, 0x04);
+    // 恰为最小直径的通道有效
+    checkFusion(fuse(MIN_DECI_MM, 0, 0, 0), MIN_DECI_MM, FUSION_SINGLE_CHANNEL_CONFIDENCE, 0x01);
+}
+
+void test_no_covered_channel() {
+    checkFusion(fuse(0, 30, MIN_DECI_MM - 1, 0), 0, 0, 0x00);
+}
+
+void test_total_disagreement_is_below_min_confidence() {
+    // 两通道相差 10mm：都偏离中位数 150 超过容差，输出中位数、置信度 0
+    FusionResult two = fuse(100, 0, 0, 200);
+    checkFusion(two, 150, 0, 0x00);
+    TEST_ASSERT_TRUE(two.confidence < SCANNER_MIN_CONFIDENCE);
+
+    // 四通道均匀分散：中位数 (120 + 160 + 1) / 2 = 140，全部偏差 >= 20
+    FusionResult four = fuse(80, 120, 160, 200);
+    checkFusion(four, 140, 0, 0x00);
+    TEST_ASSERT_TRUE(four.confidence < SCANNER_MIN_CONFIDENCE);
+
+    // 两两成对：都恰在容差边界上保留，但离散度为容差的 2 倍，置信度扣到 0
+    FusionResult pairs = fuse(100, 130, 100, 130);
+    checkFusion(pairs, 115, 0, 0x0F);
+    TEST_ASSERT_TRUE(pairs.confidence < SCANNER_MIN_CONFIDENCE);
+}
+
+void test_channel_count_is_clamped() {
+    int channels[5] = {150, 150, 150, 150, 900};
+    FusionResult r = fuseChannelDiameters(channels, 5, MIN_DECI_MM, TOLERANCE);
+    checkFusion(r, 150, 100, 0x0F);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_configuration_matches_expected_values);
+    RUN_TEST(test_all_channels_agree);
+    RUN_TEST(test_outlier_is_rejected);
+    RUN_TEST(test_median_reference_not_mean);
+    RUN_TEST(test_trimmed_mean_and_dispersion_penalty);
+    RUN_TEST(test_single_channel);
+    RUN_TEST(test_no_covered_channel);
+    RUN_TEST(test_total_disagreement_is_below_min_confidence);
+    RUN_TEST(test_channel_count_is_clamped);
+    return UNITY_END();
+}
@@ -0,0 +1,73 @@
+// 翻板开/关行程分开规划后的正确分流率：在传送带仿真中以 1x..3x 带速（1x = 1 托盘/秒）各运行 200 个托盘
+// 关闭行程 + 最短落料窗口放得进一个托盘周期的速度下必须 100% 正确分流；更高速度只报告比例
+
+#include <Arduino.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdio.h>
+#include "host/conveyor_sim.h"
+
+Sorter sorter;
+
+namespace {
+
+const float BASE_TPS = 1.0f;
+const int TRAYS_PER_SPEED = 200;
+
+// 复位相位须在分流点前留出关闭行程（含执行预算），且不早于最短落料窗口
+bool closeFitsInCycle(float tps, float tolerancePhases) {
+    float closeLeadPhases = (OUTLET_CLOSE_LATENCY_MS + OUTLET_ACTUATION_BUDGET_MS) * tps * ENCODER_MAX_PHASE / 1000.0f;
+    return OUTLET_MIN_DROP_PHASES + closeLeadPhases <= ENCODER_MAX_PHASE + tolerancePhases;
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+}
+
+void tearDown() {}
+
+void test_correct_drop_rate_from_1x_to_3x_belt_speed() {
+    ProductStream stream;
+    stream.generate(1, 1000, 15, 5);
+
+    SimConfig config;
+    config.startTps = BASE_TPS;
+    config.stepTps = 0.5f * BASE_TPS;
+    config.maxTps = 3.0f * BASE_TPS;
+    config.traysPerStep = TRAYS_PER_SPEED;
+    config.stopAtFirstFailure = false;
+
+    ConveyorSimulator simulator(&sorter, &stream, config);
+    const std::vector<SimStepResult>& results = simulator.runSweep();
+    TEST_ASSERT_EQUAL_INT(5, (int)results.size());
+
+    int feasibleSpeeds = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const SimStepResult& r = results[i];
+        bool feasible = closeFitsInCycle(r.tps, config.lateTolerancePhases);
+        char message[160];
+        snprintf(message, sizeof(message), "%.1fx (%.2f trays/s): %d/%d correct drops (%.1f%%), late %d, wrong %d%s",
+                 r.tps / BASE_TPS, r.tps, r.correctDrops, r.sortedTrays, r.correctDropRate() * 100.0f,
+                 r.lateOutlets, r.wrongDrops, feasible ? "" : "  [close stroke exceeds cycle]");
+        TEST_MESSAGE(message);
+
+        TEST_ASSERT_GREATER_THAN(TRAYS_PER_SPEED / 2, r.sortedTrays);
+        TEST_ASSERT_EQUAL_INT(0, r.misLatched);
+        if (feasible) {
+            feasibleSpeeds++;
+            TEST_ASSERT_EQUAL_INT(r.sortedTrays, r.correctDrops);
+            TEST_ASSERT_EQUAL_INT(0, r.wrongDrops);
+            TEST_ASSERT_EQUAL_INT(0, r.lateOutlets);
+        }
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(3, feasibleSpeeds);   // 1x、1.5x、2x
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_correct_drop_rate_from_1x_to_3x_belt_speed);
+    return UNITY_END();
+}
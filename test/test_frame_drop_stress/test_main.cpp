@@ -0,0 +1,199 @@
+// 扫描乒乓缓冲压力测试：解码被故意推迟时，丢掉的窗口必须被标记（decodeFrame 返回 false / TRAY_FLAG_FRAME_DROPPED），
+// 已采集窗口的解码结果必须与该窗口的输入完全一致，不能混入相邻窗口的数据
+
+#include <Arduino.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdio.h>
+#include <vector>
+#include "modular/diameter_scanner.h"
+#include "host/conveyor_sim.h"
+
+Sorter sorter;
+
+namespace {
+
+const int SCANNER_PINS[4] = {PIN_SCANNER_1, PIN_SCANNER_2, PIN_SCANNER_3, PIN_SCANNER_4};
+const int WINDOW_SAMPLES = PHASE_DATA_LATCH - PHASE_SCAN_START;
+const int TRAYS = 2000;
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// 托盘 k 在通道 ch 上的遮挡宽度（采样点数），各托盘互不相同，可由解码结果反推托盘号
+int widthFor(long tray, int ch) {
+    return 5 + (int)((tray * 7 + ch * 3) % 61);
+}
+
+// ISR 侧：扫描起始、逐相位采样（各通道在窗口第 4 个采样点起遮挡 widthFor 个采样点）、数据锁存
+void captureWindow(DiameterScanner* scanner, long tray) {
+    scanner->start();
+    for (int s = 0; s < WINDOW_SAMPLES; s++) {
+        for (int ch = 0; ch < 4; ch++) {
+            bool blocked = (s >= 4 && s < 4 + widthFor(tray, ch));
+            NativeHal::setPinLevel(SCANNER_PINS[ch], blocked ? HIGH : LOW);
+        }
+        scanner->sample(PHASE_SCAN_START + s);
+    }
+    scanner->latch();
+}
+
+struct DecodeStats {
+    int decoded;
+    int dropped;
+    int corrupted;
+};
+
+// 任务侧：与 Sorter::run() 相同，按锁存顺序解码所有已移交的帧
+void decodePending(DiameterScanner* scanner, uint32_t& decodedSequence, uint32_t baseSequence, DecodeStats& stats) {
+    uint32_t latched = scanner->getLatchCount();
+    while (decodedSequence != latched) {
+        long tray = (long)(decodedSequence - baseSequence);
+        if (scanner->decodeFrame(decodedSequence)) {
+            stats.decoded++;
+            for (int ch = 0; ch < 4; ch++) {
+                if (scanner->getHighLevelPulseCount(ch) != widthFor(tray, ch) || scanner->getObjectCount(ch) != 1) {
+                    stats.corrupted++;
+                    break;
+                }
+            }
+        } else {
+            stats.dropped++;
+            if (scanner->getDiameterDeciMm() != 0 || scanner->getTotalObjectCount() != 0) stats.corrupted++;
+        }
+        decodedSequence++;
+    }
+}
+
+void runStress(ScanCaptureMode mode, uint32_t seed, int maxLagWindows, DecodeStats& stats) {
+    DiameterScanner* scanner = DiameterScanner::getInstance();
+    scanner->setCaptureMode(mode);
+    uint32_t baseSequence = scanner->getLatchCount();
+    uint32_t baseDropped = scanner->getDroppedFrameCount();
+    uint32_t decodedSequence = baseSequence;
+    stats.decoded = stats.dropped = stats.corrupted = 0;
+
+    // 解码任务在每个窗口之后以随机次数推迟（0 = 及时解码）
+    int lag = 0;
+    for (long tray = 0; tray < TRAYS; tray++) {
+        captureWindow(scanner, tray);
+        if (lag == 0) {
+            decodePending(scanner, decodedSequence, baseSequence, stats);
+            lag = (int)(nextRandom(seed) % (maxLagWindows + 1));
+        } else {
+            lag--;
+        }
+    }
+    decodePending(scanner, decodedSequence, baseSequence, stats);
+
+    TEST_ASSERT_EQUAL_INT(TRAYS, stats.decoded + stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)stats.dropped, scanner->getDroppedFrameCount() - baseDropped);
+    TEST_ASSERT_EQUAL_INT(0, stats.corrupted);
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::setSerialEcho(false);
+    // 释放上一个测试遗留的已锁存帧（乒乓缓冲共两帧）
+    DiameterScanner* scanner = DiameterScanner::getInstance();
+    uint32_t latched = scanner->getLatchCount();
+    for (uint32_t seq = (latched >= 2) ? latched - 2 : 0; seq != latched; seq++) {
+        scanner->decodeFrame(seq);
+    }
+}
+
+void tearDown() {}
+
+void test_prompt_decoder_never_drops() {
+    DecodeStats stats;
+    runStress(SCAN_CAPTURE_BITSET, 1, 0, stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.dropped);
+}
+
+void test_decoder_one_window_behind_never_drops() {
+    // 乒乓缓冲：解码落后一帧时，另一个缓冲仍可用于采集
+    DiameterScanner* scanner = DiameterScanner::getInstance();
+    scanner->setCaptureMode(SCAN_CAPTURE_BITSET);
+    uint32_t base = scanner->getLatchCount();
+    uint32_t decodedSequence = base;
+    uint32_t baseDropped = scanner->getDroppedFrameCount();
+    DecodeStats stats = {0, 0, 0};
+    captureWindow(scanner, 0);
+    for (long tray = 1; tray < 200; tray++) {
+        captureWindow(scanner, tray);
+        // 只解码到上一窗口为止
+        uint32_t latched = scanner->getLatchCount();
+        while (decodedSequence + 1 != latched) {
+            long t = (long)(decodedSequence - base);
+            TEST_ASSERT_TRUE(scanner->decodeFrame(decodedSequence));
+            TEST_ASSERT_EQUAL_INT(widthFor(t, 2), scanner->getHighLevelPulseCount(2));
+            decodedSequence++;
+        }
+    }
+    decodePending(scanner, decodedSequence, base, stats);
+    TEST_ASSERT_EQUAL_UINT32(0, scanner->getDroppedFrameCount() - baseDropped);
+}
+
+void test_delayed_decoder_flags_drops_without_corruption_bitset() {
+    DecodeStats stats;
+    runStress(SCAN_CAPTURE_BITSET, 0x2545F491u, 4, stats);
+    TEST_ASSERT_GREATER_THAN(0, stats.dropped);
+    char message[120];
+    snprintf(message, sizeof(message), "bitset: %d windows decoded, %d dropped and flagged, 0 corrupted",
+             stats.decoded, stats.dropped);
+    TEST_MESSAGE(message);
+}
+
+void test_delayed_decoder_flags_drops_without_corruption_edges() {
+    DecodeStats stats;
+    runStress(SCAN_CAPTURE_EDGES, 0x9E3779B9u, 4, stats);
+    TEST_ASSERT_GREATER_THAN(0, stats.dropped);
+    char message[120];
+    snprintf(message, sizeof(message), "edges: %d windows decoded, %d dropped and flagged, 0 corrupted",
+             stats.decoded, stats.dropped);
+    TEST_MESSAGE(message);
+    DiameterScanner::getInstance()->setCaptureMode(SCAN_CAPTURE_BITSET);
+}
+
+void test_slow_control_task_marks_dropped_trays() {
+    // 整机：run() 每次占用控制任务 2.5 个托盘周期，解码落后超过一帧；
+    // 丢帧的托盘必须带 TRAY_FLAG_FRAME_DROPPED 并按空托盘补位，其余托盘的锁存结果必须正确
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+    ProductStream stream;
+    stream.generate(3, 1000, 15, 5);
+
+    SimConfig config;
+    config.startTps = 1.0f;
+    config.maxTps = 1.0f;
+    config.traysPerStep = 200;
+    config.runCostUs = 2500000;
+    config.stopAtFirstFailure = false;
+
+    ConveyorSimulator simulator(&sorter, &stream, config);
+    const std::vector<SimStepResult>& results = simulator.runSweep();
+    TEST_ASSERT_EQUAL_INT(1, (int)results.size());
+    const SimStepResult& r = results[0];
+    char message[120];
+    snprintf(message, sizeof(message), "sorter: %d trays, %d dropped and flagged, %d mis-latched, %d missed events",
+             r.trays, r.droppedFrames, r.misLatched, r.missedEvents);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN(0, r.droppedFrames);
+    TEST_ASSERT_GREATER_OR_EQUAL(r.droppedFrames, r.missedEvents);
+    TEST_ASSERT_EQUAL_INT(0, r.misLatched);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_slow_control_task_marks_dropped_trays);   // 需要从 0 开始的锁存序号，放在最前
+    RUN_TEST(test_prompt_decoder_never_drops);
+    RUN_TEST(test_decoder_one_window_behind_never_drops);
+    RUN_TEST(test_delayed_decoder_flags_drops_without_corruption_bitset);
+    RUN_TEST(test_delayed_decoder_flags_drops_without_corruption_edges);
+    return UNITY_END();
+}
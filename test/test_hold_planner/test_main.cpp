@@ -0,0 +1,134 @@
+// 翻板保持规划：按 Sorter::prepareOutlets() 的规则回放伪随机托盘流，比较只看下一托盘（旧）与 N 托盘前瞻（新）
+// 每 1000 托盘的线圈动作次数，并检查翻板打开时经过分流点的托盘只有目标物品或确定的空托盘
+// 托盘流由固定种子生成，报告的数字每次运行都相同
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "config.h"
+#include "modular/outlet_hold_planner.h"
+
+namespace {
+
+const int OUTLETS = NUM_OUTLETS;
+const int QUEUE = 32;
+const uint8_t NO_OUTLET = 0xFF;
+const long REPLAY_TRAYS = 100000;
+
+struct ReplayTray {
+    uint8_t outlet;     // 目标出口，NO_OUTLET = 不分流
+    bool occupied;
+    bool dropped;       // 扫描丢帧，内容未知
+};
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// 托盘流：emptyPercent 的空托盘；非空托盘 70% 延续上一等级（同一出口成串），其余随机换等级；0.5% 丢帧
+std::vector<ReplayTray> makeStream(uint32_t seed, long count, int emptyPercent) {
+    std::vector<ReplayTray> trays(count);
+    uint8_t grade = 0;
+    for (long t = 0; t < count; t++) {
+        ReplayTray& tray = trays[t];
+        tray.dropped = (nextRandom(seed) % 1000) < 5;
+        tray.occupied = !tray.dropped && (int)(nextRandom(seed) % 100) >= emptyPercent;
+        tray.outlet = NO_OUTLET;
+        if (tray.occupied) {
+            if (nextRandom(seed) % 100 >= 70) grade = (uint8_t)(nextRandom(seed) % (OUTLETS + 1));
+            tray.outlet = (grade < OUTLETS) ? grade : NO_OUTLET;    // 等级 OUTLETS：不属于任何出口
+        }
+    }
+    return trays;
+}
+
+struct ReplayResult {
+    long actuations;        // 线圈脉冲（打开 + 关闭）
+    long unsafePasses;      // 翻板打开时经过的非目标、非空托盘
+};
+
+// 与 prepareOutlets() 相同：位置 p 上是 p 个周期前锁存的托盘；翻板状态变化一次计一次线圈脉冲
+ReplayResult replay(const std::vector<ReplayTray>& trays, int lookahead) {
+    ReplayResult result = {0, 0};
+    bool flapOpen[OUTLETS] = {};
+    bool stayOpenNext[OUTLETS] = {};
+    int divergence[OUTLETS];
+    for (int i = 0; i < OUTLETS; i++) divergence[i] = 1 + i * 2;
+
+    for (long head = 0; head < (long)trays.size(); head++) {
+        for (int i = 0; i < OUTLETS; i++) {
+            auto classify = [&](int p) -> HoldSlot {
+                long t = head - p;
+                if (p < 0 || p >= QUEUE || t < 0) return HOLD_SLOT_OTHER;
+                const ReplayTray& tray = trays[t];
+                if (tray.outlet == i) return HOLD_SLOT_TARGET;
+                if (!tray.occupied && !tray.dropped) return HOLD_SLOT_EMPTY;
+                return HOLD_SLOT_OTHER;
+            };
+            int pos = divergence[i];
+            HoldSlot current = classify(pos);
+            bool open = (current == HOLD_SLOT_TARGET) || (current == HOLD_SLOT_EMPTY && stayOpenNext[i]);
+            stayOpenNext[i] = open && planHoldOpen(pos, lookahead, classify);
+
+            if (open != flapOpen[i]) result.actuations++;
+            flapOpen[i] = open;
+            if (open && current == HOLD_SLOT_OTHER) result.unsafePasses++;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_lookahead_one_holds_only_for_the_next_tray() {
+    // 分流点位于位置 4，上游依次为位置 3、2、1、0
+    HoldSlot slots[5] = {HOLD_SLOT_OTHER, HOLD_SLOT_OTHER, HOLD_SLOT_OTHER, HOLD_SLOT_TARGET, HOLD_SLOT_TARGET};
+    auto classify = [&](int p) -> HoldSlot { return (p >= 0 && p < 5) ? slots[p] : HOLD_SLOT_OTHER; };
+    TEST_ASSERT_TRUE(planHoldOpen(4, 1, classify));
+
+    slots[3] = HOLD_SLOT_EMPTY;                     // 下一个为空托盘，再下一个为其它物品：关闭
+    TEST_ASSERT_FALSE(planHoldOpen(4, 1, classify));
+    TEST_ASSERT_FALSE(planHoldOpen(4, 4, classify));
+
+    slots[2] = HOLD_SLOT_TARGET;                    // 空托盘之后是目标：只有前瞻 >= 2 才保持
+    TEST_ASSERT_FALSE(planHoldOpen(4, 1, classify));
+    TEST_ASSERT_TRUE(planHoldOpen(4, 2, classify));
+
+    slots[2] = HOLD_SLOT_EMPTY;                     // 窗口内全为空托盘：窗口耗尽时关闭
+    slots[1] = HOLD_SLOT_EMPTY;
+    slots[0] = HOLD_SLOT_EMPTY;
+    TEST_ASSERT_FALSE(planHoldOpen(4, 4, classify));
+}
+
+void test_replay_actuations_per_1000_trays() {
+    const int EMPTY_PERCENTS[3] = {10, 30, 50};
+    for (int k = 0; k < 3; k++) {
+        std::vector<ReplayTray> trays = makeStream(0x1234567u + k, REPLAY_TRAYS, EMPTY_PERCENTS[k]);
+        ReplayResult before = replay(trays, 1);
+        ReplayResult after = replay(trays, OUTLET_HOLD_LOOKAHEAD);
+
+        char message[160];
+        snprintf(message, sizeof(message), "%d%% empty: %.1f -> %.1f coil pulses per 1000 trays (lookahead 1 -> %d)",
+                 EMPTY_PERCENTS[k], before.actuations * 1000.0 / REPLAY_TRAYS,
+                 after.actuations * 1000.0 / REPLAY_TRAYS, OUTLET_HOLD_LOOKAHEAD);
+        TEST_MESSAGE(message);
+
+        TEST_ASSERT_EQUAL_INT(0, (int)before.unsafePasses);
+        TEST_ASSERT_EQUAL_INT(0, (int)after.unsafePasses);
+        TEST_ASSERT_LESS_OR_EQUAL(before.actuations, after.actuations);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lookahead_one_holds_only_for_the_next_tray);
+    RUN_TEST(test_replay_actuations_per_1000_trays);
+    return UNITY_END();
+}
@@ -0,0 +1,167 @@
+// 主机端硬件抽象层（lib/native_hal）：虚拟时间、引脚中断、定时器、74HC595 帧记录与 RTOS 原语
+// 其它测试与基准都建立在这些行为之上
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <vector>
+
+namespace {
+
+const int TEST_PIN = 5;
+const int DATA_PIN = 10;
+const int CLOCK_PIN = 11;
+const int LATCH_PIN = 12;
+
+int isrCalls = 0;
+int isrLevel = -1;
+std::vector<int> timerOrder;
+std::vector<uint64_t> timerTimes;
+
+void countingIsr() {
+    isrCalls++;
+    isrLevel = digitalRead(TEST_PIN);
+}
+
+void timerCallback(void* arg) {
+    timerOrder.push_back((int)(intptr_t)arg);
+    timerTimes.push_back(NativeHal::nowUs());
+}
+
+esp_timer_handle_t createTimer(int id) {
+    esp_timer_create_args_t args = {};
+    args.callback = timerCallback;
+    args.arg = (void*)(intptr_t)id;
+    args.name = "test";
+    esp_timer_handle_t handle = nullptr;
+    esp_timer_create(&args, &handle);
+    return handle;
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+    isrCalls = 0;
+    isrLevel = -1;
+    timerOrder.clear();
+    timerTimes.clear();
+}
+
+void tearDown() {}
+
+void test_virtual_time_only_moves_when_advanced() {
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)NativeHal::nowUs());
+    delay(5);
+    TEST_ASSERT_EQUAL_UINT32(5000, (uint32_t)NativeHal::nowUs());
+    vTaskDelay(pdMS_TO_TICKS(10));
+    TEST_ASSERT_EQUAL_UINT32(15, millis());
+    NativeHal::advanceTo(1000);  // 早于当前时间：不动
+    TEST_ASSERT_EQUAL_UINT32(15000, (uint32_t)esp_timer_get_time());
+}
+
+void test_pin_interrupt_modes() {
+    attachInterrupt(TEST_PIN, countingIsr, RISING);
+    NativeHal::setPinLevel(TEST_PIN, HIGH);
+    NativeHal::setPinLevel(TEST_PIN, HIGH);  // 无变化不触发
+    NativeHal::setPinLevel(TEST_PIN, LOW);
+    TEST_ASSERT_EQUAL_INT(1, isrCalls);
+    TEST_ASSERT_EQUAL_INT(HIGH, isrLevel);
+
+    attachInterrupt(TEST_PIN, countingIsr, CHANGE);
+    NativeHal::setPinLevel(TEST_PIN, HIGH);
+    NativeHal::setPinLevel(TEST_PIN, LOW);
+    TEST_ASSERT_EQUAL_INT(3, isrCalls);
+
+    // 回放用：只改电平，不触发
+    NativeHal::forcePinLevel(TEST_PIN, HIGH);
+    TEST_ASSERT_EQUAL_INT(3, isrCalls);
+    TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(TEST_PIN));
+}
+
+void test_isr_cost_coalesces_edges_on_the_same_pin() {
+    attachInterrupt(TEST_PIN, countingIsr, CHANGE);
+    NativeHal::setIsrCostUs(10);
+    NativeHal::setPinLevel(TEST_PIN, HIGH);  // 立即服务，CPU 忙到 10us
+    NativeHal::setPinLevel(TEST_PIN, LOW);   // 挂起
+    NativeHal::setPinLevel(TEST_PIN, HIGH);  // 与挂起的合并
+    TEST_ASSERT_EQUAL_INT(1, isrCalls);
+    TEST_ASSERT_EQUAL_UINT32(1, NativeHal::getCoalescedInterruptCount());
+
+    NativeHal::advanceUs(10);
+    TEST_ASSERT_EQUAL_INT(2, isrCalls);
+    TEST_ASSERT_EQUAL_INT(HIGH, isrLevel);   // 服务时读取的是当时的电平
+}
+
+void test_timers_fire_in_due_order_at_their_due_time() {
+    esp_timer_handle_t a = createTimer(1);
+    esp_timer_handle_t b = createTimer(2);
+    esp_timer_handle_t c = createTimer(3);
+    esp_timer_start_once(a, 300);
+    esp_timer_start_once(b, 100);
+    esp_timer_start_once(c, 200);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_timer_start_once(a, 50));
+    esp_timer_stop(c);
+
+    uint64_t next = 0;
+    TEST_ASSERT_TRUE(NativeHal::nextEventUs(next));
+    TEST_ASSERT_EQUAL_UINT32(100, (uint32_t)next);
+
+    NativeHal::advanceUs(1000);
+    TEST_ASSERT_EQUAL_INT(2, (int)timerOrder.size());
+    TEST_ASSERT_EQUAL_INT(2, timerOrder[0]);
+    TEST_ASSERT_EQUAL_INT(1, timerOrder[1]);
+    TEST_ASSERT_EQUAL_UINT32(100, (uint32_t)timerTimes[0]);
+    TEST_ASSERT_EQUAL_UINT32(300, (uint32_t)timerTimes[1]);
+    TEST_ASSERT_FALSE(esp_timer_is_active(a));
+}
+
+void test_shift_out_frames_latch_on_rising_edge() {
+    digitalWrite(LATCH_PIN, LOW);
+    shiftOut(DATA_PIN, CLOCK_PIN, MSBFIRST, 0xA5);
+    shiftOut(DATA_PIN, CLOCK_PIN, LSBFIRST, 0x01);
+    TEST_ASSERT_EQUAL_UINT32(0, NativeHal::getLatchCount());
+    digitalWrite(LATCH_PIN, HIGH);
+
+    uint8_t frame[NativeHal::MAX_FRAME_BYTES];
+    TEST_ASSERT_EQUAL_INT(2, NativeHal::getLatchedFrame(frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_HEX8(0xA5, frame[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x80, frame[1]);  // LSBFIRST 按移出顺序记录
+    TEST_ASSERT_EQUAL_UINT32(1, NativeHal::getLatchCount());
+}
+
+void test_eeprom_and_rtos_primitives() {
+    EEPROM.begin(64);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, EEPROM.read(3));
+    EEPROM.write(3, 0x42);
+    TEST_ASSERT_EQUAL_HEX8(0x42, EEPROM.read(3));
+    NativeHal::reset();
+    TEST_ASSERT_EQUAL_HEX8(0xFF, EEPROM.read(3));
+
+    // 单线程：取不到的信号量立即失败
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(mutex, portMAX_DELAY));
+    TEST_ASSERT_EQUAL(pdFALSE, xSemaphoreTake(mutex, portMAX_DELAY));
+    xSemaphoreGive(mutex);
+    vSemaphoreDelete(mutex);
+
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    vTaskNotifyGiveFromISR(task, nullptr);
+    xTaskNotifyGive(task);
+    TEST_ASSERT_EQUAL_UINT32(2, NativeHal::getPendingNotifications(task));
+    TEST_ASSERT_EQUAL_UINT32(2, ulTaskNotifyTake(pdTRUE, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, ulTaskNotifyTake(pdTRUE, 0));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_virtual_time_only_moves_when_advanced);
+    RUN_TEST(test_pin_interrupt_modes);
+    RUN_TEST(test_isr_cost_coalesces_edges_on_the_same_pin);
+    RUN_TEST(test_timers_fire_in_due_order_at_their_due_time);
+    RUN_TEST(test_shift_out_frames_latch_on_rising_edge);
+    RUN_TEST(test_eeprom_and_rtos_primitives);
+    return UNITY_END();
+}
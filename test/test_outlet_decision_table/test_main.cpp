@@ -0,0 +1,201 @@
+// 出口判定查找表：OutletDecisionTable::compile / lookup 的 (min, max] 边界在 q = ceil(d / 10) 量化下不偏移、
+// 长度匹配（LEN_NONE / LEN_ALL 不限长度）、重叠与空档统计、出口 0 多物检测模式（不参与直径分级）、超出范围的直径
+
+#include <unity.h>
+#include <stdint.h>
+#include "config.h"
+#include "modular/outlet_decision_table.h"
+
+namespace {
+
+const uint8_t LENGTHS[3] = {LEN_S, LEN_M, LEN_L};
+
+OutletRule rule(int minMm, int maxMm, uint8_t lengthMask = LEN_ALL, bool enabled = true) {
+    OutletRule r;
+    r.minMm = minMm;
+    r.maxMm = maxMm;
+    r.lengthMask = lengthMask;
+    r.enabled = enabled;
+    return r;
+}
+
+// 直径 d (0.1mm) 在所有已识别长度下的查表结果都等于 expected
+void checkAllLengths(const OutletDecisionTable& table, int diameterDeciMm, uint8_t expected) {
+    for (int l = 0; l < 3; l++) {
+        TEST_ASSERT_EQUAL_HEX8(expected, table.lookup(diameterDeciMm, LENGTHS[l]));
+    }
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_empty_table() {
+    OutletDecisionTable table;
+    checkAllLengths(table, 150, 0x00);
+    TEST_ASSERT_EQUAL_INT(0, table.getOverlapCells());
+    TEST_ASSERT_EQUAL_INT(0, table.getGapCells());
+    TEST_ASSERT_EQUAL_INT(-1, table.getFirstOverlapMm());
+    TEST_ASSERT_EQUAL_INT(-1, table.getFirstGapMm());
+}
+
+void test_range_boundaries_under_quantization() {
+    // (12, 20]：d > 120 且 d <= 200 (0.1mm)
+    OutletRule rules[1] = {rule(12, 20)};
+    OutletDecisionTable table;
+    table.compile(rules, 1);
+
+    checkAllLengths(table, 12 * 10 - 1, 0x00);
+    checkAllLengths(table, 12 * 10, 0x00);       // d = min*10：q = 12，不含下限
+    checkAllLengths(table, 12 * 10 + 1, 0x01);   // d = min*10+1：q = 13
+    checkAllLengths(table, 20 * 10, 0x01);       // d = max*10：q = 20，含上限
+    checkAllLengths(table, 20 * 10 + 1, 0x00);   // d = max*10+1：q = 21
+
+    // 与量化前的 (min, max] 判定逐点一致
+    for (int d = 1; d <= 300; d++) {
+        uint8_t expected = (d > 120 && d <= 200) ? 0x01 : 0x00;
+        TEST_ASSERT_EQUAL_HEX8(expected, table.lookup(d, LEN_M));
+    }
+}
+
+void test_adjacent_ranges_share_no_boundary() {
+    // (10, 15] 与 (15, 20] 首尾相接：d = 150 只属于出口 0，d = 151 只属于出口 1
+    OutletRule rules[2] = {rule(10, 15), rule(15, 20)};
+    OutletDecisionTable table;
+    table.compile(rules, 2);
+
+    checkAllLengths(table, 150, 0x01);
+    checkAllLengths(table, 151, 0x02);
+    TEST_ASSERT_EQUAL_INT(0, table.getOverlapCells());
+    TEST_ASSERT_EQUAL_INT(0, table.getGapCells());
+}
+
+void test_length_mask() {
+    OutletRule rules[4] = {rule(10, 20, LEN_M), rule(10, 20, LEN_S | LEN_L), rule(10, 20, LEN_NONE), rule(10, 20, LEN_ALL)};
+    OutletDecisionTable table;
+    table.compile(rules, 4);
+
+    // LEN_NONE / LEN_ALL 不限长度，未识别长度 (0) 时也匹配；单一长度规则只在检测到该长度时匹配
+    TEST_ASSERT_EQUAL_HEX8(0x0D, table.lookup(150, LEN_M));
+    TEST_ASSERT_EQUAL_HEX8(0x0E, table.lookup(150, LEN_S));
+    TEST_ASSERT_EQUAL_HEX8(0x0E, table.lookup(150, LEN_L));
+    TEST_ASSERT_EQUAL_HEX8(0x0C, table.lookup(150, LEN_NONE));
+}
+
+void test_overlap_cells() {
+    // (10, 20] 与 (15, 30]：q = 16..20 共 5 个直径 x 3 个长度重叠
+    OutletRule rules[2] = {rule(10, 20), rule(15, 30)};
+    OutletDecisionTable table;
+    table.compile(rules, 2);
+
+    TEST_ASSERT_EQUAL_INT(15, table.getOverlapCells());
+    TEST_ASSERT_EQUAL_INT(16, table.getFirstOverlapMm());
+    TEST_ASSERT_EQUAL_INT(0, table.getGapCells());
+    TEST_ASSERT_EQUAL_INT(-1, table.getFirstGapMm());
+    checkAllLengths(table, 150, 0x01);
+    checkAllLengths(table, 151, 0x03);
+    checkAllLengths(table, 200, 0x03);
+    checkAllLengths(table, 201, 0x02);
+}
+
+void test_gap_cells() {
+    // (10, 20] 与 (25, 30]：q = 21..25 共 5 个直径 x 3 个长度无出口
+    OutletRule rules[2] = {rule(10, 20), rule(25, 30)};
+    OutletDecisionTable table;
+    table.compile(rules, 2);
+
+    TEST_ASSERT_EQUAL_INT(15, table.getGapCells());
+    TEST_ASSERT_EQUAL_INT(21, table.getFirstGapMm());
+    TEST_ASSERT_EQUAL_INT(0, table.getOverlapCells());
+    checkAllLengths(table, 201, 0x00);
+    checkAllLengths(table, 250, 0x00);
+    checkAllLengths(table, 251, 0x02);
+
+    // 覆盖范围之外（最小下限以下、最大上限以上）不计为空档
+    TEST_ASSERT_EQUAL_HEX8(0x00, table.lookup(50, LEN_S));
+    TEST_ASSERT_EQUAL_HEX8(0x00, table.lookup(400, LEN_S));
+}
+
+void test_gap_for_unserved_length() {
+    // 只接收短料：中、长料在 q = 11..20 上是空档
+    OutletRule rules[1] = {rule(10, 20, LEN_S)};
+    OutletDecisionTable table;
+    table.compile(rules, 1);
+
+    TEST_ASSERT_EQUAL_INT(20, table.getGapCells());
+    TEST_ASSERT_EQUAL_INT(11, table.getFirstGapMm());
+}
+
+void test_disabled_outlet0_mode() {
+    // 出口 0 处于多物检测模式：其直径区间不参与查表，也不计入覆盖范围
+    OutletRule rules[3] = {rule(0, 255, LEN_ALL, false), rule(10, 20), rule(20, 30)};
+    OutletDecisionTable table;
+    table.compile(rules, 3);
+
+    checkAllLengths(table, 5, 0x00);
+    checkAllLengths(table, 150, 0x02);
+    checkAllLengths(table, 250, 0x04);
+    checkAllLengths(table, 2000, 0x00);
+    TEST_ASSERT_EQUAL_INT(0, table.getOverlapCells());
+    TEST_ASSERT_EQUAL_INT(0, table.getGapCells());
+
+    // 切换为直径模式后重新编译：出口 0 与其余出口全部重叠
+    rules[0].enabled = true;
+    table.compile(rules, 3);
+    checkAllLengths(table, 150, 0x03);
+    TEST_ASSERT_EQUAL_INT(11, table.getFirstOverlapMm());
+}
+
+void test_invalid_rule_is_ignored() {
+    // max <= min 的规则从不匹配，也不扩大覆盖范围
+    OutletRule rules[2] = {rule(40, 40), rule(10, 20)};
+    OutletDecisionTable table;
+    table.compile(rules, 2);
+
+    checkAllLengths(table, 400, 0x00);
+    TEST_ASSERT_EQUAL_INT(0, table.getGapCells());
+}
+
+void test_out_of_range_diameters() {
+    OutletRule rules[2] = {rule(0, 10), rule(250, 255)};
+    OutletDecisionTable table;
+    table.compile(rules, 2);
+
+    // 空托盘与负值
+    checkAllLengths(table, 0, 0x00);
+    checkAllLengths(table, -5, 0x00);
+    // 最小正直径落在 q = 1
+    checkAllLengths(table, 1, 0x01);
+    // 配置上限 255mm 仍可查，超过即无出口
+    const int MAX_DECI_MM = OutletDecisionTable::MAX_DIAMETER_MM * 10;
+    checkAllLengths(table, MAX_DECI_MM, 0x02);
+    checkAllLengths(table, MAX_DECI_MM + 1, 0x00);
+    checkAllLengths(table, 100000, 0x00);
+}
+
+void test_rule_count_is_clamped() {
+    OutletRule rules[9];
+    for (int i = 0; i < 9; i++) rules[i] = rule(i * 10, i * 10 + 10);
+    OutletDecisionTable table;
+    table.compile(rules, 9);
+
+    checkAllLengths(table, 800, 0x80);
+    checkAllLengths(table, 850, 0x00);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_table);
+    RUN_TEST(test_range_boundaries_under_quantization);
+    RUN_TEST(test_adjacent_ranges_share_no_boundary);
+    RUN_TEST(test_length_mask);
+    RUN_TEST(test_overlap_cells);
+    RUN_TEST(test_gap_cells);
+    RUN_TEST(test_gap_for_unserved_length);
+    RUN_TEST(test_disabled_outlet0_mode);
+    RUN_TEST(test_invalid_rule_is_ignored);
+    RUN_TEST(test_out_of_range_diameters);
+    RUN_TEST(test_rule_count_is_clamped);
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+// 出口选择：selectOutlet()（Sorter::decideOutlet 的纯逻辑部分）在多个出口匹配时取分流点位置最小者，
+// 出口 0 多物检测模式下多物体与低置信度托盘强制分到出口 0，直径模式下不强制
+
+#include <unity.h>
+#include <stdint.h>
+#include "config.h"
+#include "modular/outlet_decision_table.h"
+
+namespace {
+
+const uint8_t NONE = OutletDecisionTable::NO_OUTLET;
+// 与 Sorter::initialize() 的默认分流点相同：出口 0 最靠近扫描位
+const uint8_t DEFAULT_POINTS[NUM_OUTLETS] = {0, 2, 4, 6, 8, 10, 12, 14};
+
+OutletRule rule(int minMm, int maxMm, uint8_t lengthMask = LEN_ALL, bool enabled = true) {
+    OutletRule r;
+    r.minMm = minMm;
+    r.maxMm = maxMm;
+    r.lengthMask = lengthMask;
+    r.enabled = enabled;
+    return r;
+}
+
+// 出口 0：(5, 40]，仅在直径模式下参与查表；出口 1-3 区间两两重叠
+void compileTable(OutletDecisionTable& table, uint8_t outlet0Mode) {
+    OutletRule rules[NUM_OUTLETS] = {
+        rule(5, 40, LEN_ALL, outlet0Mode != 0),
+        rule(10, 20),
+        rule(15, 30),
+        rule(25, 40, LEN_L),
+        rule(0, 0), rule(0, 0), rule(0, 0), rule(0, 0)
+    };
+    table.compile(rules, NUM_OUTLETS);
+}
+
+uint8_t select(const OutletDecisionTable& table, const uint8_t* points, uint8_t outlet0Mode,
+               int diameterDeciMm, uint8_t lengthMask, int objectCount, bool lowConfidence) {
+    return selectOutlet(table, points, NUM_OUTLETS, outlet0Mode, diameterDeciMm, lengthMask, objectCount, lowConfidence);
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_single_match() {
+    OutletDecisionTable table;
+    compileTable(table, 0);
+    TEST_ASSERT_EQUAL_UINT8(1, select(table, DEFAULT_POINTS, 0, 120, LEN_M, 1, false));
+    TEST_ASSERT_EQUAL_UINT8(2, select(table, DEFAULT_POINTS, 0, 220, LEN_M, 1, false));
+    TEST_ASSERT_EQUAL_UINT8(NONE, select(table, DEFAULT_POINTS, 0, 500, LEN_M, 1, false));
+    TEST_ASSERT_EQUAL_UINT8(NONE, select(table, DEFAULT_POINTS, 0, 0, LEN_NONE, 0, false));
+}
+
+void test_smallest_divergence_point_wins() {
+    OutletDecisionTable table;
+    compileTable(table, 0);
+
+    // 18mm 同时匹配出口 1、2：默认分流点下出口 1 先到达
+    TEST_ASSERT_EQUAL_UINT8(1, select(table, DEFAULT_POINTS, 0, 180, LEN_M, 1, false));
+    // 分流点顺序与出口编号无关：出口 2 的分流点更靠前时选出口 2
+    const uint8_t reversed[NUM_OUTLETS] = {14, 12, 10, 8, 6, 4, 2, 0};
+    TEST_ASSERT_EQUAL_UINT8(2, select(table, reversed, 0, 180, LEN_M, 1, false));
+    // 28mm 长料匹配出口 2、3
+    TEST_ASSERT_EQUAL_UINT8(2, select(table, DEFAULT_POINTS, 0, 280, LEN_L, 1, false));
+    TEST_ASSERT_EQUAL_UINT8(3, select(table, reversed, 0, 280, LEN_L, 1, false));
+    // 分流点相同时取编号小者
+    const uint8_t tied[NUM_OUTLETS] = {0, 5, 5, 5, 8, 10, 12, 14};
+    TEST_ASSERT_EQUAL_UINT8(2, select(table, tied, 0, 280, LEN_L, 1, false));
+}
+
+void test_multi_object_forces_outlet0_in_multi_object_mode() {
+    OutletDecisionTable table;
+    compileTable(table, 0);
+    // 直径匹配出口 1，但托盘上有两个物体：出口 0 分流点最靠前
+    TEST_ASSERT_EQUAL_UINT8(0, select(table, DEFAULT_POINTS, 0, 120, LEN_M, 2, false));
+    // 直径无匹配时同样分到出口 0
+    TEST_ASSERT_EQUAL_UINT8(0, select(table, DEFAULT_POINTS, 0, 500, LEN_M, 3, false));
+    // 单个物体不受影响；出口 0 本身不参与直径分级
+    TEST_ASSERT_EQUAL_UINT8(NONE, select(table, DEFAULT_POINTS, 0, 80, LEN_M, 1, false));
+}
+
+void test_low_confidence_forces_outlet0_in_multi_object_mode() {
+    OutletDecisionTable table;
+    compileTable(table, 0);
+    // 低置信度托盘不参与直径分级：只剩出口 0，与分流点顺序无关
+    TEST_ASSERT_EQUAL_UINT8(0, select(table, DEFAULT_POINTS, 0, 120, LEN_M, 1, true));
+    const uint8_t reversed[NUM_OUTLETS] = {14, 12, 10, 8, 6, 4, 2, 0};
+    TEST_ASSERT_EQUAL_UINT8(0, select(table, reversed, 0, 180, LEN_M, 1, true));
+}
+
+void test_diameter_mode_does_not_force_outlet0() {
+    OutletDecisionTable table;
+    compileTable(table, 1);
+    // 出口 0 按直径 (5, 40] 参与分级
+    TEST_ASSERT_EQUAL_UINT8(0, select(table, DEFAULT_POINTS, 1, 80, LEN_M, 1, false));
+    TEST_ASSERT_EQUAL_UINT8(0, select(table, DEFAULT_POINTS, 1, 120, LEN_M, 1, false));
+    // 多物体托盘不强制，直径超出出口 0 的区间时不分流
+    TEST_ASSERT_EQUAL_UINT8(NONE, select(table, DEFAULT_POINTS, 1, 500, LEN_M, 2, false));
+    // 低置信度托盘不参与任何分级，随传送带流到末端
+    TEST_ASSERT_EQUAL_UINT8(NONE, select(table, DEFAULT_POINTS, 1, 120, LEN_M, 1, true));
+}
+
+void test_outlet_count_limits_candidates() {
+    OutletDecisionTable table;
+    compileTable(table, 0);
+    // 只考虑前 2 个出口：28mm 长料匹配的出口 2、3 都不在范围内
+    uint8_t points[2] = {0, 2};
+    TEST_ASSERT_EQUAL_UINT8(NONE, selectOutlet(table, points, 2, 0, 280, LEN_L, 1, false));
+    TEST_ASSERT_EQUAL_UINT8(1, selectOutlet(table, points, 2, 0, 120, LEN_L, 1, false));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_match);
+    RUN_TEST(test_smallest_divergence_point_wins);
+    RUN_TEST(test_multi_object_forces_outlet0_in_multi_object_mode);
+    RUN_TEST(test_low_confidence_forces_outlet0_in_multi_object_mode);
+    RUN_TEST(test_diameter_mode_does_not_force_outlet0);
+    RUN_TEST(test_outlet_count_limits_candidates);
+    return UNITY_END();
+}
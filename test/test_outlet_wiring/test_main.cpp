@@ -0,0 +1,127 @@
+// 出口布线表组帧：OutletFramePacker::pack 与旧版 updateShiftRegisters() 的逐出口位映射逐帧比较
+// 旧版按 Outlet 状态逐位拼出 (chip2Byte, chip1Byte, ledByte) 后交给驱动；此处照原样移植为按位图组帧
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdint.h>
+#include <string.h>
+#include "modular/outlet_wiring.h"
+#include "modular/sorter.h"
+
+Sorter sorter;
+
+namespace {
+
+const int CHAIN = BoardOutletWiring::CHAIN_LENGTH;
+
+// 旧版 updateShiftRegisters()：帧字节 0 = 芯片2（出口 0-3 H 桥），1 = 芯片1（出口 4-7 H 桥），2 = LED
+void legacyPack(uint8_t* bytes, uint32_t positionMask, uint32_t openMask, uint32_t closeMask) {
+    uint8_t ledByte = 0;
+    uint8_t chip1Byte = 0;
+    uint8_t chip2Byte = 0;
+
+    for (int i = 0; i < 8; i++) {
+        if (positionMask & (1u << i)) {
+            // 硬件映射修正：0-3 位正常映射，4-7 位反向映射 (7-6-5-4)
+            if (i < 4) {
+                ledByte |= (1 << i);
+            } else {
+                ledByte |= (1 << (7 - (i - 4)));
+            }
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        if (openMask & (1u << (i + 4))) chip1Byte |= (1 << (i * 2));
+        if (closeMask & (1u << (i + 4))) chip1Byte |= (1 << (i * 2 + 1));
+    }
+    for (int i = 0; i < 4; i++) {
+        if (openMask & (1u << i)) chip2Byte |= (1 << (i * 2));
+        if (closeMask & (1u << i)) chip2Byte |= (1 << (i * 2 + 1));
+    }
+
+    bytes[0] = chip2Byte;
+    bytes[1] = chip1Byte;
+    bytes[2] = ledByte;
+}
+
+// 由出口对象的状态按旧版规则组帧
+void legacyPackOutlets(Sorter& s, uint8_t* bytes) {
+    uint32_t position = 0, open = 0, close = 0;
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        Outlet* outlet = s.getOutlet(i);
+        if (outlet->isPositionOpen()) position |= (1u << i);
+        if (outlet->isOpenPulseActive()) open |= (1u << i);
+        if (outlet->isClosePulseActive()) close |= (1u << i);
+    }
+    legacyPack(bytes, position, open, close);
+}
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::setSerialEcho(false);
+}
+
+void tearDown() {}
+
+void test_packer_matches_legacy_for_every_mask() {
+    // 8 个出口的位置、打开脉冲、关闭脉冲位图全部组合（2^24 帧）
+    for (uint32_t position = 0; position < 256; position++) {
+        for (uint32_t open = 0; open < 256; open++) {
+            for (uint32_t close = 0; close < 256; close++) {
+                uint8_t expected[CHAIN];
+                uint8_t actual[CHAIN] = {0};
+                legacyPack(expected, position, open, close);
+                OutletFramePacker<BoardOutletWiring>::pack(actual, position, open, close);
+                if (memcmp(expected, actual, CHAIN) != 0) {
+                    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, actual, CHAIN);
+                }
+            }
+        }
+    }
+}
+
+void test_packer_ignores_bits_above_outlet_count() {
+    uint8_t actual[CHAIN] = {0};
+    OutletFramePacker<BoardOutletWiring>::pack(actual, 0xFFFFFF00u, 0xFFFFFF00u, 0xFFFFFF00u);
+    for (int b = 0; b < CHAIN; b++) TEST_ASSERT_EQUAL_HEX8(0, actual[b]);
+}
+
+void test_sorter_frames_match_legacy_mapping() {
+    // 整机：随机开关出口，每次锁存到 74HC595 的帧与按出口状态由旧版规则组出的帧一致
+    NativeHal::reset();
+    EEPROM.begin(512);
+    sorter.initialize();
+    NativeHal::advanceUs(1000);
+
+    uint32_t seed = 0x2545F491u;
+    for (int step = 0; step < 400; step++) {
+        uint8_t outlet = (uint8_t)(nextRandom(seed) % NUM_OUTLETS);
+        sorter.setOutletState(outlet, (nextRandom(seed) & 1) != 0);
+        NativeHal::advanceUs(1000 + nextRandom(seed) % 150000);
+
+        // 帧在最后一次状态变化时锁存；此后到下一次变化前出口状态不变
+        uint8_t latched[NativeHal::MAX_FRAME_BYTES];
+        TEST_ASSERT_EQUAL_INT(CHAIN, NativeHal::getLatchedFrame(latched, sizeof(latched)));
+        uint8_t expected[CHAIN];
+        legacyPackOutlets(sorter, expected);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, latched, CHAIN);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_packer_matches_legacy_for_every_mask);
+    RUN_TEST(test_packer_ignores_bits_above_outlet_count);
+    RUN_TEST(test_sorter_frames_match_legacy_mapping);
+    return UNITY_END();
+}
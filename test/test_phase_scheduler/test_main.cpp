@@ -0,0 +1,205 @@
+// 相位阈值穿越调度器：抖动、跳相与回调中改写阈值时，事件序列必须与逐相位推进时完全相同
+
+#include <unity.h>
+#include <stdint.h>
+#include <vector>
+#include "modular/phase_scheduler.h"
+
+namespace {
+
+const int RANGE = 200;
+const int SCAN_START = 50;
+const int LATCH = 170;
+const int EXECUTE = 30;
+const int RESET = 150;
+const int EVENT_COUNT = 4;
+
+enum { EV_SCAN = 0, EV_LATCH, EV_EXECUTE, EV_RESET };
+
+struct Harness {
+    PhaseEventScheduler<8> scheduler;
+    std::vector<int> fired;
+    int latches;
+    bool movingExecute;     // 锁存回调中按锁存序号改写执行相位（模拟按速度补偿）
+
+    Harness() : scheduler(RANGE), latches(0), movingExecute(false) {
+        scheduler.addEvent(SCAN_START);
+        scheduler.addEvent(LATCH);
+        scheduler.addEvent(EXECUTE);
+        scheduler.addEvent(RESET);
+        scheduler.setEventCallback(this, onEvent);
+    }
+
+    static void onEvent(void* context, int eventId) {
+        Harness* h = static_cast<Harness*>(context);
+        h->fired.push_back(eventId);
+        if (eventId == EV_LATCH && h->movingExecute) {
+            // 执行相位在 (LATCH, LATCH + 40) 内变化，跨越 0 点回绕
+            int phase = LATCH + 1 + (h->latches * 13) % 40;
+            h->scheduler.setEventPhase(EV_EXECUTE, phase % RANGE);
+            h->latches++;
+        }
+    }
+};
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// 以相同的起点与回调规则，分别喂入 "带跳相/抖动的序列" 与 "逐相位序列"，返回两者的事件序列
+void runAgainstReference(uint32_t seed, int maxJump, int jitterPercent, bool movingExecute,
+                         Harness& jumping, Harness& stepping, int cycles) {
+    jumping.movingExecute = movingExecute;
+    stepping.movingExecute = movingExecute;
+    jumping.scheduler.onPhase(0);
+    stepping.scheduler.onPhase(0);
+
+    long watermark = 0;     // 不回绕的相位水位线
+    long position = 0;      // 编码器实际位置（可因抖动后退）
+    while (watermark < (long)cycles * RANGE) {
+        int r = (int)(nextRandom(seed) % 100);
+        if (r < jitterPercent) {
+            position -= 1 + (int)(nextRandom(seed) % 3);        // 反向抖动
+        } else {
+            position += 1 + (int)(nextRandom(seed) % maxJump);  // 正向，可能跳过若干相位
+        }
+        jumping.scheduler.onPhase((int)(((position % RANGE) + RANGE) % RANGE));
+
+        // 参照：只在越过水位线时逐相位推进
+        while (watermark < position) {
+            watermark++;
+            stepping.scheduler.onPhase((int)(watermark % RANGE));
+        }
+    }
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_event_fires_once_per_cycle_in_phase_order() {
+    Harness h;
+    for (int cycle = 0; cycle < 3; cycle++) {
+        for (int p = 0; p < RANGE; p++) h.scheduler.onPhase(p);
+    }
+    int expected[] = {EV_EXECUTE, EV_SCAN, EV_RESET, EV_LATCH};
+    TEST_ASSERT_EQUAL_INT(12, (int)h.fired.size());
+    for (int i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL_INT(expected[i % 4], h.fired[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, h.scheduler.getSkipOccurrences());
+}
+
+void test_skip_fires_crossed_events_in_order() {
+    Harness h;
+    h.scheduler.onPhase(140);
+    h.scheduler.onPhase(175);   // 越过 150 与 170
+    h.scheduler.onPhase(45);    // 经过 0 点回绕，越过 30
+    TEST_ASSERT_EQUAL_INT(3, (int)h.fired.size());
+    TEST_ASSERT_EQUAL_INT(EV_RESET, h.fired[0]);
+    TEST_ASSERT_EQUAL_INT(EV_LATCH, h.fired[1]);
+    TEST_ASSERT_EQUAL_INT(EV_EXECUTE, h.fired[2]);
+    TEST_ASSERT_EQUAL_UINT32(2, h.scheduler.getSkipOccurrences());
+    TEST_ASSERT_EQUAL_UINT32(34 + 69, h.scheduler.getSkippedPhases());
+}
+
+void test_backward_jitter_does_not_refire() {
+    Harness h;
+    h.scheduler.onPhase(49);
+    h.scheduler.onPhase(50);
+    h.scheduler.onPhase(48);    // 后退
+    h.scheduler.onPhase(51);    // 重新越过 50：不再触发
+    h.scheduler.onPhase(50);
+    TEST_ASSERT_EQUAL_INT(1, (int)h.fired.size());
+    TEST_ASSERT_EQUAL_INT(EV_SCAN, h.fired[0]);
+}
+
+void test_threshold_moved_ahead_by_callback_fires_in_same_skip() {
+    // 锁存回调把执行相位从 175 改到 171：169 -> 172 一次跳过两者，执行事件仍须在锁存之后触发
+    Harness h;
+    h.scheduler.setEventPhase(EV_EXECUTE, 175);
+    h.movingExecute = true;     // 第一次锁存设为 LATCH + 1 = 171
+    h.scheduler.onPhase(169);
+    h.scheduler.onPhase(172);
+    TEST_ASSERT_EQUAL_INT(2, (int)h.fired.size());
+    TEST_ASSERT_EQUAL_INT(EV_LATCH, h.fired[0]);
+    TEST_ASSERT_EQUAL_INT(EV_EXECUTE, h.fired[1]);
+
+    h.scheduler.onPhase(176);   // 旧阈值 175 不再触发
+    TEST_ASSERT_EQUAL_INT(2, (int)h.fired.size());
+}
+
+void test_threshold_moved_behind_by_callback_waits_for_next_cycle() {
+    Harness h;
+    h.movingExecute = false;
+    h.scheduler.onPhase(165);
+    h.scheduler.setEventPhase(EV_EXECUTE, 175);
+    // 回调外把执行相位移到已越过的 168：本周期不触发，下一周期在 168 触发一次
+    h.scheduler.onPhase(172);
+    h.scheduler.setEventPhase(EV_EXECUTE, 168);
+    h.scheduler.onPhase(180);
+    TEST_ASSERT_EQUAL_INT(1, (int)h.fired.size());
+    for (int p = 181; p < RANGE + 170; p++) h.scheduler.onPhase(p % RANGE);
+    int executes = 0;
+    for (size_t i = 0; i < h.fired.size(); i++) executes += (h.fired[i] == EV_EXECUTE);
+    TEST_ASSERT_EQUAL_INT(1, executes);
+}
+
+void test_jittered_sequences_match_single_stepping() {
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        Harness jumping, stepping;
+        runAgainstReference(seed * 2654435761u, 1, 25, false, jumping, stepping, 50);
+        TEST_ASSERT_EQUAL_INT((int)stepping.fired.size(), (int)jumping.fired.size());
+        for (size_t i = 0; i < stepping.fired.size(); i++) {
+            TEST_ASSERT_EQUAL_INT(stepping.fired[i], jumping.fired[i]);
+        }
+        TEST_ASSERT_EQUAL_INT(50 * EVENT_COUNT, (int)jumping.fired.size());
+    }
+}
+
+void test_skipping_sequences_match_single_stepping() {
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        Harness jumping, stepping;
+        runAgainstReference(seed * 2654435761u, 25, 10, false, jumping, stepping, 50);
+        TEST_ASSERT_EQUAL_INT((int)stepping.fired.size(), (int)jumping.fired.size());
+        for (size_t i = 0; i < stepping.fired.size(); i++) {
+            TEST_ASSERT_EQUAL_INT(stepping.fired[i], jumping.fired[i]);
+        }
+        TEST_ASSERT_GREATER_THAN(0, (int)jumping.scheduler.getSkipOccurrences());
+    }
+}
+
+void test_skipping_with_moving_execute_phase_matches_single_stepping() {
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        Harness jumping, stepping;
+        runAgainstReference(seed * 2654435761u, 25, 10, true, jumping, stepping, 50);
+        TEST_ASSERT_EQUAL_INT((int)stepping.fired.size(), (int)jumping.fired.size());
+        for (size_t i = 0; i < stepping.fired.size(); i++) {
+            TEST_ASSERT_EQUAL_INT(stepping.fired[i], jumping.fired[i]);
+        }
+        // 每个锁存之后恰好一次执行（执行相位始终位于下一次锁存之前）
+        int latches = 0, executes = 0;
+        for (size_t i = 0; i < jumping.fired.size(); i++) {
+            if (jumping.fired[i] == EV_LATCH) latches++;
+            if (jumping.fired[i] == EV_EXECUTE && latches > 0) executes++;
+        }
+        TEST_ASSERT_INT_WITHIN(1, latches, executes);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_event_fires_once_per_cycle_in_phase_order);
+    RUN_TEST(test_skip_fires_crossed_events_in_order);
+    RUN_TEST(test_backward_jitter_does_not_refire);
+    RUN_TEST(test_threshold_moved_ahead_by_callback_fires_in_same_skip);
+    RUN_TEST(test_threshold_moved_behind_by_callback_waits_for_next_cycle);
+    RUN_TEST(test_jittered_sequences_match_single_stepping);
+    RUN_TEST(test_skipping_sequences_match_single_stepping);
+    RUN_TEST(test_skipping_with_moving_execute_phase_matches_single_stepping);
+    return UNITY_END();
+}
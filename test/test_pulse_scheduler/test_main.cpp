@@ -0,0 +1,216 @@
+// 电磁铁脉冲截止调度：以伪时钟驱动 "装定 -> 到期 -> 重新装定" 的定时器循环，
+// 检查每个脉冲恰好在起始时刻 + 脉宽结束，与何时被发现无关，并覆盖 32 位时钟回绕；
+// 最后在 NativeHal 虚拟时间中通过 Sorter 的脉冲定时器检查 74HC595 帧上的实际脉宽
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "modular/pulse_scheduler.h"
+#include "modular/sorter.h"
+
+Sorter sorter;
+
+namespace {
+
+const int CHANNELS = 8;
+const uint32_t OPEN_US = 100000;
+const uint32_t CLOSE_US = 300000;
+
+// 单次定时器的伪实现：只记录装定的到期时刻
+struct FakeTimer {
+    bool armed;
+    uint32_t dueUs;
+
+    FakeTimer() : armed(false), dueUs(0) {}
+
+    void arm(PulseScheduler<CHANNELS>& scheduler, uint32_t nowUs) {
+        uint32_t delay = 0;
+        armed = scheduler.nextDelay(nowUs, delay);
+        dueUs = nowUs + delay;
+    }
+};
+
+struct Ended {
+    int ch;
+    uint32_t atUs;
+};
+
+// 运行定时器循环直到没有活动脉冲，返回各通道的结束时刻
+std::vector<Ended> runTimerLoop(PulseScheduler<CHANNELS>& scheduler, FakeTimer& timer) {
+    std::vector<Ended> ended;
+    while (timer.armed) {
+        uint32_t now = timer.dueUs;     // 伪时钟直接跳到到期时刻
+        uint32_t expired = scheduler.expire(now);
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            if (expired & (1u << ch)) {
+                Ended e = {ch, now};
+                ended.push_back(e);
+            }
+        }
+        timer.arm(scheduler, now);
+    }
+    return ended;
+}
+
+// 帧记录：每个出口打开线圈位的上升/下降时刻
+struct CoilEdges {
+    uint64_t onUs[NUM_OUTLETS];
+    uint64_t offUs[NUM_OUTLETS];
+    int maxConcurrent;
+};
+CoilEdges coilEdges;
+
+void recordCoilFrame(void* context, const uint8_t* bytes, int length) {
+    int active = 0;
+    for (int i = 0; i < NUM_OUTLETS; i++) {
+        const OutletWiring& w = BOARD_OUTLET_WIRING_TABLE[i];
+        bool on = (bytes[w.coilByte] >> w.openBit) & 1;
+        if (on) {
+            active++;
+            if (coilEdges.onUs[i] == 0) coilEdges.onUs[i] = NativeHal::nowUs();
+        } else if (coilEdges.onUs[i] != 0 && coilEdges.offUs[i] == 0) {
+            coilEdges.offUs[i] = NativeHal::nowUs();
+        }
+    }
+    if (active > coilEdges.maxConcurrent) coilEdges.maxConcurrent = active;
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_idle_scheduler_has_no_deadline() {
+    PulseScheduler<CHANNELS> scheduler;
+    uint32_t delay = 123;
+    TEST_ASSERT_FALSE(scheduler.nextDelay(0, delay));
+    TEST_ASSERT_EQUAL_UINT32(0, delay);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.expire(0xFFFFFFFFu));
+}
+
+void test_staggered_pulses_end_at_start_plus_width() {
+    PulseScheduler<CHANNELS> scheduler;
+    FakeTimer timer;
+    uint32_t now = 1000;
+    // 4 个出口错峰 1.5ms 起动，开/关脉宽不同
+    for (int ch = 0; ch < 4; ch++) {
+        scheduler.start(ch, now + ch * 1500, (ch & 1) ? CLOSE_US : OPEN_US);
+    }
+    timer.arm(scheduler, now);
+    TEST_ASSERT_TRUE(timer.armed);
+    TEST_ASSERT_EQUAL_UINT32(now + OPEN_US, timer.dueUs);
+
+    std::vector<Ended> ended = runTimerLoop(scheduler, timer);
+    TEST_ASSERT_EQUAL_INT(4, (int)ended.size());
+    TEST_ASSERT_EQUAL_INT(0, ended[0].ch);
+    TEST_ASSERT_EQUAL_UINT32(now + OPEN_US, ended[0].atUs);
+    TEST_ASSERT_EQUAL_INT(2, ended[1].ch);
+    TEST_ASSERT_EQUAL_UINT32(now + 3000 + OPEN_US, ended[1].atUs);
+    TEST_ASSERT_EQUAL_INT(1, ended[2].ch);
+    TEST_ASSERT_EQUAL_UINT32(now + 1500 + CLOSE_US, ended[2].atUs);
+    TEST_ASSERT_EQUAL_INT(3, ended[3].ch);
+    TEST_ASSERT_EQUAL_UINT32(now + 4500 + CLOSE_US, ended[3].atUs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getActiveMask());
+}
+
+void test_pulse_discovered_late_keeps_its_deadline() {
+    // 脉冲在 t=0 起动，但控制任务 40ms 后才装定：截止时刻仍为 0 + 100ms
+    PulseScheduler<CHANNELS> scheduler;
+    scheduler.start(5, 0, OPEN_US);
+    uint32_t delay = 0;
+    TEST_ASSERT_TRUE(scheduler.nextDelay(40000, delay));
+    TEST_ASSERT_EQUAL_UINT32(OPEN_US - 40000, delay);
+
+    // 定时器迟到：已过期的脉冲延迟为 0，下一次到期时立即结束
+    TEST_ASSERT_TRUE(scheduler.nextDelay(OPEN_US + 700, delay));
+    TEST_ASSERT_EQUAL_UINT32(0, delay);
+    TEST_ASSERT_EQUAL_UINT32(1u << 5, scheduler.expire(OPEN_US + 700));
+}
+
+void test_expire_is_inclusive_and_leaves_later_channels() {
+    PulseScheduler<CHANNELS> scheduler;
+    scheduler.start(0, 0, 100);
+    scheduler.start(1, 0, 101);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.expire(99));
+    TEST_ASSERT_EQUAL_UINT32(0x1, scheduler.expire(100));
+    TEST_ASSERT_TRUE(scheduler.isActive(1));
+    TEST_ASSERT_EQUAL_UINT32(0x2, scheduler.expire(101));
+}
+
+void test_restart_and_cancel() {
+    PulseScheduler<CHANNELS> scheduler;
+    scheduler.start(2, 0, CLOSE_US);
+    scheduler.start(2, 50000, OPEN_US);     // 反向换向覆盖未结束的脉冲
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.expire(OPEN_US + 49999));
+    TEST_ASSERT_EQUAL_UINT32(1u << 2, scheduler.expire(OPEN_US + 50000));
+
+    scheduler.start(3, 0, OPEN_US);
+    scheduler.cancel(3);
+    uint32_t delay = 0;
+    TEST_ASSERT_FALSE(scheduler.nextDelay(0, delay));
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.expire(OPEN_US));
+}
+
+void test_deadlines_across_clock_wrap() {
+    // 起动时刻接近 2^32，截止时刻回绕到 0 之后
+    PulseScheduler<CHANNELS> scheduler;
+    FakeTimer timer;
+    uint32_t now = 0xFFFFFFFFu - 50000;
+    scheduler.start(0, now, OPEN_US);
+    scheduler.start(7, now + 20000, 10000);     // 回绕前结束
+    timer.arm(scheduler, now);
+    TEST_ASSERT_EQUAL_UINT32(30000, timer.dueUs - now);
+
+    // 回绕前，回绕后的截止时刻不能被当作已到期
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.expire(now + 29999));
+
+    std::vector<Ended> ended = runTimerLoop(scheduler, timer);
+    TEST_ASSERT_EQUAL_INT(2, (int)ended.size());
+    TEST_ASSERT_EQUAL_INT(7, ended[0].ch);
+    TEST_ASSERT_EQUAL_UINT32(now + 30000, ended[0].atUs);
+    TEST_ASSERT_EQUAL_INT(0, ended[1].ch);
+    TEST_ASSERT_EQUAL_UINT32(now + OPEN_US, ended[1].atUs);
+    TEST_ASSERT_TRUE(ended[1].atUs < now);      // 已回绕
+}
+
+void test_sorter_pulse_timer_ends_coils_on_virtual_clock() {
+    // 同时打开 6 个出口：逐个错峰起动，每个打开脉冲在帧上恰好持续 PULSE_OPEN_MS
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+    EEPROM.begin(512);
+    sorter.initialize();
+    memset(&coilEdges, 0, sizeof(coilEdges));
+    NativeHal::advanceUs(1000);
+    NativeHal::setFrameListener(recordCoilFrame, nullptr);
+
+    const int OPENED = 6;
+    for (int i = 0; i < OPENED; i++) sorter.setOutletState(i, true);
+    NativeHal::advanceUs(3 * PULSE_OPEN_MS * 1000u);     // 超出并发上限的出口在第一批脉冲结束后起动
+    NativeHal::setFrameListener(nullptr, nullptr);
+
+    for (int i = 0; i < OPENED; i++) {
+        TEST_ASSERT_TRUE(coilEdges.onUs[i] != 0);
+        TEST_ASSERT_EQUAL_UINT32(PULSE_OPEN_MS * 1000u, (uint32_t)(coilEdges.offUs[i] - coilEdges.onUs[i]));
+        TEST_ASSERT_TRUE(sorter.getOutlet(i)->isPositionOpen());
+    }
+    // 相邻两次起动至少错开 OUTLET_PULSE_STAGGER_US（起动顺序与出口号一致）
+    for (int i = 1; i < OPENED; i++) {
+        TEST_ASSERT_TRUE(coilEdges.onUs[i] >= coilEdges.onUs[i - 1] + OUTLET_PULSE_STAGGER_US);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_idle_scheduler_has_no_deadline);
+    RUN_TEST(test_staggered_pulses_end_at_start_plus_width);
+    RUN_TEST(test_pulse_discovered_late_keeps_its_deadline);
+    RUN_TEST(test_expire_is_inclusive_and_leaves_later_channels);
+    RUN_TEST(test_restart_and_cancel);
+    RUN_TEST(test_deadlines_across_clock_wrap);
+    RUN_TEST(test_sorter_pulse_timer_ends_coils_on_virtual_clock);
+    return UNITY_END();
+}
@@ -0,0 +1,247 @@
+// 编码器 A/B 解码：查表解码与旧版 A/B 分离中断处理的一致性、非法跳变计数，以及两者在合成边沿流上的耗时对比
+// 主机上的耗时只用于比较两种写法的相对开销；目标板上的每边沿周期数见 CPU Profiler (EncISR)
+
+#include <Arduino.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <chrono>
+#include <vector>
+#include "modular/encoder.h"
+#include "modular/quadrature_decoder.h"
+
+namespace {
+
+// 一个边沿：哪一相触发中断，以及此后两相的电平
+struct Edge {
+    uint8_t pin;    // 0 = A, 1 = B
+    uint8_t a;
+    uint8_t b;
+};
+
+// 正向格雷码 00 -> 01 -> 11 -> 10
+const uint8_t FORWARD_SEQUENCE[4] = {0x0, 0x1, 0x3, 0x2};
+
+// 合成边沿流：速度随机游走，偶尔反转（抖动），不含双相同时翻转
+std::vector<Edge> makeEdgeStream(int count, uint32_t seed, int reversePercent) {
+    std::vector<Edge> edges;
+    edges.reserve(count);
+    int index = 0;
+    uint8_t state = 0;
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int direction = ((int)((seed >> 16) % 100) < reversePercent) ? -1 : 1;
+        index = (index + direction + 4) & 3;
+        uint8_t next = FORWARD_SEQUENCE[index];
+        Edge e;
+        e.pin = ((next ^ state) & 0x2) ? 0 : 1;
+        e.a = (next >> 1) & 1;
+        e.b = next & 1;
+        edges.push_back(e);
+        state = next;
+    }
+    return edges;
+}
+
+// 相位回调：两种解码器共用，累加相位序列的校验和
+uint32_t phaseChecksum = 0;
+int phaseCallbacks = 0;
+void countPhase(void* context, int phase) {
+    phaseChecksum = phaseChecksum * 31u + (uint32_t)phase;
+    phaseCallbacks++;
+}
+
+typedef void (*PhaseCallback)(void* context, int phase);
+
+// 旧版：A/B 各自的中断分别读本相电平、按方向分支，并在每个边沿做两次取模
+struct LegacyDecoder {
+    volatile long rawEncoderCount;
+    int pinA_state;
+    int pinB_state;
+    int phaseOffset;
+    PhaseCallback callback;
+
+    LegacyDecoder() : rawEncoderCount(0), pinA_state(0), pinB_state(0), phaseOffset(0), callback(countPhase) {}
+
+    void triggerPhaseCallback() {
+        int raw = rawEncoderCount % ENCODER_MAX_PHASE;
+        if (raw < 0) raw += ENCODER_MAX_PHASE;
+        callback(nullptr, (raw + phaseOffset) % ENCODER_MAX_PHASE);
+    }
+
+    void onA(int A) {
+        if (A != pinA_state) {
+            int dN = (A == pinB_state) ? 1 : -1;
+            if (ENCODER_REVERSE_DIRECTION) rawEncoderCount -= dN; else rawEncoderCount += dN;
+            pinA_state = A;
+            triggerPhaseCallback();
+        }
+    }
+
+    void onB(int B) {
+        if (B != pinB_state) {
+            int dN = (pinA_state != B) ? 1 : -1;
+            if (ENCODER_REVERSE_DIRECTION) rawEncoderCount -= dN; else rawEncoderCount += dN;
+            pinB_state = B;
+            triggerPhaseCallback();
+        }
+    }
+};
+
+// 新版：共用中断，一次读入两相电平，查表步进，相位增量回绕（与 Encoder::handleABPhaseInterrupt 相同）
+struct TableDecoder {
+    volatile long rawEncoderCount;
+    uint8_t quadratureState;
+    int rawPhase;
+    int phaseOffset;
+    uint32_t illegalTransitions;
+    PhaseCallback callback;
+
+    TableDecoder()
+        : rawEncoderCount(0), quadratureState(0), rawPhase(0), phaseOffset(0), illegalTransitions(0),
+          callback(countPhase) {}
+
+    void onEdge(uint8_t state) {
+        int8_t step = QUADRATURE_TRANSITION_TABLE[(quadratureState << 2) | state];
+        quadratureState = state;
+        if (step == 0) return;
+        if (step == QUADRATURE_ILLEGAL) {
+            illegalTransitions++;
+            return;
+        }
+        rawEncoderCount += step;
+        rawPhase = wrapPhaseStep(rawPhase, step, ENCODER_MAX_PHASE);
+        int phase = rawPhase + phaseOffset;
+        if (phase >= ENCODER_MAX_PHASE) phase -= ENCODER_MAX_PHASE;
+        callback(nullptr, phase);
+    }
+};
+
+void runLegacy(LegacyDecoder& decoder, const std::vector<Edge>& edges) {
+    for (size_t i = 0; i < edges.size(); i++) {
+        const Edge& e = edges[i];
+        if (e.pin == 0) decoder.onA(e.a); else decoder.onB(e.b);
+    }
+}
+
+void runTable(TableDecoder& decoder, const std::vector<Edge>& edges) {
+    for (size_t i = 0; i < edges.size(); i++) {
+        const Edge& e = edges[i];
+        decoder.onEdge((e.a << 1) | e.b);
+    }
+}
+
+template <typename F>
+double nanosecondsPerEdge(F run, size_t edges, int repeats) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ((double)edges * repeats);
+}
+
+void driveEncoder(uint8_t state) {
+    NativeHal::setPinLevel(PIN_ENCODER_A, (state >> 1) & 1);
+    NativeHal::setPinLevel(PIN_ENCODER_B, state & 1);
+}
+
+int lastEncoderPhase = -1;
+void recordEncoderPhase(void* context, int phase) { lastEncoderPhase = phase; }
+
+} // namespace
+
+void setUp() {
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+    phaseChecksum = 0;
+    phaseCallbacks = 0;
+}
+
+void tearDown() {}
+
+void test_table_decoder_matches_legacy_on_jittered_stream() {
+    std::vector<Edge> edges = makeEdgeStream(20000, 7, 20);
+    LegacyDecoder legacy;
+    runLegacy(legacy, edges);
+    uint32_t legacyChecksum = phaseChecksum;
+    int legacyCallbacks = phaseCallbacks;
+
+    phaseChecksum = 0;
+    phaseCallbacks = 0;
+    TableDecoder table;
+    runTable(table, edges);
+
+    TEST_ASSERT_EQUAL_INT((int)edges.size(), phaseCallbacks);
+    TEST_ASSERT_EQUAL_INT(legacyCallbacks, phaseCallbacks);
+    TEST_ASSERT_EQUAL_UINT32(legacyChecksum, phaseChecksum);
+    TEST_ASSERT_EQUAL_INT((int)legacy.rawEncoderCount, (int)table.rawEncoderCount);
+    TEST_ASSERT_EQUAL_UINT32(0, table.illegalTransitions);
+}
+
+void test_double_flip_is_counted_not_stepped() {
+    TableDecoder table;
+    table.onEdge(0x1);
+    table.onEdge(0x2);  // 01 -> 10：两相同时翻转
+    table.onEdge(0x2);  // 无变化
+    TEST_ASSERT_EQUAL_INT(1, (int)table.rawEncoderCount);
+    TEST_ASSERT_EQUAL_UINT32(1, table.illegalTransitions);
+    TEST_ASSERT_EQUAL_INT(1, phaseCallbacks);
+}
+
+void test_phase_wraps_in_both_directions() {
+    TEST_ASSERT_EQUAL_INT(0, wrapPhaseStep(ENCODER_MAX_PHASE - 1, 1, ENCODER_MAX_PHASE));
+    TEST_ASSERT_EQUAL_INT(ENCODER_MAX_PHASE - 1, wrapPhaseStep(0, -1, ENCODER_MAX_PHASE));
+    TEST_ASSERT_EQUAL_INT(57, wrapPhaseStep(56, 1, ENCODER_MAX_PHASE));
+}
+
+void test_encoder_isr_decodes_pin_edges() {
+    Encoder* encoder = Encoder::getInstance();
+    encoder->initialize();
+    encoder->setPhaseCallback(nullptr, recordEncoderPhase);
+
+    // 正向 3 个完整周期 + 反向 2 步
+    int index = 0;
+    for (int i = 0; i < 12; i++) {
+        index = (index + 1) & 3;
+        driveEncoder(FORWARD_SEQUENCE[index]);
+    }
+    for (int i = 0; i < 2; i++) {
+        index = (index + 3) & 3;
+        driveEncoder(FORWARD_SEQUENCE[index]);
+    }
+    int expected = ENCODER_REVERSE_DIRECTION ? -10 : 10;
+    TEST_ASSERT_EQUAL_INT(expected, (int)encoder->getRawCount());
+    TEST_ASSERT_EQUAL_INT(encoder->getCurrentPosition(), lastEncoderPhase);
+    TEST_ASSERT_EQUAL_UINT32(0, encoder->getIllegalTransitionCount());
+
+    encoder->setPhaseCallback(nullptr, nullptr);
+}
+
+void test_benchmark_table_vs_legacy_decoder() {
+    const int EDGES = 1000000;
+    const int REPEATS = 5;
+    std::vector<Edge> edges = makeEdgeStream(EDGES, 11, 2);
+
+    LegacyDecoder legacy;
+    double legacyNs = nanosecondsPerEdge([&]() { runLegacy(legacy, edges); }, edges.size(), REPEATS);
+    uint32_t legacyChecksum = phaseChecksum;
+
+    phaseChecksum = 0;
+    phaseCallbacks = 0;
+    TableDecoder table;
+    double tableNs = nanosecondsPerEdge([&]() { runTable(table, edges); }, edges.size(), REPEATS);
+
+    TEST_ASSERT_EQUAL_UINT32(legacyChecksum, phaseChecksum);
+    char message[160];
+    snprintf(message, sizeof(message), "decoder ns/edge: legacy A/B %.2f, table %.2f (x%.2f), %d edges x %d",
+             legacyNs, tableNs, tableNs > 0 ? legacyNs / tableNs : 0.0, EDGES, REPEATS);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_table_decoder_matches_legacy_on_jittered_stream);
+    RUN_TEST(test_double_flip_is_counted_not_stepped);
+    RUN_TEST(test_phase_wraps_in_both_directions);
+    RUN_TEST(test_encoder_isr_decodes_pin_edges);
+    RUN_TEST(test_benchmark_table_vs_legacy_decoder);
+    return UNITY_END();
+}
@@ -0,0 +1,175 @@
+// 扫描窗口解码：位图按字并行解码与旧版逐点回放（每通道每相位 1 字节）的一致性，以及两者在合成窗口上的耗时对比
+// 主机上的耗时只用于比较两种写法的相对开销；目标板上的解码耗时见 CPU Profiler
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "modular/diameter_scanner.h"
+#include "modular/scan_decoder.h"
+
+namespace {
+
+const int CHANNELS = 4;
+const int MAX_SAMPLES = ScanFrame::MAX_SAMPLES;
+const int SAMPLE_WORDS = ScanFrame::SAMPLE_WORDS;
+
+// 一个扫描窗口的两种存储形式
+struct ScanWindow {
+    int sampleCount;
+    uint8_t samples[CHANNELS][MAX_SAMPLES];     // 旧版：每个采样点 1 字节
+    uint32_t bits[CHANNELS][SAMPLE_WORDS];      // 新版：每个采样点 1 位
+};
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// 合成窗口：每个通道 0-3 段随机长度的高电平，可能贴着窗口起点或延续到窗口末尾
+void makeWindow(ScanWindow& window, uint32_t& seed, int sampleCount) {
+    memset(&window, 0, sizeof(window));
+    window.sampleCount = sampleCount;
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        int runs = (int)(nextRandom(seed) % 4);
+        int pos = (int)(nextRandom(seed) % 8);
+        for (int r = 0; r < runs && pos < sampleCount; r++) {
+            int width = 1 + (int)(nextRandom(seed) % 70);
+            for (int i = pos; i < pos + width && i < sampleCount; i++) {
+                window.samples[ch][i] = 1;
+                window.bits[ch][i >> 5] |= 1u << (i & 31);
+            }
+            pos += width + 1 + (int)(nextRandom(seed) % 40);
+        }
+    }
+}
+
+// 旧版 getDiameterAndStop() 的逐点回放
+void legacyReplay(const ScanWindow& window, ScanChannelResult* results) {
+    bool passing[CHANNELS];
+    for (int i = 0; i < CHANNELS; i++) {
+        results[i].pulseWidth = 0;
+        results[i].objectCount = 0;
+        passing[i] = false;
+    }
+    for (int idx = 0; idx < window.sampleCount; idx++) {
+        for (int i = 0; i < CHANNELS; i++) {
+            bool currentState = (window.samples[i][idx] == 1);
+            if (currentState) {
+                if (!passing[i]) {
+                    passing[i] = true;
+                    results[i].pulseWidth = 0;
+                }
+                results[i].pulseWidth++;
+            } else if (passing[i]) {
+                passing[i] = false;
+                results[i].objectCount++;
+            }
+        }
+    }
+}
+
+void bitsetDecode(const ScanWindow& window, ScanChannelResult* results) {
+    for (int i = 0; i < CHANNELS; i++) {
+        results[i] = decodeChannelBits(window.bits[i], window.sampleCount);
+    }
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_bitset_matches_replay_on_random_windows() {
+    uint32_t seed = 0x9E3779B9u;
+    ScanWindow window;
+    for (int n = 0; n < 5000; n++) {
+        int sampleCount = 1 + (int)(nextRandom(seed) % MAX_SAMPLES);   // 含不足一个字与字边界处的窗口
+        makeWindow(window, seed, sampleCount);
+        ScanChannelResult expected[CHANNELS], actual[CHANNELS];
+        legacyReplay(window, expected);
+        bitsetDecode(window, actual);
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            TEST_ASSERT_EQUAL_INT(expected[ch].pulseWidth, actual[ch].pulseWidth);
+            TEST_ASSERT_EQUAL_INT(expected[ch].objectCount, actual[ch].objectCount);
+        }
+    }
+}
+
+void test_word_boundaries_and_window_end() {
+    ScanWindow window;
+    memset(&window, 0, sizeof(window));
+    window.sampleCount = 70;
+    // 通道 0：第 31-32 位跨字；通道 1：从第 64 位起高电平直到窗口结束；通道 2：第 0 位起
+    const int ranges[3][2] = {{31, 33}, {64, 70}, {0, 5}};
+    for (int ch = 0; ch < 3; ch++) {
+        for (int i = ranges[ch][0]; i < ranges[ch][1]; i++) {
+            window.samples[ch][i] = 1;
+            window.bits[ch][i >> 5] |= 1u << (i & 31);
+        }
+    }
+    ScanChannelResult r[CHANNELS];
+    bitsetDecode(window, r);
+    TEST_ASSERT_EQUAL_INT(2, r[0].pulseWidth);
+    TEST_ASSERT_EQUAL_INT(1, r[0].objectCount);
+    TEST_ASSERT_EQUAL_INT(6, r[1].pulseWidth);
+    TEST_ASSERT_EQUAL_INT(0, r[1].objectCount);     // 窗口结束时仍在遮挡：不计为通过
+    TEST_ASSERT_EQUAL_INT(5, r[2].pulseWidth);
+    TEST_ASSERT_EQUAL_INT(1, r[2].objectCount);
+    TEST_ASSERT_EQUAL_INT(0, r[3].pulseWidth);
+    TEST_ASSERT_EQUAL_INT(0, r[3].objectCount);
+}
+
+void test_benchmark_bitset_vs_replay_decode() {
+    const int WINDOWS = 256;
+    const int REPEATS = 200;
+    std::vector<ScanWindow> windows(WINDOWS);
+    uint32_t seed = 12345;
+    for (int n = 0; n < WINDOWS; n++) makeWindow(windows[n], seed, MAX_SAMPLES);
+
+    // 结果累加进校验和，避免解码被优化掉
+    uint32_t replaySum = 0, bitsetSum = 0;
+    ScanChannelResult r[CHANNELS];
+
+    auto start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < REPEATS; rep++) {
+        for (int n = 0; n < WINDOWS; n++) {
+            legacyReplay(windows[n], r);
+            for (int ch = 0; ch < CHANNELS; ch++) replaySum += r[ch].pulseWidth * 7u + r[ch].objectCount;
+        }
+    }
+    double replayNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < REPEATS; rep++) {
+        for (int n = 0; n < WINDOWS; n++) {
+            bitsetDecode(windows[n], r);
+            for (int ch = 0; ch < CHANNELS; ch++) bitsetSum += r[ch].pulseWidth * 7u + r[ch].objectCount;
+        }
+    }
+    double bitsetNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_ASSERT_EQUAL_UINT32(replaySum, bitsetSum);
+    double perWindowReplay = replayNs / ((double)WINDOWS * REPEATS);
+    double perWindowBitset = bitsetNs / ((double)WINDOWS * REPEATS);
+    char message[200];
+    snprintf(message, sizeof(message),
+             "scan decode ns/window (%d samples x %d ch): replay %.1f (%u B), bitset %.1f (%u B) (x%.1f)",
+             MAX_SAMPLES, CHANNELS, perWindowReplay, (unsigned)sizeof(((ScanWindow*)0)->samples),
+             perWindowBitset, (unsigned)sizeof(((ScanWindow*)0)->bits),
+             perWindowBitset > 0 ? perWindowReplay / perWindowBitset : 0.0);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bitset_matches_replay_on_random_windows);
+    RUN_TEST(test_word_boundaries_and_window_end);
+    RUN_TEST(test_benchmark_bitset_vs_replay_decode);
+    return UNITY_END();
+}
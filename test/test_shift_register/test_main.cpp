@@ -0,0 +1,150 @@
+// 74HC595 链驱动：位操作与 SPI 两种后端经 NativeHal 帧记录输出的帧必须与写入的帧一致、脏检查不产生总线活动，
+// 并比较两者每帧的刷新开销（GPIO 写入次数与主机上的调用耗时）
+// 主机上的耗时只用于比较驱动代码本身的相对开销；目标板上位操作的耗时由 GPIO 写入次数决定，实测值见串口报告的 HC595 行
+
+#include <Arduino.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "modular/shift_register_driver.h"
+
+namespace {
+
+const int CHAIN = SHIFT_REGISTER_CHAIN_LENGTH;
+typedef ShiftRegisterChain<CHAIN, BitBangShiftBus> BitBangChain;
+typedef ShiftRegisterChain<CHAIN, SpiShiftBus> SpiChain;
+typedef ShiftRegisterFrame<CHAIN> Frame;
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// 帧序列：约一半与上一帧相同（脉冲未变化时的刷新），其余翻转随机位
+std::vector<Frame> makeFrames(uint32_t seed, int count) {
+    std::vector<Frame> frames(count);
+    Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    for (int n = 0; n < count; n++) {
+        if (nextRandom(seed) & 1) {
+            frame.bytes[nextRandom(seed) % CHAIN] ^= (uint8_t)(1u << (nextRandom(seed) % 8));
+        }
+        frames[n] = frame;
+    }
+    return frames;
+}
+
+// 帧记录：按锁存顺序保存
+std::vector<Frame> recorded;
+
+void recordFrame(void* context, const uint8_t* bytes, int length) {
+    Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    memcpy(frame.bytes, bytes, (length < CHAIN) ? length : CHAIN);
+    recorded.push_back(frame);
+    TEST_ASSERT_EQUAL_INT(CHAIN, length);
+}
+
+template <typename Chain>
+void checkRecordedFrames(Chain& chain, const std::vector<Frame>& frames) {
+    recorded.clear();
+    NativeHal::setFrameListener(recordFrame, nullptr);
+    std::vector<Frame> expected;
+    for (size_t n = 0; n < frames.size(); n++) {
+        bool changed = expected.empty() || frames[n] != expected.back();
+        TEST_ASSERT_EQUAL(changed, chain.write(frames[n]));
+        if (changed) expected.push_back(frames[n]);
+    }
+    NativeHal::setFrameListener(nullptr, nullptr);
+
+    TEST_ASSERT_EQUAL_INT((int)expected.size(), (int)recorded.size());
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)expected.size(), chain.getFrameCount());
+    for (size_t n = 0; n < expected.size(); n++) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected[n].bytes, recorded[n].bytes, CHAIN);
+    }
+}
+
+struct FrameCost {
+    double hostNsPerFrame;
+    double pinWritesPerFrame;
+};
+
+// 每次都强制刷新，统计每帧的 GPIO 写入次数与主机耗时
+template <typename Chain>
+FrameCost measureFrameCost(Chain& chain, const std::vector<Frame>& frames, int repeats) {
+    uint32_t writesBefore = NativeHal::getPinWriteCount();
+    uint32_t latchesBefore = NativeHal::getLatchCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < repeats; rep++) {
+        for (size_t n = 0; n < frames.size(); n++) chain.forceUpdate(frames[n]);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double count = (double)frames.size() * repeats;
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)count, NativeHal::getLatchCount() - latchesBefore);
+
+    FrameCost cost;
+    cost.hostNsPerFrame = ns / count;
+    cost.pinWritesPerFrame = (NativeHal::getPinWriteCount() - writesBefore) / count;
+    return cost;
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+}
+
+void tearDown() {}
+
+void test_bitbang_frames_match_recorder() {
+    BitBangChain chain(PIN_HC595_DS, PIN_HC595_SHCP, PIN_HC595_STCP);
+    chain.initialize();
+    checkRecordedFrames(chain, makeFrames(0x1234567u, 2000));
+}
+
+void test_spi_frames_match_recorder() {
+    SpiChain chain(PIN_HC595_DS, PIN_HC595_SHCP, PIN_HC595_STCP);
+    chain.initialize();
+    checkRecordedFrames(chain, makeFrames(0x1234567u, 2000));
+}
+
+void test_benchmark_frame_update_cost() {
+    const int FRAMES = 1024;
+    const int REPEATS = 200;
+    std::vector<Frame> frames = makeFrames(0x9E3779B9u, FRAMES);
+
+    BitBangChain bitBang(PIN_HC595_DS, PIN_HC595_SHCP, PIN_HC595_STCP);
+    bitBang.initialize();
+    FrameCost bitBangCost = measureFrameCost(bitBang, frames, REPEATS);
+
+    SpiChain spi(PIN_HC595_DS, PIN_HC595_SHCP, PIN_HC595_STCP);
+    spi.initialize();
+    FrameCost spiCost = measureFrameCost(spi, frames, REPEATS);
+
+    // 位操作：每位 3 次 GPIO 写入 + 锁存脚拉低/拉高；SPI：不经 GPIO，由外设移位
+    TEST_ASSERT_EQUAL_INT(CHAIN * 8 * 3 + 2, (int)bitBangCost.pinWritesPerFrame);
+    TEST_ASSERT_EQUAL_INT(0, (int)spiCost.pinWritesPerFrame);
+
+    char message[200];
+    snprintf(message, sizeof(message),
+             "HC595 frame (%d bytes): bitbang %.0f GPIO writes, host %.1f ns; spi 0 GPIO writes, %.1f us on wire @ %d MHz, host %.1f ns",
+             CHAIN, bitBangCost.pinWritesPerFrame, bitBangCost.hostNsPerFrame,
+             CHAIN * 8 * 1000000.0 / SHIFT_REGISTER_SPI_CLOCK_HZ, SHIFT_REGISTER_SPI_CLOCK_HZ / 1000000,
+             spiCost.hostNsPerFrame);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bitbang_frames_match_recorder);
+    RUN_TEST(test_spi_frames_match_recorder);
+    RUN_TEST(test_benchmark_frame_update_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+// M/T 法速度估计：按合成速度曲线（匀速、匀加速、停转后重新起步）生成边沿时间戳，检查速度、加速度与停转判定
+
+#include <unity.h>
+#include <math.h>
+#include <stdint.h>
+#include "modular/speed_estimator.h"
+
+namespace {
+
+const uint32_t TICKS_PER_SECOND = 1000000;
+const int EDGES_PER_TRAY = 200;
+const uint32_t STALL_TICKS = 500000;
+const uint32_t UPDATE_PERIOD = 1000;    // 控制任务每 1ms 更新一次
+
+// 速度曲线：v(t) = v0 + a * t（托盘/秒），到 stopAt 后停止，restartAt 起以 v0 重新匀速
+struct Profile {
+    double v0;
+    double a;
+    double stopAt;
+    double restartAt;
+
+    Profile(double v0, double a) : v0(v0), a(a), stopAt(1e9), restartAt(1e9) {}
+
+    double velocity(double t) const {
+        if (t >= restartAt) return v0;
+        if (t >= stopAt) return 0.0;
+        return v0 + a * t;
+    }
+
+    // 第 k 个边沿的时刻（秒）
+    double edgeTime(long k, long edgesBeforeStop) const {
+        if (k > edgesBeforeStop) {
+            return restartAt + (double)(k - edgesBeforeStop - 1) / (v0 * EDGES_PER_TRAY);
+        }
+        double x = (double)k / EDGES_PER_TRAY;  // 托盘数
+        if (a == 0.0) return x / v0;
+        return (-v0 + sqrt(v0 * v0 + 2.0 * a * x)) / a;
+    }
+
+    long edgesUntil(double t) const {
+        double trays = (a == 0.0) ? v0 * t : v0 * t + 0.5 * a * t * t;
+        return (long)floor(trays * EDGES_PER_TRAY);
+    }
+};
+
+struct Run {
+    SpeedEstimator estimator;
+    Profile profile;
+    long nextEdge;
+    long edgesBeforeStop;
+    uint32_t now;
+
+    explicit Run(const Profile& p)
+        : estimator(TICKS_PER_SECOND, EDGES_PER_TRAY, STALL_TICKS), profile(p), nextEdge(1), now(0) {
+        edgesBeforeStop = (p.stopAt < 1e9) ? p.edgesUntil(p.stopAt) : 0x7FFFFFFF;
+    }
+
+    // 推进到 untilTicks，期间按时间先后注入边沿，并以固定周期调用 update()
+    void advance(uint32_t untilTicks) {
+        while (now < untilTicks) {
+            now += UPDATE_PERIOD;
+            for (;;) {
+                double t = profile.edgeTime(nextEdge, edgesBeforeStop);
+                uint32_t ticks = (uint32_t)(t * TICKS_PER_SECOND + 0.5);
+                if (ticks > now) break;
+                estimator.recordEdge(ticks, 1);
+                nextEdge++;
+            }
+            estimator.update(now);
+        }
+    }
+
+    double trueVelocity() const { return profile.velocity((double)now / TICKS_PER_SECOND); }
+};
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_constant_speed() {
+    Run run(Profile(2.0, 0.0));   // 400 边沿/秒，周期 2500 tick
+    run.advance(20000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 2.0, run.estimator.getVelocity());
+    run.advance(2000000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 2.0, run.estimator.getVelocity());
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 0.0, run.estimator.getAcceleration());
+    TEST_ASSERT_EQUAL_UINT32(2500, run.estimator.getLastPeriodTicks());
+    TEST_ASSERT_FALSE(run.estimator.isStalled());
+}
+
+void test_ramp_tracks_velocity_and_acceleration() {
+    Run run(Profile(0.5, 1.25));  // 2 秒内从 0.5 加速到 3 托盘/秒
+    double worstError = 0.0;
+    for (uint32_t t = 100000; t <= 2000000; t += 50000) {
+        run.advance(t);
+        double error = fabs(run.estimator.getVelocity() - run.trueVelocity());
+        if (error > worstError) worstError = error;
+    }
+    // 误差来自最近一次更新以来的滞后（<= 1 个边沿周期加 1ms）
+    TEST_ASSERT_FLOAT_WITHIN(0.02, 0.0, worstError);
+    TEST_ASSERT_FLOAT_WITHIN(0.25, 1.25, run.estimator.getAcceleration());
+}
+
+void test_stall_decays_to_zero_and_restart_skips_the_stall_gap() {
+    Profile profile(1.0, 0.0);
+    profile.stopAt = 1.0;
+    profile.restartAt = 2.5;
+    Run run(profile);
+
+    run.advance(1000000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.0, run.estimator.getVelocity());
+
+    // 停止后 100ms：速度被 "1 个边沿 / 距最后边沿时间" 限制在 0.05 以下
+    run.advance(1100000);
+    TEST_ASSERT_LESS_OR_EQUAL(0.051, run.estimator.getVelocity());
+    TEST_ASSERT_FALSE(run.estimator.isStalled());
+
+    run.advance(1600000);
+    TEST_ASSERT_TRUE(run.estimator.isStalled());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.0, run.estimator.getAcceleration());
+
+    // 重新起步的第一个边沿：前一个边沿在停转之前，周期未知
+    run.advance(2500000 + UPDATE_PERIOD);
+    TEST_ASSERT_EQUAL_UINT32(0, run.estimator.getLastPeriodTicks());
+    // 跨越停转的批次不输出速度（不会出现接近 0 的假速度或假加速度）
+    TEST_ASSERT_TRUE(run.estimator.isStalled());
+
+    run.advance(2520000);
+    TEST_ASSERT_EQUAL_UINT32(5000, run.estimator.getLastPeriodTicks());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.0, run.estimator.getVelocity());
+}
+
+void test_first_edge_after_reset_has_unknown_period() {
+    SpeedEstimator estimator(TICKS_PER_SECOND, EDGES_PER_TRAY, STALL_TICKS);
+    estimator.update(1000);                 // 尚无边沿：不建立参考点
+    estimator.recordEdge(3000000, 1);       // 上电 3 秒后的第一个边沿
+    TEST_ASSERT_EQUAL_UINT32(0, estimator.getLastPeriodTicks());
+    estimator.update(3000500);              // 参考点 = 第一个边沿
+    TEST_ASSERT_TRUE(estimator.isStalled());
+
+    estimator.recordEdge(3002500, 1);
+    estimator.recordEdge(3005000, 1);
+    TEST_ASSERT_EQUAL_UINT32(2500, estimator.getLastPeriodTicks());
+    estimator.update(3005500);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 2.0, estimator.getVelocity());
+}
+
+void test_reverse_motion_is_signed() {
+    SpeedEstimator estimator(TICKS_PER_SECOND, EDGES_PER_TRAY, STALL_TICKS);
+    uint32_t t = 0;
+    for (int i = 0; i < 50; i++) {
+        t += 2500;
+        estimator.recordEdge(t, -1);
+        estimator.update(t + 100);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.001, -2.0, estimator.getVelocity());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_constant_speed);
+    RUN_TEST(test_ramp_tracks_velocity_and_acceleration);
+    RUN_TEST(test_stall_decays_to_zero_and_restart_skips_the_stall_gap);
+    RUN_TEST(test_first_edge_after_reset_has_unknown_period);
+    RUN_TEST(test_reverse_motion_is_signed);
+    return UNITY_END();
+}
@@ -0,0 +1,138 @@
+// 亚相位直径测量：已知直径的合成圆棒（0.1mm 步进）按恒定带速经过扫描窗口，传感器跳变在相位之间的任意时刻发生；
+// 经跳变中断时间戳插值（interpolateSubPhase / finePulseWidth）得到的直径误差必须远小于一个相位的量化步长（约 0.5mm），
+// 同时报告只按整相位计数得到的直径误差作为对照
+
+#include <Arduino.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "modular/diameter_scanner.h"
+#include "modular/speed_estimator.h"
+
+namespace {
+
+const int SCANNER_PINS[4] = {PIN_SCANNER_1, PIN_SCANNER_2, PIN_SCANNER_3, PIN_SCANNER_4};
+const int MIN_ROD_DECI_MM = 60;
+const int MAX_ROD_DECI_MM = 300;
+// 一个相位对应的直径（0.1mm），即只按整相位计数时的量化步长
+const float PHASE_STEP_DECI_MM = SCANNER_WEIGHTS[0] * 10.0f;
+
+struct RodError {
+    int maxFine;        // 插值后的最大绝对误差 (0.1mm)
+    int maxCoarse;      // 整相位计数的最大绝对误差 (0.1mm)
+    long sumFine;
+    long sumCoarse;
+    int rods;
+};
+
+// 与 Sorter::onPhaseChange 相同的顺序：编码器边沿 -> 采样 -> 扫描起始 / 锁存事件
+void encoderEdge(DiameterScanner* scanner, SpeedEstimator& clock, uint64_t edgeUs, int phase) {
+    NativeHal::advanceTo(edgeUs);
+    clock.recordEdge((uint32_t)edgeUs, 1);
+    scanner->sample(phase);
+    if (phase == PHASE_SCAN_START) scanner->start();
+    if (phase == PHASE_DATA_LATCH) scanner->latch();
+}
+
+/**
+ * 一个托盘周期：直径为 deciMm 的圆棒居中于扫描窗口并偏移 offsetPhases，4 个通道都被遮挡
+ * @return 解码后的融合直径 (0.1mm)，coarse 返回整相位计数换算的直径
+ */
+int scanRod(DiameterScanner* scanner, SpeedEstimator& clock, uint64_t& cycleStartUs, uint32_t periodUs,
+            int deciMm, float offsetPhases, int& coarse) {
+    float width = deciMm / 10.0f / SCANNER_WEIGHTS[0];
+    float center = (PHASE_SCAN_START + PHASE_DATA_LATCH) / 2.0f + offsetPhases;
+    uint64_t riseUs = cycleStartUs + (uint64_t)((center - width / 2.0f) * periodUs + 0.5f);
+    uint64_t fallUs = cycleStartUs + (uint64_t)((center + width / 2.0f) * periodUs + 0.5f);
+
+    bool risen = false, fallen = false;
+    for (int p = 1; p <= ENCODER_MAX_PHASE; p++) {
+        uint64_t edgeUs = cycleStartUs + (uint64_t)p * periodUs;
+        if (!risen && riseUs < edgeUs) {
+            NativeHal::advanceTo(riseUs);
+            for (int ch = 0; ch < 4; ch++) NativeHal::setPinLevel(SCANNER_PINS[ch], HIGH);
+            risen = true;
+        }
+        if (!fallen && fallUs < edgeUs) {
+            NativeHal::advanceTo(fallUs);
+            for (int ch = 0; ch < 4; ch++) NativeHal::setPinLevel(SCANNER_PINS[ch], LOW);
+            fallen = true;
+        }
+        encoderEdge(scanner, clock, edgeUs, p % ENCODER_MAX_PHASE);
+    }
+    cycleStartUs += (uint64_t)ENCODER_MAX_PHASE * periodUs;
+
+    uint32_t sequence = scanner->getLatchCount() - 1;
+    TEST_ASSERT_TRUE(scanner->decodeFrame(sequence));
+    TEST_ASSERT_EQUAL_INT(1, scanner->getObjectCount(0));
+    coarse = (int)(scanner->getHighLevelPulseCount(0) * PHASE_STEP_DECI_MM + 0.5f);
+    return scanner->getDiameterDeciMm();
+}
+
+RodError sweepRods(uint32_t periodUs) {
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+    DiameterScanner* scanner = DiameterScanner::getInstance();
+    scanner->initialize();
+    SpeedEstimator clock(1000000, ENCODER_MAX_PHASE, 1000000);
+    scanner->setEdgeClock(&clock);
+
+    RodError result = {0, 0, 0, 0, 0};
+    uint64_t cycleStartUs = 1000;
+    int coarse = 0;
+    scanRod(scanner, clock, cycleStartUs, periodUs, 100, 0.0f, coarse);    // 预热：建立编码器周期
+    for (int d = MIN_ROD_DECI_MM; d <= MAX_ROD_DECI_MM; d++) {
+        // 圆棒相对相位网格的位置逐根变化，覆盖跳变落在相位内任意小数位置的情况
+        float offset = (float)((d * 37) % 100) / 100.0f;
+        int measured = scanRod(scanner, clock, cycleStartUs, periodUs, d, offset, coarse);
+        int fineError = abs(measured - d);
+        int coarseError = abs(coarse - d);
+        if (fineError > result.maxFine) result.maxFine = fineError;
+        if (coarseError > result.maxCoarse) result.maxCoarse = coarseError;
+        result.sumFine += fineError;
+        result.sumCoarse += coarseError;
+        result.rods++;
+    }
+    scanner->setEdgeClock(nullptr);
+    return result;
+}
+
+void checkSweep(float traysPerSecond) {
+    uint32_t periodUs = (uint32_t)(1e6f / traysPerSecond / ENCODER_MAX_PHASE + 0.5f);
+    RodError e = sweepRods(periodUs);
+
+    char message[200];
+    snprintf(message, sizeof(message),
+             "%.1f trays/s, %d rods %.1f-%.1f mm: sub-phase max %.1f mm mean %.2f mm | whole-phase max %.1f mm mean %.2f mm",
+             traysPerSecond, e.rods, MIN_ROD_DECI_MM / 10.0f, MAX_ROD_DECI_MM / 10.0f,
+             e.maxFine / 10.0f, e.sumFine / 10.0f / e.rods, e.maxCoarse / 10.0f, e.sumCoarse / 10.0f / e.rods);
+    TEST_MESSAGE(message);
+
+    // 0.1mm 分辨率：误差只来自取整到 0.1mm（插值精度 1/256 相位，约 0.002mm）
+    TEST_ASSERT_LESS_OR_EQUAL(1, e.maxFine);
+    TEST_ASSERT_TRUE(e.maxFine * 4 < PHASE_STEP_DECI_MM);
+    // 对照：整相位计数的误差达到量化步长的量级，说明上面的断言确实区分了两种方法
+    TEST_ASSERT_GREATER_OR_EQUAL((int)(PHASE_STEP_DECI_MM / 2), e.maxCoarse);
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_rod_sweep_at_1_tray_per_second() {
+    checkSweep(1.0f);
+}
+
+void test_rod_sweep_at_2_3_trays_per_second() {
+    checkSweep(2.3f);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rod_sweep_at_1_tray_per_second);
+    RUN_TEST(test_rod_sweep_at_2_3_trays_per_second);
+    return UNITY_END();
+}
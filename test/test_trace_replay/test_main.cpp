@@ -0,0 +1,144 @@
+// 事件追踪回放回归：trace_fixture.log 为 Sorter::dumpTrace() 的一份实录
+// （传送带仿真 1 托盘/秒、8 个托盘：program --start 1 --max 1 --trays 8 --dump-trace，只保留 [TRACE] 行），
+// 锁定 BEGIN / CONFIG / OUTLET / TRAY / D / END 导出格式与 8 字节记录布局，并检查回放能逐条复现其中的判定
+// 改动判定逻辑后若本测试失败，需确认行为变化是有意的，再用上面的命令重新导出夹具
+
+#include <Arduino.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "host/trace_replay.h"
+
+Sorter sorter;
+
+namespace {
+
+// PlatformIO 在工程根目录下运行测试程序
+const char* FIXTURE_PATH = "test/test_trace_replay/trace_fixture.log";
+
+const int FIXTURE_RECORDS = 2523;
+const int FIXTURE_LATCHES = 12;
+const int FIXTURE_PULSE_INTERVALS = 6;
+
+TraceDump loadFixture() {
+    TraceDump dump;
+    TEST_ASSERT_TRUE_MESSAGE(dump.load(FIXTURE_PATH), "cannot load trace fixture");
+    return dump;
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::setSerialEcho(false);
+}
+
+void tearDown() {}
+
+void test_record_layout() {
+    // 导出的每条记录为 16 个十六进制字符 "ttttttttTTAAaaaa"，与内存中的 8 字节布局一一对应
+    TEST_ASSERT_EQUAL_INT(8, (int)sizeof(TraceRecord));
+    TEST_ASSERT_EQUAL_INT(0, (int)offsetof(TraceRecord, timestampUs));
+    TEST_ASSERT_EQUAL_INT(4, (int)offsetof(TraceRecord, type));
+    TEST_ASSERT_EQUAL_INT(5, (int)offsetof(TraceRecord, arg8));
+    TEST_ASSERT_EQUAL_INT(6, (int)offsetof(TraceRecord, arg16));
+
+    // 记录类型的编号是导出格式的一部分
+    TEST_ASSERT_EQUAL_INT(1, TRACE_PHASE);
+    TEST_ASSERT_EQUAL_INT(2, TRACE_ZERO);
+    TEST_ASSERT_EQUAL_INT(3, TRACE_SENSOR);
+    TEST_ASSERT_EQUAL_INT(4, TRACE_LATCH);
+    TEST_ASSERT_EQUAL_INT(5, TRACE_LATCH_INFO);
+    TEST_ASSERT_EQUAL_INT(6, TRACE_PULSE);
+    TEST_ASSERT_EQUAL_INT(7, TRACE_FRAME);
+}
+
+void test_fixture_header_and_config() {
+    TraceDump dump = loadFixture();
+    TEST_ASSERT_EQUAL_INT(0, dump.phaseOffset);
+    TEST_ASSERT_EQUAL_INT(1, dump.outlet0Mode);
+    // OUTLET 1 min=20 max=255 len=0，OUTLET 7 min=8 max=10 len=0
+    TEST_ASSERT_EQUAL_INT(20, dump.outletMin[1]);
+    TEST_ASSERT_EQUAL_INT(255, dump.outletMax[1]);
+    TEST_ASSERT_EQUAL_INT(LEN_NONE, dump.outletLength[1]);
+    TEST_ASSERT_EQUAL_INT(8, dump.outletMin[7]);
+    TEST_ASSERT_EQUAL_INT(10, dump.outletMax[7]);
+    // TRAY 0 d=187 n=4 len=4 occ=1 conf=100 flags=0 outlet=2
+    TEST_ASSERT_EQUAL_UINT16(187, dump.trays[0].diameterDeciMm);
+    TEST_ASSERT_EQUAL_UINT8(4, dump.trays[0].scanCount);
+    TEST_ASSERT_EQUAL_UINT8(LEN_L, dump.trays[0].lengthLevel);
+    TEST_ASSERT_EQUAL_UINT8(1, dump.trays[0].occupied);
+    TEST_ASSERT_EQUAL_UINT8(100, dump.trays[0].confidence);
+    TEST_ASSERT_EQUAL_UINT8(0, dump.trays[0].flags);
+    TEST_ASSERT_EQUAL_UINT8(2, dump.trays[0].outlet);
+}
+
+void test_fixture_records_decode() {
+    TraceDump dump = loadFixture();
+    // BEGIN v1 total=2523 kept=2523：所有 D 行的记录都被解析
+    TEST_ASSERT_EQUAL_INT(FIXTURE_RECORDS, (int)dump.records.size());
+
+    // 第 1 条 0000000007000000：上电时的 74HC595 全零帧
+    TEST_ASSERT_EQUAL_UINT32(0, dump.records[0].timestampUs);
+    TEST_ASSERT_EQUAL_UINT8(TRACE_FRAME, dump.records[0].type);
+    TEST_ASSERT_EQUAL_UINT8(0, dump.records[0].arg8);
+    TEST_ASSERT_EQUAL_UINT16(0, dump.records[0].arg16);
+    // 第 2 条 0000138801000001：5ms 时到达相位 1
+    TEST_ASSERT_EQUAL_UINT32(5000, dump.records[1].timestampUs);
+    TEST_ASSERT_EQUAL_UINT8(TRACE_PHASE, dump.records[1].type);
+    TEST_ASSERT_EQUAL_UINT16(1, dump.records[1].arg16);
+
+    // 第一个锁存 000cf86404050082：13.0mm 分到出口 5
+    int latches = 0;
+    const TraceRecord* firstLatch = nullptr;
+    for (size_t i = 0; i < dump.records.size(); i++) {
+        if (dump.records[i].type != TRACE_LATCH) continue;
+        if (firstLatch == nullptr) firstLatch = &dump.records[i];
+        latches++;
+    }
+    TEST_ASSERT_EQUAL_INT(FIXTURE_LATCHES, latches);
+    TEST_ASSERT_NOT_NULL(firstLatch);
+    TEST_ASSERT_EQUAL_UINT32(0x000cf864, firstLatch->timestampUs);
+    TEST_ASSERT_EQUAL_UINT8(5, firstLatch->arg8);
+    TEST_ASSERT_EQUAL_UINT16(130, firstLatch->arg16);
+}
+
+void test_replay_reproduces_fixture_decisions() {
+    TraceDump dump = loadFixture();
+    TraceReplay replay(&sorter, &dump);
+    const ReplayResult& result = replay.run();
+
+    TEST_ASSERT_EQUAL_INT(FIXTURE_LATCHES, result.recordedLatches);
+    TEST_ASSERT_EQUAL_INT(FIXTURE_LATCHES, result.replayedLatches);
+    TEST_ASSERT_EQUAL_INT(FIXTURE_LATCHES, result.comparedLatches);
+    TEST_ASSERT_EQUAL_INT(0, result.latchMismatches);
+    TEST_ASSERT_EQUAL_INT(FIXTURE_PULSE_INTERVALS, result.comparedPulseIntervals);
+    TEST_ASSERT_EQUAL_INT(0, result.pulseMismatches);
+    TEST_ASSERT_TRUE(result.passed());
+}
+
+void test_replay_detects_changed_decision() {
+    // 改写追踪中最后一个锁存的目标出口：回放重新做出的判定与之不同，必须被报告
+    TraceDump dump = loadFixture();
+    for (size_t i = dump.records.size(); i-- > 0;) {
+        if (dump.records[i].type != TRACE_LATCH) continue;
+        dump.records[i].arg8 = (uint8_t)((dump.records[i].arg8 + 1) % NUM_OUTLETS);
+        break;
+    }
+    TraceReplay replay(&sorter, &dump);
+    const ReplayResult& result = replay.run();
+
+    TEST_ASSERT_EQUAL_INT(FIXTURE_LATCHES, result.comparedLatches);
+    TEST_ASSERT_EQUAL_INT(1, result.latchMismatches);
+    TEST_ASSERT_FALSE(result.passed());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_record_layout);
+    RUN_TEST(test_fixture_header_and_config);
+    RUN_TEST(test_fixture_records_decode);
+    RUN_TEST(test_replay_reproduces_fixture_decisions);
+    RUN_TEST(test_replay_detects_changed_decision);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+// 托盘记录的 EEPROM 编码：packTrayRecord / unpackTrayRecord 的逐字节布局与往返一致性，
+// 与旧版按内存布局 EEPROM.put 写入的快照兼容，以及 TraySystem::saveToEEPROM / loadFromEEPROM 的整队列还原
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdint.h>
+#include <string.h>
+#include "modular/tray_system.h"
+
+namespace {
+
+const int START_ADDR = EEPROM_ADDR_TRAY_DATA;
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+TrayRecord randomRecord(uint32_t& seed) {
+    TrayRecord r;
+    r.diameterDeciMm = (uint16_t)nextRandom(seed);
+    r.scanCount = nextRandom(seed) & 0x0F;
+    r.lengthLevel = nextRandom(seed) & 0x07;
+    r.occupied = nextRandom(seed) & 0x01;
+    r.confidence = (uint8_t)nextRandom(seed);
+    r.flags = (uint8_t)nextRandom(seed);
+    r.outlet = (uint8_t)nextRandom(seed);
+    return r;
+}
+
+void checkSameRecord(const TrayRecord& expected, const TrayRecord& actual) {
+    TEST_ASSERT_EQUAL_UINT16(expected.diameterDeciMm, actual.diameterDeciMm);
+    TEST_ASSERT_EQUAL_UINT8(expected.scanCount, actual.scanCount);
+    TEST_ASSERT_EQUAL_UINT8(expected.lengthLevel, actual.lengthLevel);
+    TEST_ASSERT_EQUAL_UINT8(expected.occupied, actual.occupied);
+    TEST_ASSERT_EQUAL_UINT8(expected.confidence, actual.confidence);
+    TEST_ASSERT_EQUAL_UINT8(expected.flags, actual.flags);
+    TEST_ASSERT_EQUAL_UINT8(expected.outlet, actual.outlet);
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::reset();
+    NativeHal::setSerialEcho(false);
+    EEPROM.begin(512);
+}
+
+void tearDown() {}
+
+void test_byte_layout() {
+    TrayRecord r;
+    r.diameterDeciMm = 0x1234;
+    r.scanCount = 15;
+    r.lengthLevel = LEN_L;
+    r.occupied = 1;
+    r.confidence = 87;
+    r.flags = TRAY_FLAG_LOW_CONFIDENCE | TRAY_FLAG_OVERRIDDEN;
+    r.outlet = 6;
+
+    uint8_t bytes[TRAY_RECORD_BYTES];
+    packTrayRecord(r, bytes);
+    const uint8_t expected[TRAY_RECORD_BYTES] = {0x34, 0x12, 0x0F | (LEN_L << 4) | 0x80, 87, 0x09, 6};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, bytes, TRAY_RECORD_BYTES);
+
+    // 空托盘
+    packTrayRecord(TrayRecord(), bytes);
+    const uint8_t empty[TRAY_RECORD_BYTES] = {0, 0, 0, 0, 0, TRAY_NO_OUTLET};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(empty, bytes, TRAY_RECORD_BYTES);
+}
+
+void test_round_trip() {
+    uint32_t seed = 0x6C8E9CF5u;
+    for (int n = 0; n < 10000; n++) {
+        TrayRecord r = randomRecord(seed);
+        uint8_t bytes[TRAY_RECORD_BYTES];
+        packTrayRecord(r, bytes);
+        checkSameRecord(r, unpackTrayRecord(bytes));
+    }
+
+    // 6 个字节的每一位都有含义：任意字节序列解码再编码不变（第 2 字节穷举）
+    for (int packed = 0; packed < 256; packed++) {
+        const uint8_t bytes[TRAY_RECORD_BYTES] = {0xA5, 0x5A, (uint8_t)packed, 0x33, 0xC3, 0x07};
+        uint8_t again[TRAY_RECORD_BYTES];
+        packTrayRecord(unpackTrayRecord(bytes), again);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(bytes, again, TRAY_RECORD_BYTES);
+    }
+}
+
+void test_matches_legacy_put_layout() {
+    // 旧版以 EEPROM.put 直接写入结构体；GCC 小端目标（ESP32 / x86）上位域从低位起分配，
+    // 逐字节编码与之相同，升级前保存的快照内容仍按原义解码
+    uint32_t seed = 0x1F123BB5u;
+    for (int n = 0; n < 1000; n++) {
+        TrayRecord r = randomRecord(seed);
+        uint8_t legacy[sizeof(TrayRecord)];
+        memcpy(legacy, &r, sizeof(r));
+        uint8_t bytes[TRAY_RECORD_BYTES];
+        packTrayRecord(r, bytes);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(legacy, bytes, TRAY_RECORD_BYTES);
+    }
+}
+
+void test_save_and_load_restore_queue() {
+    TraySystem* traySystem = TraySystem::getInstance();
+    traySystem->resetAllTraysData();
+
+    // 队列前半为有物托盘，后半保持为空（reset 之后未推入）
+    const int FILLED = TRAY_QUEUE_POSITIONS / 2;
+    uint32_t seed = 0x2545F491u;
+    TrayRecord saved[TRAY_QUEUE_POSITIONS];
+    for (int n = 0; n < FILLED; n++) {
+        TrayRecord r = randomRecord(seed);
+        r.occupied = 1;
+        r.flags &= (uint8_t)~TRAY_FLAG_RESTORED;
+        traySystem->pushTray(r);
+    }
+    for (int k = 0; k < TRAY_QUEUE_POSITIONS; k++) saved[k] = traySystem->getTray(k);
+    traySystem->saveToEEPROM(START_ADDR);
+
+    // 位置 0 紧跟在标记字节之后
+    uint8_t bytes[TRAY_RECORD_BYTES];
+    packTrayRecord(saved[0], bytes);
+    for (int b = 0; b < TRAY_RECORD_BYTES; b++) {
+        TEST_ASSERT_EQUAL_HEX8(bytes[b], EEPROM.read(START_ADDR + 1 + b));
+    }
+
+    traySystem->resetAllTraysData();
+    TEST_ASSERT_FALSE(traySystem->getTray(0).occupied);
+    traySystem->loadFromEEPROM(START_ADDR);
+
+    for (int k = 0; k < TRAY_QUEUE_POSITIONS; k++) {
+        TrayRecord expected = saved[k];
+        if (k < FILLED) expected.flags |= TRAY_FLAG_RESTORED;
+        checkSameRecord(expected, traySystem->getTray(k));
+    }
+}
+
+void test_load_ignores_missing_snapshot() {
+    TraySystem* traySystem = TraySystem::getInstance();
+    traySystem->resetAllTraysData();
+    traySystem->pushTray(TraySystem::makeRecord(150, 1, LEN_M, 90, 0));
+
+    // EEPROM 为出厂状态 (0xFF)：标记不符，队列不变
+    traySystem->loadFromEEPROM(START_ADDR);
+    TEST_ASSERT_EQUAL_UINT16(150, traySystem->getTray(0).diameterDeciMm);
+    TEST_ASSERT_FALSE(traySystem->getTray(0).flags & TRAY_FLAG_RESTORED);
+    TEST_ASSERT_FALSE(traySystem->getTray(1).occupied);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_byte_layout);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_matches_legacy_put_layout);
+    RUN_TEST(test_save_and_load_restore_queue);
+    RUN_TEST(test_load_ignores_missing_snapshot);
+    return UNITY_END();
+}
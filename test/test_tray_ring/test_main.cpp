@@ -0,0 +1,159 @@
+// 托盘环形队列：按托盘序号寻址的位置查询、越过 2 的幂容量的回绕、O(1) reset()，
+// 以及超出配置位置数或早于最近一次 reset() 的托盘读作空托盘
+
+#include <unity.h>
+#include <stdint.h>
+#include "config.h"
+#include "modular/tray_ring.h"
+
+namespace {
+
+// 非 2 的幂的位置数：容量取 8，位置 5-7 的槽位存在但不可读
+const int POSITIONS = 5;
+typedef TrayRing<int, POSITIONS> Ring;
+
+void pushSequence(Ring& ring, int first, int count) {
+    for (int n = 0; n < count; n++) ring.push(first + n);
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_capacity_is_next_power_of_two() {
+    TEST_ASSERT_EQUAL_UINT32(8, Ring::CAPACITY);
+    TEST_ASSERT_EQUAL_UINT32(7, Ring::MASK);
+    TEST_ASSERT_EQUAL_UINT32(1, trayRingCapacity(1));
+    TEST_ASSERT_EQUAL_UINT32(16, trayRingCapacity(16));
+    TEST_ASSERT_EQUAL_UINT32(32, trayRingCapacity(17));
+    TEST_ASSERT_TRUE(TRAY_QUEUE_POSITIONS >= 19);
+    TEST_ASSERT_TRUE((TrayRing<int, TRAY_QUEUE_POSITIONS>::CAPACITY) >= (uint32_t)TRAY_QUEUE_POSITIONS);
+}
+
+void test_empty_ring_reads_default_records() {
+    Ring ring;
+    for (int k = -1; k <= POSITIONS; k++) {
+        TEST_ASSERT_FALSE(ring.isValid(k));
+        TEST_ASSERT_EQUAL_INT(0, ring.at(k));
+        TEST_ASSERT_NULL(ring.find(k));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getHead());
+}
+
+void test_positions_fill_from_scan_position() {
+    Ring ring;
+    pushSequence(ring, 100, 3);
+    // 位置 0 为最新推入的托盘
+    TEST_ASSERT_EQUAL_INT(102, ring.at(0));
+    TEST_ASSERT_EQUAL_INT(101, ring.at(1));
+    TEST_ASSERT_EQUAL_INT(100, ring.at(2));
+    // 尚未推入到的位置为空
+    TEST_ASSERT_FALSE(ring.isValid(3));
+    TEST_ASSERT_EQUAL_INT(0, ring.at(3));
+}
+
+void test_wraparound_past_capacity() {
+    // 推入 CAPACITY 的数倍再加零头，槽位下标多次回绕
+    Ring ring;
+    const int PUSHED = 3 * (int)Ring::CAPACITY + 3;
+    pushSequence(ring, 1, PUSHED);
+    TEST_ASSERT_EQUAL_UINT32(PUSHED, ring.getHead());
+    for (int k = 0; k < POSITIONS; k++) {
+        TEST_ASSERT_TRUE(ring.isValid(k));
+        TEST_ASSERT_EQUAL_INT(PUSHED - k, ring.at(k));
+    }
+}
+
+void test_positions_past_configured_count_read_empty() {
+    // 槽位 POSITIONS..CAPACITY-1 里仍保存着更早的托盘，但超出配置的位置数，不可读
+    Ring ring;
+    pushSequence(ring, 1, (int)Ring::CAPACITY);
+    TEST_ASSERT_TRUE(ring.isValid(POSITIONS - 1));
+    for (int k = POSITIONS; k < (int)Ring::CAPACITY + 2; k++) {
+        TEST_ASSERT_FALSE(ring.isValid(k));
+        TEST_ASSERT_EQUAL_INT(0, ring.at(k));
+        TEST_ASSERT_NULL(ring.find(k));
+    }
+}
+
+void test_reset_hides_older_trays() {
+    Ring ring;
+    pushSequence(ring, 1, 6);
+    uint32_t head = ring.getHead();
+    ring.reset();
+    // reset() 只移动有效起点：序号与槽位内容不变，但全部位置读作空
+    TEST_ASSERT_EQUAL_UINT32(head, ring.getHead());
+    for (int k = 0; k < POSITIONS; k++) {
+        TEST_ASSERT_FALSE(ring.isValid(k));
+        TEST_ASSERT_EQUAL_INT(0, ring.at(k));
+    }
+
+    // reset() 之后推入的托盘可见，更早的仍为空
+    pushSequence(ring, 50, 2);
+    TEST_ASSERT_EQUAL_INT(51, ring.at(0));
+    TEST_ASSERT_EQUAL_INT(50, ring.at(1));
+    TEST_ASSERT_FALSE(ring.isValid(2));
+    TEST_ASSERT_EQUAL_INT(0, ring.at(2));
+
+    // 推满之后与未 reset 时一致
+    pushSequence(ring, 52, POSITIONS);
+    for (int k = 0; k < POSITIONS; k++) TEST_ASSERT_EQUAL_INT(52 + POSITIONS - 1 - k, ring.at(k));
+}
+
+void test_sequence_numbers() {
+    Ring ring;
+    pushSequence(ring, 1, 11);
+    // 第一个托盘序号为 0；位置 k 的序号为 head - 1 - k
+    TEST_ASSERT_EQUAL_UINT32(10, ring.sequenceAt(0));
+    TEST_ASSERT_EQUAL_UINT32(7, ring.sequenceAt(3));
+    for (int k = 0; k < POSITIONS; k++) {
+        // 推入的值为序号 + 1
+        TEST_ASSERT_EQUAL_INT((int)ring.sequenceAt(k) + 1, ring.at(k));
+    }
+    // 托盘随传送带前进一个位置，序号不变
+    uint32_t seq = ring.sequenceAt(2);
+    ring.push(12);
+    TEST_ASSERT_EQUAL_UINT32(seq, ring.sequenceAt(3));
+}
+
+void test_find_modifies_in_place() {
+    Ring ring;
+    pushSequence(ring, 1, 4);
+    int* record = ring.find(2);
+    TEST_ASSERT_NOT_NULL(record);
+    *record = 99;
+    TEST_ASSERT_EQUAL_INT(99, ring.at(2));
+
+    // 修改随托盘一起前进
+    ring.push(5);
+    TEST_ASSERT_EQUAL_INT(99, ring.at(3));
+    TEST_ASSERT_NULL(ring.find(-1));
+    TEST_ASSERT_NULL(ring.find(POSITIONS));
+
+    ring.reset();
+    TEST_ASSERT_NULL(ring.find(0));
+}
+
+void test_copy_positions() {
+    Ring ring;
+    pushSequence(ring, 1, 3);
+    int out[POSITIONS] = {-1, -1, -1, -1, -1};
+    ring.copyPositions(out, POSITIONS);
+    int expected[POSITIONS] = {3, 2, 1, 0, 0};
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, out, POSITIONS);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_capacity_is_next_power_of_two);
+    RUN_TEST(test_empty_ring_reads_default_records);
+    RUN_TEST(test_positions_fill_from_scan_position);
+    RUN_TEST(test_wraparound_past_capacity);
+    RUN_TEST(test_positions_past_configured_count_read_empty);
+    RUN_TEST(test_reset_hides_older_trays);
+    RUN_TEST(test_sequence_numbers);
+    RUN_TEST(test_find_modifies_in_place);
+    RUN_TEST(test_copy_positions);
+    return UNITY_END();
+}
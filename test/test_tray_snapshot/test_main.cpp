@@ -0,0 +1,261 @@
+// 托盘快照顺序锁：在读取体中按脚本插入写入方的步骤（推入托盘、就地改写、写入开始/结束），
+// 确定性地复现读取被写入打断（前后序号不同）与读取开始时写入进行中（序号为奇数）两种重试分支，
+// 检查重试次数与最终快照来自同一次写入；再检查 TraySystem::getSnapshot 与逐个位置读取一致
+
+#include <Arduino.h>
+#include <unity.h>
+#include <native_hal.h>
+#include <stdint.h>
+#include "modular/seq_lock.h"
+#include "modular/tray_system.h"
+
+namespace {
+
+typedef TrayRing<TrayRecord, TRAY_QUEUE_POSITIONS> Ring;
+
+// 写入方的一步，在读取体拷贝完第 atPosition 个位置后执行
+enum WriterStep {
+    STEP_NONE = 0,
+    STEP_PUSH,          // 完整的一次写入：推入新托盘
+    STEP_REWRITE,       // 完整的一次写入：就地改写位置 0 的目标出口
+    STEP_BEGIN_PUSH,    // 写入开始并推入，尚未结束（序号为奇数）
+    STEP_END            // 结束进行中的写入
+};
+
+struct ScriptedStep {
+    int attempt;        // 第几次读取（从 0 开始）
+    int atPosition;
+    WriterStep step;
+};
+
+struct Fixture {
+    Ring ring;
+    SeqLock lock;
+    uint16_t nextDiameter;
+
+    Fixture() : nextDiameter(100) {}
+
+    TrayRecord makeTray() {
+        return TraySystem::makeRecord(nextDiameter++, 1, LEN_M, 90, 0);
+    }
+
+    void push() {
+        lock.beginWrite();
+        ring.push(makeTray());
+        lock.endWrite();
+    }
+
+    void run(WriterStep step) {
+        switch (step) {
+            case STEP_PUSH:
+                push();
+                break;
+            case STEP_REWRITE:
+                lock.beginWrite();
+                ring.find(0)->outlet = 3;
+                ring.find(0)->flags |= TRAY_FLAG_OVERRIDDEN;
+                lock.endWrite();
+                break;
+            case STEP_BEGIN_PUSH:
+                lock.beginWrite();
+                ring.push(makeTray());
+                break;
+            case STEP_END:
+                lock.endWrite();
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+struct ReadResult {
+    uint32_t retries;
+    int attempts;
+    bool sawTornCopy;   // 某次被拒绝的读取确实拷贝到了不一致的数据
+};
+
+// 快照与读取结束后的队列完全一致
+bool isConsistent(const Ring& ring, const TraySnapshot& snapshot) {
+    for (int k = 0; k < TRAY_QUEUE_POSITIONS; k++) {
+        if (ring.at(k).diameterDeciMm != snapshot.records[k].diameterDeciMm) return false;
+        if (ring.at(k).outlet != snapshot.records[k].outlet) return false;
+    }
+    return snapshot.headSequence == ring.getHead();
+}
+
+// 快照内部自洽：相邻位置的直径连续递减（推入时直径逐个加一）
+bool isSelfConsistent(const TraySnapshot& snapshot) {
+    for (int k = 1; k < TRAY_QUEUE_POSITIONS; k++) {
+        const TrayRecord& newer = snapshot.records[k - 1];
+        const TrayRecord& older = snapshot.records[k];
+        if (older.occupied && newer.diameterDeciMm != older.diameterDeciMm + 1) return false;
+    }
+    return true;
+}
+
+// 与 TraySystem::getSnapshot 相同的读取体，逐个位置拷贝，按脚本在位置之间插入写入方的步骤
+ReadResult scriptedSnapshot(Fixture& f, TraySnapshot& out, const ScriptedStep* script, int scriptLength) {
+    ReadResult result = {0, 0, false};
+    result.retries = f.lock.read([&]() {
+        for (int k = 0; k < TRAY_QUEUE_POSITIONS; k++) {
+            out.records[k] = f.ring.at(k);
+            for (int s = 0; s < scriptLength; s++) {
+                if (script[s].attempt == result.attempts && script[s].atPosition == k) f.run(script[s].step);
+            }
+        }
+        out.headSequence = f.ring.getHead();
+        if (!isSelfConsistent(out)) result.sawTornCopy = true;
+        result.attempts++;
+    });
+    return result;
+}
+
+void fill(Fixture& f, int count) {
+    for (int n = 0; n < count; n++) f.push();
+}
+
+} // namespace
+
+void setUp() {
+    NativeHal::setSerialEcho(false);
+}
+
+void tearDown() {}
+
+void test_uncontended_read_does_not_retry() {
+    Fixture f;
+    fill(f, TRAY_QUEUE_POSITIONS);
+    TraySnapshot snapshot;
+    ReadResult r = scriptedSnapshot(f, snapshot, nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, r.retries);
+    TEST_ASSERT_EQUAL_INT(1, r.attempts);
+    TEST_ASSERT_TRUE(isConsistent(f.ring, snapshot));
+    TEST_ASSERT_EQUAL_UINT32(2 * TRAY_QUEUE_POSITIONS, f.lock.getSequence());
+}
+
+void test_torn_read_is_retried() {
+    // 读取拷贝到一半时写入方推入新托盘：前半取自旧队列、后半取自已后移的新队列
+    Fixture f;
+    fill(f, TRAY_QUEUE_POSITIONS + 3);
+    const ScriptedStep script[] = {{0, TRAY_QUEUE_POSITIONS / 2, STEP_PUSH}};
+    TraySnapshot snapshot;
+    ReadResult r = scriptedSnapshot(f, snapshot, script, 1);
+
+    TEST_ASSERT_TRUE(r.sawTornCopy);
+    TEST_ASSERT_EQUAL_UINT32(1, r.retries);
+    TEST_ASSERT_EQUAL_INT(2, r.attempts);
+    TEST_ASSERT_TRUE(isConsistent(f.ring, snapshot));
+    TEST_ASSERT_TRUE(isSelfConsistent(snapshot));
+}
+
+void test_in_place_rewrite_is_retried() {
+    // 就地改写已读过的位置 0：拷贝中的记录过时，序号变化使本次读取作废
+    Fixture f;
+    fill(f, 4);
+    const ScriptedStep script[] = {{0, 2, STEP_REWRITE}};
+    TraySnapshot snapshot;
+    ReadResult r = scriptedSnapshot(f, snapshot, script, 1);
+
+    TEST_ASSERT_EQUAL_UINT32(1, r.retries);
+    TEST_ASSERT_EQUAL_UINT8(3, snapshot.records[0].outlet);
+    TEST_ASSERT_TRUE(snapshot.records[0].flags & TRAY_FLAG_OVERRIDDEN);
+    TEST_ASSERT_TRUE(isConsistent(f.ring, snapshot));
+}
+
+void test_read_during_write_in_progress_is_retried() {
+    // 读取开始时写入方已推入但尚未结束（序号为奇数）：即使拷贝到的数据恰好自洽也必须重试
+    Fixture f;
+    fill(f, 6);
+    f.run(STEP_BEGIN_PUSH);
+    TEST_ASSERT_TRUE(f.lock.getSequence() & 1);
+
+    const ScriptedStep script[] = {{0, 0, STEP_END}};
+    TraySnapshot snapshot;
+    ReadResult r = scriptedSnapshot(f, snapshot, script, 1);
+
+    TEST_ASSERT_EQUAL_UINT32(1, r.retries);
+    TEST_ASSERT_EQUAL_UINT32(7, snapshot.headSequence);
+    TEST_ASSERT_TRUE(isConsistent(f.ring, snapshot));
+}
+
+void test_write_spanning_two_attempts() {
+    // 第 1 次读取中途写入开始（结束序号为奇数），第 2 次读取以奇数序号开始、中途写入结束，第 3 次读取成功
+    Fixture f;
+    fill(f, TRAY_QUEUE_POSITIONS);
+    const ScriptedStep script[] = {
+        {0, 3, STEP_BEGIN_PUSH},
+        {1, 8, STEP_END}
+    };
+    TraySnapshot snapshot;
+    ReadResult r = scriptedSnapshot(f, snapshot, script, 2);
+
+    TEST_ASSERT_EQUAL_UINT32(2, r.retries);
+    TEST_ASSERT_EQUAL_INT(3, r.attempts);
+    TEST_ASSERT_TRUE(r.sawTornCopy);
+    TEST_ASSERT_TRUE(isConsistent(f.ring, snapshot));
+    TEST_ASSERT_FALSE(f.lock.getSequence() & 1);
+}
+
+void test_repeated_writers_until_quiet() {
+    // 每次读取都被一次完整写入打断，写入方停止后读取成功；最终快照为最后一次写入后的状态
+    Fixture f;
+    fill(f, 2);
+    const ScriptedStep script[] = {
+        {0, 0, STEP_PUSH},
+        {1, TRAY_QUEUE_POSITIONS - 1, STEP_PUSH},
+        {2, 1, STEP_REWRITE},
+        {3, 5, STEP_PUSH}
+    };
+    TraySnapshot snapshot;
+    ReadResult r = scriptedSnapshot(f, snapshot, script, 4);
+
+    TEST_ASSERT_EQUAL_UINT32(4, r.retries);
+    TEST_ASSERT_EQUAL_UINT32(5, snapshot.headSequence);
+    TEST_ASSERT_TRUE(isConsistent(f.ring, snapshot));
+}
+
+void test_tray_system_snapshot_matches_positions() {
+    TraySystem* traySystem = TraySystem::getInstance();
+    traySystem->resetAllTraysData();
+
+    uint32_t head0 = traySystem->getTraySequence(0) + 1;
+    for (int n = 0; n < TRAY_QUEUE_POSITIONS + 5; n++) {
+        TrayRecord record = TraySystem::makeRecord(200 + n, 1 + (n % 3), LEN_S, 80, 0);
+        record.outlet = (uint8_t)(n % NUM_OUTLETS);
+        traySystem->pushTray(record);
+    }
+    TEST_ASSERT_TRUE(traySystem->setTrayOutlet(2, TRAY_NO_OUTLET));
+
+    TraySnapshot snapshot;
+    traySystem->getSnapshot(snapshot);
+    TEST_ASSERT_EQUAL_UINT32(head0 + TRAY_QUEUE_POSITIONS + 5, snapshot.headSequence);
+    for (int k = 0; k < TRAY_QUEUE_POSITIONS; k++) {
+        TrayRecord tray = traySystem->getTray(k);
+        TEST_ASSERT_EQUAL_UINT16(tray.diameterDeciMm, snapshot.records[k].diameterDeciMm);
+        TEST_ASSERT_EQUAL_UINT8(tray.outlet, snapshot.records[k].outlet);
+        TEST_ASSERT_EQUAL_UINT8(tray.flags, snapshot.records[k].flags);
+        TEST_ASSERT_EQUAL_UINT32(snapshot.headSequence - 1 - k, traySystem->getTraySequence(k));
+    }
+    TEST_ASSERT_EQUAL_UINT16(200 + TRAY_QUEUE_POSITIONS + 4, snapshot.records[0].diameterDeciMm);
+    TEST_ASSERT_EQUAL_UINT8(TRAY_NO_OUTLET, snapshot.records[2].outlet);
+    TEST_ASSERT_TRUE(snapshot.records[2].flags & TRAY_FLAG_OVERRIDDEN);
+
+    // 重置后快照全为空托盘，序号继续递增
+    traySystem->resetAllTraysData();
+    traySystem->getSnapshot(snapshot);
+    for (int k = 0; k < TRAY_QUEUE_POSITIONS; k++) TEST_ASSERT_FALSE(snapshot.records[k].occupied);
+    TEST_ASSERT_EQUAL_UINT32(head0 + TRAY_QUEUE_POSITIONS + 5, snapshot.headSequence);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_uncontended_read_does_not_retry);
+    RUN_TEST(test_torn_read_is_retried);
+    RUN_TEST(test_in_place_rewrite_is_retried);
+    RUN_TEST(test_read_during_write_in_progress_is_retried);
+    RUN_TEST(test_write_spanning_two_attempts);
+    RUN_TEST(test_repeated_writers_until_quiet);
+    RUN_TEST(test_tray_system_snapshot_matches_positions);
+    return UNITY_END();
+}